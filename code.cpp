@@ -1,5 +1,6 @@
 #include <iostream>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <memory>
 #include <exception>
@@ -9,23 +10,594 @@
 #include <thread>
 #include <unordered_map>
 #include <iomanip>
+#include <algorithm>
+#include <cstdint>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <ctime>
+#include <queue>
+#include <random>
+#include <cstdlib>
+#include <type_traits>
+#include <new>
+#include <deque>
+#include <list>
+#include <map>
+#include <cmath>
+#include <limits>
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#include <x86intrin.h>
+#endif
+#include <functional>
+#include <future>
+#include <optional>
+#include <cstring>
+#include <iterator>
+#include <stdexcept>
+#include <cstdio>
+#include <filesystem>
+#include <charconv>
+#if defined(__cpp_impl_coroutine)
+#include <coroutine>
+#endif
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <netdb.h>
+#include <arpa/inet.h>
+#include <poll.h>
+#include <cerrno>
+#endif
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+// Time source for RentalManager and Logger. Production uses SystemClock; tests
+// and replays use SimulatedClock, which only moves when advanced, so late
+// returns can be exercised without sleeping.
+class Clock {
+public:
+    using time_point = std::chrono::system_clock::time_point;
+    using duration = std::chrono::system_clock::duration;
+    virtual ~Clock() = default;
+    virtual time_point now() const = 0;
+};
+
+class SystemClock final : public Clock {
+public:
+    time_point now() const override { return std::chrono::system_clock::now(); }
+
+    static SystemClock& instance() {
+        static SystemClock clock;
+        return clock;
+    }
+};
+
+// manually advanced clock; safe to read from other threads while advancing
+class SimulatedClock final : public Clock {
+    std::atomic<duration::rep> ticks;
+public:
+    explicit SimulatedClock(time_point start = time_point()) : ticks(start.time_since_epoch().count()) {}
+
+    time_point now() const override { return time_point(duration(ticks.load(std::memory_order_acquire))); }
+
+    void advance(duration d) { ticks.fetch_add(d.count(), std::memory_order_acq_rel); }
+    void advanceDays(int days) { advance(std::chrono::hours(24LL * days)); }
+    void set(time_point t) { ticks.store(t.time_since_epoch().count(), std::memory_order_release); }
+};
+
+// thread-safe replacement for std::localtime
+inline std::tm toLocalTime(std::time_t t) {
+    std::tm tm{};
+#ifdef _WIN32
+    localtime_s(&tm, &t);
+#else
+    localtime_r(&t, &tm);
+#endif
+    return tm;
+}
+
+// what an async Logger does when its queue is full
+enum class OverflowPolicy {
+    Block,      // caller waits until the writer frees a slot
+    Drop,       // message is discarded silently
+    CountDrops  // message is discarded and a "dropped N" line is written later
+};
+
+// File format of a Logger. Text writes "[timestamp] message" lines; Binary
+// writes LogRecords that call sites fill with typed fields instead of
+// formatting a message, decoded back to the text lines offline.
+enum class LogFormat { Text, Binary };
+
+// what a binary log record describes; free-form messages are Text
+enum class LogEvent : std::uint8_t { Text, Rent, Return, MinorDamage, Charge, Failure, ChargeRequest };
+constexpr std::size_t kLogEvents = static_cast<std::size_t>(LogEvent::ChargeRequest) + 1;
+
+inline const char* toString(LogEvent e) {
+    switch (e) {
+    case LogEvent::Text: return "text";
+    case LogEvent::Rent: return "rent";
+    case LogEvent::Return: return "return";
+    case LogEvent::MinorDamage: return "minor_damage";
+    case LogEvent::Charge: return "charge";
+    case LogEvent::Failure: return "failure";
+    case LogEvent::ChargeRequest: return "charge_request";
+    }
+    return "unknown";
+}
+
+// Binary log file: a LogFileHeader, then records, each a LogRecord followed
+// by textBytes of text (the member id, or the message of a Text record).
+// Fields are native-endian; byteOrder tells a reader on another machine.
+struct LogFileHeader {
+    char magic[8]; // "RNTLBLOG"
+    std::uint32_t version;
+    std::uint32_t byteOrder;
+};
+
+constexpr std::uint32_t kLogVersion = 1;
+constexpr std::uint32_t kLogByteOrder = 0x01020304u; // same marker as snapshots and journals
+
+struct LogRecord {
+    std::int64_t whenNs = 0;   // system_clock, nanoseconds since the epoch; set by the Logger
+    LogEvent event = LogEvent::Text;
+    std::uint8_t op = 0;       // RentalOp of a Failure
+    std::uint8_t status = 0;   // RentalStatus of a Failure
+    std::uint8_t flags = 0;    // kLogMinorDamage
+    std::uint32_t textBytes = 0;
+    std::int32_t vehicleId = 0;
+    std::int32_t days = 0;
+    double cost = 0.0;
+    double baseCost = 0.0;
+    double penalty = 0.0;
+    double amount = 0.0;       // requested load (Rent, Overload) or kWh (Charge)
+    double level = 0.0;        // truck limit (Overload) or charge after charging (Charge)
+};
+
+constexpr std::uint8_t kLogMinorDamage = 1;
+
+static_assert(sizeof(LogFileHeader) == 16 && sizeof(LogRecord) == 64, "binary log layout");
+
+struct LoggerOptions {
+    bool async = false;
+    std::size_t queueCapacity = 8192;              // rounded up to a power of two
+    std::size_t batchSize = 512;                   // records written per flush at most
+    std::chrono::milliseconds flushInterval{50};   // max delay before queued records hit disk
+    OverflowPolicy overflow = OverflowPolicy::Block;
+    const Clock *clock = nullptr;                  // timestamp source; nullptr = SystemClock
+    bool discard = false;                          // open no file; log() does nothing (simulations, benchmarks)
+    LogFormat format = LogFormat::Text;
+
+    static LoggerOptions asyncMode() {
+        LoggerOptions o;
+        o.async = true;
+        return o;
+    }
+
+    // async, structured: log records are copied, never formatted
+    static LoggerOptions binaryMode() {
+        LoggerOptions o = asyncMode();
+        o.format = LogFormat::Binary;
+        return o;
+    }
+
+    static LoggerOptions disabled() {
+        LoggerOptions o;
+        o.discard = true;
+        return o;
+    }
+};
+
+// Bounded multi-producer ring (Vyukov style): each cell carries a sequence
+// number telling producers and the consumer whose turn it is, so push/pop
+// are a CAS on the ticket plus one release store, without any mutex.
+template <class T>
+class BoundedRing {
+    struct Cell {
+        std::atomic<std::size_t> seq;
+        T value;
+    };
+    std::unique_ptr<Cell[]> cells;
+    std::size_t mask;
+    alignas(64) std::atomic<std::size_t> head{0}; // next push ticket
+    alignas(64) std::atomic<std::size_t> tail{0}; // next pop ticket
+
+public:
+    explicit BoundedRing(std::size_t capacity) {
+        std::size_t cap = 2;
+        while (cap < capacity) cap <<= 1;
+        cells.reset(new Cell[cap]);
+        mask = cap - 1;
+        for (std::size_t i = 0; i < cap; ++i) cells[i].seq.store(i, std::memory_order_relaxed);
+    }
+
+    bool tryPush(T &&v) {
+        std::size_t pos = head.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell &c = cells[pos & mask];
+            std::size_t seq = c.seq.load(std::memory_order_acquire);
+            auto diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos);
+            if (diff == 0) {
+                if (head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    c.value = std::move(v);
+                    c.seq.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false; // full
+            } else {
+                pos = head.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    bool tryPop(T &out) {
+        std::size_t pos = tail.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell &c = cells[pos & mask];
+            std::size_t seq = c.seq.load(std::memory_order_acquire);
+            auto diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos + 1);
+            if (diff == 0) {
+                if (tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    out = std::move(c.value);
+                    c.seq.store(pos + mask + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false; // empty
+            } else {
+                pos = tail.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    bool empty() const {
+        return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire);
+    }
+};
+
+// Unbounded intrusive multi-producer single-consumer queue (Vyukov style):
+// push is one exchange on the head plus a release store, so producers never
+// wait on each other; only the consumer thread may call pop() and empty().
+// Nodes derive from MpscNode and are owned by whoever popped them.
+struct MpscNode {
+    std::atomic<MpscNode*> next{nullptr};
+};
+
+template <class Node>
+class MpscQueue {
+    static_assert(std::is_base_of<MpscNode, Node>::value, "queue nodes must derive from MpscNode");
+    alignas(64) std::atomic<MpscNode*> head; // last pushed, producers
+    alignas(64) MpscNode *tail;              // next to pop, consumer only
+    MpscNode stub;
+
+    void pushNode(MpscNode *n) {
+        n->next.store(nullptr, std::memory_order_relaxed);
+        MpscNode *prev = head.exchange(n, std::memory_order_seq_cst);
+        prev->next.store(n, std::memory_order_release);
+    }
+
+public:
+    MpscQueue() : head(&stub), tail(&stub) {}
+    MpscQueue(const MpscQueue&) = delete;
+    MpscQueue& operator=(const MpscQueue&) = delete;
+
+    void push(Node *n) { pushNode(n); }
+
+    // nullptr when empty or when the next producer is between its two steps
+    Node* pop() {
+        MpscNode *t = tail;
+        MpscNode *next = t->next.load(std::memory_order_acquire);
+        if (t == &stub) {
+            if (!next) return nullptr;
+            tail = next;
+            t = next;
+            next = next->next.load(std::memory_order_acquire);
+        }
+        if (next) {
+            tail = next;
+            return static_cast<Node*>(t);
+        }
+        if (t != head.load(std::memory_order_acquire)) return nullptr;
+        pushNode(&stub); // t is the last node: park the stub behind it so t can leave
+        next = t->next.load(std::memory_order_acquire);
+        if (!next) return nullptr;
+        tail = next;
+        return static_cast<Node*>(t);
+    }
+
+    // consumer side, after pop() returned nullptr: false means a push is in flight
+    bool empty() const { return head.load(std::memory_order_seq_cst) == tail; }
+};
+
+// "%F %T" local time of a log line; keeps the last second formatted, since
+// records mostly share it
+class LogStamp {
+    std::time_t cachedSecond = -1;
+    char cachedStamp[32] = {0};
+
+public:
+    const char* operator()(std::chrono::system_clock::time_point when) {
+        std::time_t t = std::chrono::system_clock::to_time_t(when);
+        if (t != cachedSecond) {
+            std::tm tm = toLocalTime(t);
+            std::strftime(cachedStamp, sizeof(cachedStamp), "%F %T", &tm);
+            cachedSecond = t;
+        }
+        return cachedStamp;
+    }
+};
+
+// Text log lines for one message; a multi-line message (batch calls) gets the
+// timestamp on every line
+inline void appendLogLines(std::string &out, const char *stamp, std::string_view msg) {
+    std::size_t pos = 0;
+    for (;;) {
+        std::size_t nl = msg.find('\n', pos);
+        out += '[';
+        out += stamp;
+        out += "] ";
+        out.append(msg.substr(pos, nl == std::string_view::npos ? std::string_view::npos : nl - pos));
+        out += '\n';
+        if (nl == std::string_view::npos) break;
+        pos = nl + 1;
+    }
+}
 
 class Logger {
+    struct Record {
+        std::chrono::system_clock::time_point when;
+        std::string msg;  // the message, or a binary record's text
+        LogRecord fields; // binary format only
+    };
+
     std::ofstream ofs;
+    LoggerOptions opts;
+    const Clock *clock;
+    std::mutex syncMutex; // serializes writers in sync mode
+    std::string syncRecord; // binary sync mode: encoded record, reused
+
+    // async mode state
+    std::unique_ptr<BoundedRing<Record>> queue;
+    std::thread writer;
+    std::atomic<bool> stopping{false};
+    std::atomic<bool> writerIdle{false};
+    std::mutex wakeMutex;
+    std::condition_variable wake;
+    std::atomic<std::uint64_t> dropped{0};
+    std::uint64_t droppedReported = 0;
+
+    LogStamp stamp;
+
+    static void appendBinary(std::string &out, std::chrono::system_clock::time_point when, LogRecord fields,
+                             std::string_view text) {
+        fields.whenNs = std::chrono::duration_cast<std::chrono::nanoseconds>(when.time_since_epoch()).count();
+        fields.textBytes = static_cast<std::uint32_t>(text.size());
+        out.append(reinterpret_cast<const char*>(&fields), sizeof(fields));
+        out.append(text.data(), text.size());
+    }
+
+    void append(std::string &out, const Record &r) {
+        if (opts.format == LogFormat::Binary) appendBinary(out, r.when, r.fields, r.msg);
+        else appendLogLines(out, stamp(r.when), r.msg);
+    }
+
+    void flushBatch(std::string &batch) {
+        ofs.write(batch.data(), static_cast<std::streamsize>(batch.size()));
+        ofs.flush();
+        batch.clear();
+    }
+
+    void writerLoop() {
+        std::string batch;
+        std::size_t pending = 0; // records in batch not yet on disk
+        Record r;
+        auto lastFlush = std::chrono::steady_clock::now();
+        for (;;) {
+            std::size_t n = 0;
+            while (pending < opts.batchSize && queue->tryPop(r)) {
+                append(batch, r);
+                ++pending;
+                ++n;
+            }
+            std::uint64_t d = dropped.load(std::memory_order_relaxed);
+            if (opts.overflow == OverflowPolicy::CountDrops && d != droppedReported) {
+                append(batch, Record{clock->now(),
+                                     "Logger dropped " + std::to_string(d - droppedReported) + " messages (queue full)",
+                                     LogRecord()});
+                droppedReported = d;
+                ++pending;
+            }
+            bool done = n == 0 && stopping.load(std::memory_order_acquire) && queue->empty();
+            auto now = std::chrono::steady_clock::now();
+            if (pending > 0 && (pending >= opts.batchSize || now - lastFlush >= opts.flushInterval || done)) {
+                flushBatch(batch);
+                pending = 0;
+                lastFlush = now;
+            }
+            if (done) break;
+            if (n == 0) {
+                // nothing queued: sleep until a producer wakes us or the next flush is due
+                auto wait = opts.flushInterval;
+                if (pending > 0) {
+                    wait = std::chrono::duration_cast<std::chrono::milliseconds>(opts.flushInterval - (now - lastFlush));
+                    if (wait.count() <= 0) wait = std::chrono::milliseconds(1);
+                }
+                std::unique_lock<std::mutex> lk(wakeMutex);
+                writerIdle.store(true, std::memory_order_seq_cst);
+                if (queue->empty() && !stopping.load(std::memory_order_acquire)) {
+                    wake.wait_for(lk, wait);
+                }
+                writerIdle.store(false, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    void wakeWriter() {
+        if (writerIdle.load(std::memory_order_seq_cst)) {
+            std::lock_guard<std::mutex> lk(wakeMutex);
+            wake.notify_one();
+        }
+    }
+
+    void enqueue(Record &&r) {
+        if (queue->tryPush(std::move(r))) {
+            wakeWriter();
+            return;
+        }
+        if (opts.overflow != OverflowPolicy::Block) {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        do {
+            wakeWriter();
+            std::this_thread::yield();
+        } while (!queue->tryPush(std::move(r)));
+        wakeWriter();
+    }
+
+    void writeSync(std::chrono::system_clock::time_point when, const LogRecord &fields, std::string_view msg) {
+        std::lock_guard<std::mutex> lk(syncMutex);
+        if (opts.format == LogFormat::Binary) {
+            syncRecord.clear();
+            appendBinary(syncRecord, when, fields, msg);
+            ofs.write(syncRecord.data(), static_cast<std::streamsize>(syncRecord.size()));
+            ofs.flush();
+            return;
+        }
+        if (msg.find('\n') == std::string_view::npos) {
+            ofs << "[" << stamp(when) << "] " << msg << std::endl;
+            return;
+        }
+        std::string lines;
+        appendLogLines(lines, stamp(when), msg);
+        ofs << lines << std::flush;
+    }
+
+    static LogFileHeader binaryHeader() {
+        LogFileHeader h{};
+        std::memcpy(h.magic, "RNTLBLOG", sizeof(h.magic));
+        h.version = kLogVersion;
+        h.byteOrder = kLogByteOrder;
+        return h;
+    }
+
+    // Checks an existing binary log before appending to it: it must be a
+    // binary log of this version and byte order, and a record cut off by a
+    // crash is truncated away so new sessions follow the last whole record
+    // (BinaryLogReader stops at a torn one). A file shorter than the header
+    // is a header whose write was cut off and starts over. Returns whether
+    // the file needs a header.
+    static bool prepareBinaryFile(const std::string &filename) {
+        std::error_code ec;
+        const auto size = std::filesystem::file_size(filename, ec);
+        if (ec || size == 0) return true;
+        const LogFileHeader expected = binaryHeader();
+        LogFileHeader h{};
+        std::ifstream in(filename, std::ios::binary);
+        const std::size_t headBytes = static_cast<std::size_t>(std::min<std::uintmax_t>(size, sizeof(h)));
+        if (!in.read(reinterpret_cast<char*>(&h), static_cast<std::streamsize>(headBytes)) ||
+            std::memcmp(&h, &expected, headBytes) != 0) {
+            throw std::runtime_error("Log file " + filename + " is not a binary log of this version and byte order");
+        }
+        std::uintmax_t pos = headBytes;
+        if (size < sizeof(h)) {
+            pos = 0;
+        } else {
+            LogRecord r;
+            while (size - pos >= sizeof(r) && in.seekg(static_cast<std::streamoff>(pos)) &&
+                   in.read(reinterpret_cast<char*>(&r), sizeof(r)) && r.textBytes <= size - pos - sizeof(r)) {
+                pos += sizeof(r) + r.textBytes;
+            }
+        }
+        in.close();
+        if (pos < size) {
+            std::filesystem::resize_file(filename, pos, ec);
+            if (ec) throw std::runtime_error("Cannot truncate torn log file " + filename);
+        }
+        return pos == 0;
+    }
+
 public:
-    Logger(const std::string &filename = "rental_log.txt") {
-        ofs.open(filename, std::ios::app);
+    Logger(const std::string &filename = "rental_log.txt", const LoggerOptions &options = LoggerOptions())
+        : opts(options), clock(options.clock ? options.clock : &SystemClock::instance()) {
+        if (opts.discard) {
+            opts.async = false;
+            return;
+        }
+        std::ios::openmode mode = std::ios::app;
+        if (opts.format == LogFormat::Binary) mode |= std::ios::binary;
+        const bool newBinary = opts.format == LogFormat::Binary && prepareBinaryFile(filename);
+        ofs.open(filename, mode);
         if (!ofs.is_open()) {
             throw std::runtime_error("Cannot open log file");
         }
+        if (newBinary) {
+            const LogFileHeader h = binaryHeader();
+            ofs.write(reinterpret_cast<const char*>(&h), sizeof(h));
+            ofs.flush();
+        }
+        if (opts.batchSize == 0) opts.batchSize = 1;
+        if (opts.async) {
+            queue = std::make_unique<BoundedRing<Record>>(opts.queueCapacity);
+            writer = std::thread(&Logger::writerLoop, this);
+        }
     }
     ~Logger() {
+        if (writer.joinable()) {
+            // drain everything still queued before the file goes away
+            stopping.store(true, std::memory_order_release);
+            {
+                std::lock_guard<std::mutex> lk(wakeMutex);
+                wake.notify_one();
+            }
+            writer.join();
+        }
         if (ofs.is_open()) ofs.close(); // RAII: file closed in destructor
     }
+    Logger(const Logger&) = delete;
+    Logger& operator=(const Logger&) = delete;
+
+    // a binary log stores the message as a Text record
     void log(const std::string &msg) {
-        auto now = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
-        ofs << "[" << std::put_time(std::localtime(&now), "%F %T") << "] " << msg << std::endl;
+        if (opts.discard) return;
+        auto now = clock->now();
+        if (opts.async) enqueue(Record{now, msg, LogRecord()});
+        else writeSync(now, LogRecord(), msg);
+    }
+
+    void log(std::string &&msg) {
+        if (opts.discard) return;
+        auto now = clock->now();
+        if (opts.async) enqueue(Record{now, std::move(msg), LogRecord()});
+        else writeSync(now, LogRecord(), msg);
     }
+
+    // Typed record for a structured (binary) log: the fields are copied, the
+    // timestamp is taken here. Does nothing in a text log; callers check
+    // structured() and log the formatted line instead.
+    void logEvent(const LogRecord &fields, std::string_view text = std::string_view()) {
+        if (!structured()) return;
+        auto now = clock->now();
+        if (opts.async) enqueue(Record{now, std::string(text), fields});
+        else writeSync(now, fields, text);
+    }
+
+    bool isAsync() const { return opts.async; }
+    bool enabled() const { return !opts.discard; }
+    bool structured() const { return !opts.discard && opts.format == LogFormat::Binary; }
+    // messages discarded because the async queue was full
+    std::uint64_t droppedCount() const { return dropped.load(std::memory_order_relaxed); }
 };
 
 class VehicleException : public std::exception {
@@ -55,19 +627,162 @@ public:
     InvalidReturnException(const std::string &m): VehicleException(m) {}
 };
 
+// the partition owning the vehicle could not be reached (PartitionRouter);
+// says nothing about the vehicle itself, so the call may be retried
+class PartitionUnavailableException : public VehicleException {
+public:
+    PartitionUnavailableException(const std::string &m): VehicleException(m) {}
+};
+
+// Append helpers for the allocation-free info path. appendNumber(double)
+// produces the same text as an ostream at its default settings (general
+// format, precision 6, i.e. printf "%g"), so appendInfo and info() agree byte
+// for byte.
+inline void appendNumber(std::string &out, double value) {
+    char buf[32];
+    auto r = std::to_chars(buf, buf + sizeof(buf), value, std::chars_format::general, 6);
+    out.append(buf, r.ptr);
+}
+
+inline void appendNumber(std::string &out, int value) {
+    char buf[16];
+    auto r = std::to_chars(buf, buf + sizeof(buf), value);
+    out.append(buf, r.ptr);
+}
+
+// closed set of built-in vehicle kinds; lets hot paths dispatch with a switch
+// instead of dynamic_cast. Extension types derived from Vehicle report Other.
+enum class VehicleKind : std::uint8_t { Car, Truck, Electric, Other };
+
+// standard tariff, used by the rentCost overloads and as the TariffRates defaults
+constexpr double kTruckLoadFeePerKgDay = 0.10;
+constexpr double kEvLowChargeFraction = 0.2;
+constexpr double kEvLowChargeSurcharge = 50.0;
+constexpr double kLateFeePerDay = 20.0;
+constexpr double kMinorDamageFee = 100.0;
+constexpr double kEvStartChargeFraction = 0.1; // ElectricCar::start() needs this share of capacity
+
+// The rates a RentalManager prices with (see BasicRentalManager's Tariff).
+struct TariffRates {
+    double truckLoadFeePerKgDay = kTruckLoadFeePerKgDay;
+    double evLowChargeFraction = kEvLowChargeFraction;   // EVs rented below this share of capacity...
+    double evLowChargeSurcharge = kEvLowChargeSurcharge; // ...pay this flat surcharge
+    double lateFeePerDay = kLateFeePerDay;
+    double minorDamageFee = kMinorDamageFee;
+
+    // "key = value" lines with the field names as keys; '#' starts a comment
+    // and keys not given keep the standard rate. Throws std::runtime_error on
+    // an unknown key or a malformed value.
+    static TariffRates parse(std::istream &in, const std::string &name) {
+        TariffRates r;
+        std::string line;
+        for (int lineNo = 1; std::getline(in, line); ++lineNo) {
+            line = line.substr(0, line.find('#'));
+            std::size_t eq = line.find('=');
+            auto trim = [](std::string t) {
+                t.erase(0, t.find_first_not_of(" \t\r"));
+                t.erase(t.find_last_not_of(" \t\r") + 1);
+                return t;
+            };
+            if (trim(line).empty()) continue;
+            const std::string key = eq == std::string::npos ? trim(line) : trim(line.substr(0, eq));
+            const std::string text = eq == std::string::npos ? std::string() : trim(line.substr(eq + 1));
+            double value = 0.0;
+            auto res = std::from_chars(text.data(), text.data() + text.size(), value);
+            double *field = key == "truckLoadFeePerKgDay" ? &r.truckLoadFeePerKgDay
+                          : key == "evLowChargeFraction" ? &r.evLowChargeFraction
+                          : key == "evLowChargeSurcharge" ? &r.evLowChargeSurcharge
+                          : key == "lateFeePerDay" ? &r.lateFeePerDay
+                          : key == "minorDamageFee" ? &r.minorDamageFee
+                          : nullptr;
+            if (!field || text.empty() || res.ec != std::errc() || res.ptr != text.data() + text.size()) {
+                throw std::runtime_error("Tariff " + name + " line " + std::to_string(lineNo) + ": cannot parse '" + line + "'");
+            }
+            *field = value;
+        }
+        return r;
+    }
+
+    static TariffRates load(const std::string &path) {
+        std::ifstream in(path);
+        if (!in) throw std::runtime_error("Cannot open tariff " + path);
+        return parse(in, path);
+    }
+};
+
+// Tariff policies for BasicRentalManager<Tariff>: a type whose rates() gives
+// the TariffRates to price with. A fixed tariff returns them from a static
+// constexpr function, so every fee is a compile-time constant in the pricing
+// code; a regional one only overrides what differs:
+//   struct CityTariff {
+//       static constexpr TariffRates rates() { TariffRates r; r.lateFeePerDay = 35.0; return r; }
+//   };
+struct StandardTariff {
+    static constexpr TariffRates rates() { return TariffRates(); }
+};
+
+// Runtime-updatable rates for regions that change prices while running.
+// update() publishes a new version with one pointer store; earlier versions
+// are kept until the table is destroyed, so a price already being computed
+// never reads freed rates.
+class TariffTable {
+    std::mutex mutex;
+    std::deque<TariffRates> versions;
+    std::atomic<const TariffRates*> current;
+
+public:
+    explicit TariffTable(const TariffRates &initial = TariffRates()) : versions{initial}, current(&versions.back()) {}
+
+    TariffTable(const TariffTable&) = delete;
+    TariffTable& operator=(const TariffTable&) = delete;
+
+    void update(const TariffRates &rates) {
+        std::lock_guard<std::mutex> lk(mutex);
+        versions.push_back(rates);
+        current.store(&versions.back(), std::memory_order_release);
+    }
+
+    void reload(const std::string &path) { update(TariffRates::load(path)); }
+
+    const TariffRates& rates() const { return *current.load(std::memory_order_acquire); }
+};
+
+// policy reading a TariffTable the caller owns and keeps alive; no default
+// constructor, so a manager cannot be built without a table
+class RuntimeTariff {
+    const TariffTable *table;
+
+public:
+    explicit RuntimeTariff(const TariffTable &table_) : table(&table_) {}
+
+    const TariffRates& rates() const { return table->rates(); }
+};
+
 class Vehicle {
 protected:
     int id;
     std::string model;
     double dailyRate;
     bool isRented;
+    VehicleKind kind;
+private:
+    // only the built-in kinds may claim a kind other than Other: the manager
+    // static_casts on it
+    friend class Car;
+    friend class Truck;
+    friend class ElectricCar;
+    Vehicle(int id_, const std::string &model_, double dailyRate_, VehicleKind kind_)
+        : id(id_), model(model_), dailyRate(dailyRate_), isRented(false), kind(kind_) {}
 public:
+    // extension types: always VehicleKind::Other
     Vehicle(int id_, const std::string &model_, double dailyRate_)
-        : id(id_), model(model_), dailyRate(dailyRate_), isRented(false) {}
+        : Vehicle(id_, model_, dailyRate_, VehicleKind::Other) {}
 
     virtual ~Vehicle() = default;
 
     int getId() const { return id; }
+    VehicleKind getKind() const { return kind; }
+    double getDailyRate() const { return dailyRate; }
     std::string getModel() const { return model; }
     bool getIsRented() const { return isRented; }
     void setRented(bool r) { isRented = r; }
@@ -83,51 +798,71 @@ public:
     // clone pattern for copying polymorphic objects
     virtual std::unique_ptr<Vehicle> clone() const = 0;
 
+    // Appends the one-line description to a caller-owned buffer, so listing a
+    // fleet can reuse one buffer instead of building a stream per vehicle.
+    // Overrides call the base version first, then add their own fields.
+    virtual void appendInfo(std::string &out) const {
+        out += '[';
+        appendNumber(out, id);
+        out += "] ";
+        out += model;
+        out += " (rate ";
+        appendNumber(out, dailyRate);
+        out += ')';
+    }
+
+    // Extension types may override either one; the built-in kinds only
+    // override appendInfo.
     virtual std::string info() const {
-        std::ostringstream oss;
-        oss << "[" << id << "] " << model << " (rate " << dailyRate << ")";
-        return oss.str();
+        std::string out;
+        appendInfo(out);
+        return out;
     }
 };
 
 // Car
-class Car : public Vehicle {
+class Car final : public Vehicle {
     int passengerCapacity;
 public:
     Car(int id_, const std::string &model_, double dailyRate_, int cap)
-        : Vehicle(id_, model_, dailyRate_), passengerCapacity(cap) {}
+        : Vehicle(id_, model_, dailyRate_, VehicleKind::Car), passengerCapacity(cap) {}
 
     double rentCost(int days) const override {
         return dailyRate * days;
     }
 
+    int getPassengerCapacity() const { return passengerCapacity; }
+
     std::unique_ptr<Vehicle> clone() const override {
         return std::make_unique<Car>(*this);
     }
 
-    std::string info() const override {
-        std::ostringstream oss;
-        oss << Vehicle::info() << " Car cap=" << passengerCapacity;
-        return oss.str();
+    void appendInfo(std::string &out) const override {
+        Vehicle::appendInfo(out);
+        out += " Car cap=";
+        appendNumber(out, passengerCapacity);
     }
 };
 
 // Truck
-class Truck : public Vehicle {
+class Truck final : public Vehicle {
     double maxLoadKg;
 public:
     Truck(int id_, const std::string &model_, double dailyRate_, double maxLoadKg_)
-        : Vehicle(id_, model_, dailyRate_), maxLoadKg(maxLoadKg_) {}
+        : Vehicle(id_, model_, dailyRate_, VehicleKind::Truck), maxLoadKg(maxLoadKg_) {}
 
     double rentCost(int days) const override {
         // default without load
         return dailyRate * days;
     }
 
-    // overload: if carrying load, charge extra per kg (example)
-    double rentCost(int days, double loadKg) const {
+    // overload: if carrying load, charge extra per kg at the standard tariff
+    double rentCost(int days, double loadKg) const { return rentCost(days, loadKg, TariffRates()); }
+
+    // the same under another tariff's load fee
+    double rentCost(int days, double loadKg, const TariffRates &rates) const {
         double base = dailyRate * days;
-        double loadFeePerKg = 0.10; // simple model: 0.10 currency unit per kg per day
+        double loadFeePerKg = rates.truckLoadFeePerKgDay;
         return base + loadKg * loadFeePerKg * days;
     }
 
@@ -137,34 +872,43 @@ public:
         return std::make_unique<Truck>(*this);
     }
 
-    std::string info() const override {
-        std::ostringstream oss;
-        oss << Vehicle::info() << " Truck maxLoadKg=" << maxLoadKg;
-        return oss.str();
+    void appendInfo(std::string &out) const override {
+        Vehicle::appendInfo(out);
+        out += " Truck maxLoadKg=";
+        appendNumber(out, maxLoadKg);
     }
 };
 
 // ElectricCar
-class ElectricCar : public Vehicle {
+class ElectricCar final : public Vehicle {
     double batteryCapacityKwh;
     double currentChargeKwh;
 public:
     ElectricCar(int id_, const std::string &model_, double dailyRate_, double batteryCapacity, double currentCharge)
-        : Vehicle(id_, model_, dailyRate_), batteryCapacityKwh(batteryCapacity), currentChargeKwh(currentCharge) {}
+        : Vehicle(id_, model_, dailyRate_, VehicleKind::Electric),
+          batteryCapacityKwh(batteryCapacity), currentChargeKwh(currentCharge) {}
 
-    double rentCost(int days) const override {
+    double rentCost(int days) const override { return rentCost(days, TariffRates()); }
+
+    // the same under another tariff's low-charge rule
+    double rentCost(int days, const TariffRates &rates) const {
         double base = dailyRate * days;
-        double minChargeNeeded = 0.2 * batteryCapacityKwh; // example threshold
+        double minChargeNeeded = rates.evLowChargeFraction * batteryCapacityKwh; // example threshold
         double surcharge = 0.0;
         if (currentChargeKwh < minChargeNeeded) {
-            surcharge = 50.0; // flat surcharge if battery low when rented
+            surcharge = rates.evLowChargeSurcharge; // flat surcharge if battery low when rented
         }
         return base + surcharge;
     }
 
+    // non-throwing form of the start() check
+    bool canStart() const {
+        double minStartCharge = kEvStartChargeFraction * batteryCapacityKwh;
+        return currentChargeKwh >= minStartCharge;
+    }
+
     void start() override {
-        double minStartCharge = 0.1 * batteryCapacityKwh;
-        if (currentChargeKwh < minStartCharge) {
+        if (!canStart()) {
             throw BatteryLowException("Battery too low to start vehicle id=" + std::to_string(id));
         }
         // else start OK
@@ -176,210 +920,8127 @@ public:
     }
 
     double getCurrentCharge() const { return currentChargeKwh; }
+    double getBatteryCapacity() const { return batteryCapacityKwh; }
 
     std::unique_ptr<Vehicle> clone() const override {
         return std::make_unique<ElectricCar>(*this);
     }
 
-    std::string info() const override {
-        std::ostringstream oss;
-        oss << Vehicle::info() << " Electric battery=" << currentChargeKwh << "/" << batteryCapacityKwh;
-        return oss.str();
+    void appendInfo(std::string &out) const override {
+        Vehicle::appendInfo(out);
+        out += " Electric battery=";
+        appendNumber(out, currentChargeKwh);
+        out += '/';
+        appendNumber(out, batteryCapacityKwh);
     }
 };
 
-class RentalManager {
-    std::vector<std::unique_ptr<Vehicle>> fleet;
-    Logger &logger;
+// Rental cost with static dispatch on the kind tag. Car/Truck/ElectricCar are
+// final, so the casts below resolve rentCost without a virtual call; only
+// extension types go through the vtable. loadKg is used for trucks only.
+inline double rentalCost(const Vehicle &v, int days, double loadKg) {
+    switch (v.getKind()) {
+    case VehicleKind::Car:
+        return static_cast<const Car&>(v).rentCost(days);
+    case VehicleKind::Truck:
+        return static_cast<const Truck&>(v).rentCost(days, loadKg);
+    case VehicleKind::Electric:
+        return static_cast<const ElectricCar&>(v).rentCost(days);
+    default:
+        return v.rentCost(days);
+    }
+}
 
-    // rentals: vehicleId -> (memberId, dueDate)
-    struct RentalInfo {
-        std::string memberId;
-        std::chrono::system_clock::time_point dueDate;
-        double expectedLoadKg; // used if truck
-    };
-    std::unordered_map<int, RentalInfo> activeRentals;
+// rentalCost under a tariff; extension types keep their own rentCost
+inline double rentalCost(const Vehicle &v, int days, double loadKg, const TariffRates &rates) {
+    switch (v.getKind()) {
+    case VehicleKind::Car:
+        return static_cast<const Car&>(v).rentCost(days);
+    case VehicleKind::Truck:
+        return static_cast<const Truck&>(v).rentCost(days, loadKg, rates);
+    case VehicleKind::Electric:
+        return static_cast<const ElectricCar&>(v).rentCost(days, rates);
+    default:
+        return v.rentCost(days);
+    }
+}
 
-    // helper to find vehicle ptr by id
-    Vehicle* findVehicle(int vehicleId) {
-        for (auto &p : fleet) {
-            if (p->getId() == vehicleId) return p.get();
-        }
-        return nullptr;
+// Columnar quote input for priceBulk: entry i of every array describes one
+// (vehicle, days, load) combination and all arrays hold `count` entries.
+// loadKg only affects trucks and batteryCapacityKwh/chargeKwh only EVs, but
+// every array is read for every entry.
+struct PricingColumns {
+    std::size_t count = 0;
+    const VehicleKind *kind = nullptr;
+    const double *dailyRate = nullptr;
+    const std::int32_t *days = nullptr;
+    const double *loadKg = nullptr;
+    const double *batteryCapacityKwh = nullptr;
+    const double *chargeKwh = nullptr;
+};
+
+namespace pricing {
+
+// One entry, exactly as the scalar rentCost overloads compute it; NaN for
+// kind Other, whose rentCost has no columnar formula.
+inline double priceOne(const PricingColumns &in, std::size_t i, const TariffRates &rates) {
+    const double base = in.dailyRate[i] * in.days[i];
+    switch (in.kind[i]) {
+    case VehicleKind::Car:
+        return base;
+    case VehicleKind::Truck:
+        return base + in.loadKg[i] * rates.truckLoadFeePerKgDay * in.days[i];
+    case VehicleKind::Electric:
+        return base + (in.chargeKwh[i] < rates.evLowChargeFraction * in.batteryCapacityKwh[i] ? rates.evLowChargeSurcharge : 0.0);
+    default:
+        return std::numeric_limits<double>::quiet_NaN();
+    }
+}
+
+// The kernels below evaluate every formula in every lane and pick the kind's
+// result with masks. They perform the same IEEE operations in the same order
+// as priceOne (no reassociation, no FMA), so results are bit-identical.
+// Building with FMA enabled (-mfma, -march=native) lets the compiler contract
+// the scalar a*b+c; add -ffp-contract=off there to keep the guarantee.
+#if defined(__AVX2__)
+inline std::size_t priceAvx2(const PricingColumns &in, double *out, const TariffRates &rates) {
+    const __m256d fee = _mm256_set1_pd(rates.truckLoadFeePerKgDay);
+    const __m256d lowFraction = _mm256_set1_pd(rates.evLowChargeFraction);
+    const __m256d surcharge = _mm256_set1_pd(rates.evLowChargeSurcharge);
+    const __m256d nan = _mm256_set1_pd(std::numeric_limits<double>::quiet_NaN());
+    const __m256i truck = _mm256_set1_epi64x(static_cast<int>(VehicleKind::Truck));
+    const __m256i ev = _mm256_set1_epi64x(static_cast<int>(VehicleKind::Electric));
+    const __m256i other = _mm256_set1_epi64x(static_cast<int>(VehicleKind::Other));
+    std::size_t i = 0;
+    for (; i + 4 <= in.count; i += 4) {
+        std::int32_t kinds4;
+        std::memcpy(&kinds4, in.kind + i, sizeof(kinds4));
+        const __m256i kinds = _mm256_cvtepu8_epi64(_mm_cvtsi32_si128(kinds4));
+        const __m256d days = _mm256_cvtepi32_pd(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in.days + i)));
+        const __m256d base = _mm256_mul_pd(_mm256_loadu_pd(in.dailyRate + i), days);
+        const __m256d load = _mm256_loadu_pd(in.loadKg + i);
+        const __m256d truckCost = _mm256_add_pd(base, _mm256_mul_pd(_mm256_mul_pd(load, fee), days));
+        const __m256d threshold = _mm256_mul_pd(lowFraction, _mm256_loadu_pd(in.batteryCapacityKwh + i));
+        const __m256d low = _mm256_cmp_pd(_mm256_loadu_pd(in.chargeKwh + i), threshold, _CMP_LT_OQ);
+        const __m256d evCost = _mm256_add_pd(base, _mm256_and_pd(low, surcharge));
+        __m256d cost = _mm256_blendv_pd(base, truckCost, _mm256_castsi256_pd(_mm256_cmpeq_epi64(kinds, truck)));
+        cost = _mm256_blendv_pd(cost, evCost, _mm256_castsi256_pd(_mm256_cmpeq_epi64(kinds, ev)));
+        cost = _mm256_blendv_pd(cost, nan, _mm256_castsi256_pd(_mm256_cmpeq_epi64(kinds, other)));
+        _mm256_storeu_pd(out + i, cost);
     }
+    return i;
+}
+#endif
 
-    std::chrono::system_clock::time_point daysFromNow(int days) {
-        return std::chrono::system_clock::now() + std::chrono::hours(24LL * days);
+#if defined(__SSE2__)
+inline __m128d select(__m128d mask, __m128d yes, __m128d no) {
+    return _mm_or_pd(_mm_and_pd(mask, yes), _mm_andnot_pd(mask, no));
+}
+
+inline __m128d kindMask(const VehicleKind *kind, VehicleKind k) {
+    return _mm_castsi128_pd(_mm_set_epi64x(-static_cast<long long>(kind[1] == k), -static_cast<long long>(kind[0] == k)));
+}
+
+inline std::size_t priceSse2(const PricingColumns &in, double *out, std::size_t i, const TariffRates &rates) {
+    const __m128d fee = _mm_set1_pd(rates.truckLoadFeePerKgDay);
+    const __m128d lowFraction = _mm_set1_pd(rates.evLowChargeFraction);
+    const __m128d surcharge = _mm_set1_pd(rates.evLowChargeSurcharge);
+    const __m128d nan = _mm_set1_pd(std::numeric_limits<double>::quiet_NaN());
+    for (; i + 2 <= in.count; i += 2) {
+        const __m128d days = _mm_cvtepi32_pd(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(in.days + i)));
+        const __m128d base = _mm_mul_pd(_mm_loadu_pd(in.dailyRate + i), days);
+        const __m128d truckCost = _mm_add_pd(base, _mm_mul_pd(_mm_mul_pd(_mm_loadu_pd(in.loadKg + i), fee), days));
+        const __m128d threshold = _mm_mul_pd(lowFraction, _mm_loadu_pd(in.batteryCapacityKwh + i));
+        const __m128d low = _mm_cmplt_pd(_mm_loadu_pd(in.chargeKwh + i), threshold);
+        const __m128d evCost = _mm_add_pd(base, _mm_and_pd(low, surcharge));
+        __m128d cost = select(kindMask(in.kind + i, VehicleKind::Truck), truckCost, base);
+        cost = select(kindMask(in.kind + i, VehicleKind::Electric), evCost, cost);
+        cost = select(kindMask(in.kind + i, VehicleKind::Other), nan, cost);
+        _mm_storeu_pd(out + i, cost);
     }
+    return i;
+}
+#endif
+
+} // namespace pricing
+
+// Prices in.count quotes into out[0..count). Uses the widest kernel the build
+// targets (AVX2 with -mavx2, SSE2 on any x86-64), scalar for the tail and on
+// other architectures. Bit-exact with rentalCost()/rentCost for Car, Truck and
+// ElectricCar; kind Other yields NaN. `rates` selects the tariff.
+inline void priceBulk(const PricingColumns &in, double *out, const TariffRates &rates = TariffRates()) {
+    std::size_t i = 0;
+#if defined(__AVX2__)
+    i = pricing::priceAvx2(in, out, rates);
+#endif
+#if defined(__SSE2__)
+    i = pricing::priceSse2(in, out, i, rates);
+#endif
+    for (; i < in.count; ++i) out[i] = pricing::priceOne(in, i, rates);
+}
 
+// Struct-of-arrays view of a fleet: one contiguous column per hot field and
+// model names packed into a separate string pool. Slot i describes the same
+// vehicle in every column. Fleet-wide counts and sweeps read only the columns
+// they need instead of chasing a unique_ptr<Vehicle> per element.
+class FleetColumns {
 public:
-    RentalManager(Logger &log) : logger(log) {}
+    std::vector<int> id;
+    std::vector<VehicleKind> kind;
+    std::vector<double> dailyRate;
+    std::vector<std::uint8_t> rented;       // 0/1, kept as bytes for branch-free scans
+    std::vector<double> maxLoadKg;          // 0 unless Truck
+    std::vector<double> batteryCapacityKwh; // 0 unless ElectricCar
+    std::vector<double> chargeKwh;          // 0 unless ElectricCar
 
-    // add vehicle (makes clone to keep ownership)
-    void addVehicle(const Vehicle &v) {
-        fleet.push_back(v.clone());
-    }
+private:
+    std::string modelPool;
+    std::vector<std::uint32_t> modelOffset;
+    std::vector<std::uint32_t> modelLength;
 
-    // rentVehicle: optional loadKg default to 0
-    void rentVehicle(const std::string &memberId, int vehicleId, int days, double loadKg = 0.0) noexcept(false) {
-        Vehicle* v = findVehicle(vehicleId);
-        if (!v) {
-            std::string msg = "Vehicle not found id=" + std::to_string(vehicleId);
-            logger.log(msg);
-            throw VehicleException(msg);
-        }
-        if (v->getIsRented()) {
-            std::string msg = "Vehicle not available (already rented) id=" + std::to_string(vehicleId);
-            logger.log(msg);
-            throw VehicleNotAvailable(msg);
+public:
+    std::uint32_t append(const Vehicle &v) {
+        std::uint32_t slot = static_cast<std::uint32_t>(id.size());
+        id.push_back(v.getId());
+        kind.push_back(v.getKind());
+        dailyRate.push_back(v.getDailyRate());
+        rented.push_back(v.getIsRented() ? 1 : 0);
+        double load = 0.0, cap = 0.0, charge = 0.0;
+        if (v.getKind() == VehicleKind::Truck) {
+            load = static_cast<const Truck&>(v).getMaxLoadKg();
+        } else if (v.getKind() == VehicleKind::Electric) {
+            const auto &ev = static_cast<const ElectricCar&>(v);
+            cap = ev.getBatteryCapacity();
+            charge = ev.getCurrentCharge();
         }
+        maxLoadKg.push_back(load);
+        batteryCapacityKwh.push_back(cap);
+        chargeKwh.push_back(charge);
+        std::string m = v.getModel();
+        modelOffset.push_back(static_cast<std::uint32_t>(modelPool.size()));
+        modelLength.push_back(static_cast<std::uint32_t>(m.size()));
+        modelPool += m;
+        return slot;
+    }
 
-        // compute cost polymorphically; for Truck with load, use overload via dynamic_cast
-        double cost = 0.0;
-        if (Truck* t = dynamic_cast<Truck*>(v)) {
-            if (loadKg > t->getMaxLoadKg()) {
-                std::string msg = "Requested load " + std::to_string(loadKg) + " > max " + std::to_string(t->getMaxLoadKg());
-                logger.log("Overload attempt: " + msg);
-                throw OverloadException(msg);
-            }
-            // use overload rentCost(days, loadKg)
-            cost = t->rentCost(days, loadKg);
-        } else {
-            // general vehicles (Car, ElectricCar) use rentCost(int)
-            cost = v->rentCost(days);
+    void reserve(std::size_t n) {
+        id.reserve(n);
+        kind.reserve(n);
+        dailyRate.reserve(n);
+        rented.reserve(n);
+        maxLoadKg.reserve(n);
+        batteryCapacityKwh.reserve(n);
+        chargeKwh.reserve(n);
+        modelOffset.reserve(n);
+        modelLength.reserve(n);
+    }
+
+    std::size_t size() const { return id.size(); }
+
+    std::string_view model(std::size_t slot) const {
+        return std::string_view(modelPool).substr(modelOffset[slot], modelLength[slot]);
+    }
+
+    std::size_t countAvailable(VehicleKind k) const {
+        std::size_t n = 0;
+        const std::size_t count = id.size();
+        for (std::size_t i = 0; i < count; ++i) {
+            n += static_cast<std::size_t>((kind[i] == k) & (rented[i] == 0));
         }
+        return n;
+    }
 
-        // Attempt to start the vehicle (may throw for ElectricCar)
-        try {
-            v->start(); // ElectricCar::start may throw BatteryLowException
-        } catch (...) {
-            std::string msg = std::string("Start failed for vehicle id=") + std::to_string(vehicleId);
-            logger.log(msg + " -> exception thrown while starting");
-            throw; // rethrow to caller; ensure manager does not mark rented
+    // free EVs whose charge is at least minFraction of their battery capacity
+    std::size_t countFreeEvsWithCharge(double minFraction) const {
+        std::size_t n = 0;
+        const std::size_t count = id.size();
+        for (std::size_t i = 0; i < count; ++i) {
+            n += static_cast<std::size_t>((kind[i] == VehicleKind::Electric) & (rented[i] == 0) &
+                                          (chargeKwh[i] >= minFraction * batteryCapacityKwh[i]));
         }
+        return n;
+    }
+};
 
-        // mark as rented and record due date
-        v->setRented(true);
-        RentalInfo info{memberId, daysFromNow(days), loadKg};
-        activeRentals[vehicleId] = info;
+// Fixed-size slabs of T. Objects are constructed in place and live until the
+// pool is destroyed (vehicles are never removed from a fleet), so adding
+// vehicles costs one heap allocation per slab instead of one per vehicle and
+// keeps vehicles of one kind next to each other in memory.
+template <class T, std::size_t PerSlab = 256>
+class SlabPool {
+    struct Slab {
+        alignas(T) unsigned char storage[sizeof(T) * PerSlab];
+    };
+    std::vector<std::unique_ptr<Slab>> slabs;
+    std::size_t used = PerSlab; // objects constructed in the last slab
 
-        std::ostringstream oss;
-        oss << "Rented vehicle id=" << vehicleId << " to member=" << memberId << " for " << days
-            << " days; cost=" << cost;
-        logger.log(oss.str());
-        std::cout << oss.str() << std::endl;
+    T* at(std::size_t slab, std::size_t i) {
+        return reinterpret_cast<T*>(slabs[slab]->storage + sizeof(T) * i);
     }
 
-    // returnVehicle
-    void returnVehicle(const std::string &memberId, int vehicleId, int actualDays, bool damageFlag) noexcept(false) {
-        Vehicle* v = findVehicle(vehicleId);
-        if (!v) {
-            std::string msg = "Return failed: Vehicle not found id=" + std::to_string(vehicleId);
-            logger.log(msg);
-            throw VehicleException(msg);
-        }
-        auto it = activeRentals.find(vehicleId);
-        if (it == activeRentals.end()) {
-            std::string msg = "Return failed: Vehicle not rented id=" + std::to_string(vehicleId);
-            logger.log(msg);
-            throw VehicleException(msg);
-        }
-        if (it->second.memberId != memberId) {
-            std::string msg = "Return failed: member mismatch for vehicle id=" + std::to_string(vehicleId);
-            logger.log(msg);
-            throw VehicleException(msg);
-        }
-
-        // compute base expected cost using polymorphism (we could re-call rentCost with days)
-        double baseCost = 0.0;
-        RentalInfo info = it->second;
-        if (Truck* t = dynamic_cast<Truck*>(v)) {
-            // use recorded expectedLoadKg
-            baseCost = t->rentCost(actualDays, info.expectedLoadKg);
-        } else {
-            baseCost = v->rentCost(actualDays);
-        }
+public:
+    SlabPool() = default;
+    SlabPool(const SlabPool&) = delete;
+    SlabPool& operator=(const SlabPool&) = delete;
 
-        // penalty if late: if now > dueDate
-        auto now = std::chrono::system_clock::now();
-        double penalty = 0.0;
-        if (now > info.dueDate) {
-            auto diff = std::chrono::duration_cast<std::chrono::hours>(now - info.dueDate).count();
-            int lateDays = static_cast<int>(diff / 24) + 1; // at least 1 day
-            penalty += lateDays * 20.0; // example: 20 per late day
+    ~SlabPool() {
+        for (std::size_t s = 0; s < slabs.size(); ++s) {
+            std::size_t n = (s + 1 == slabs.size()) ? used : PerSlab;
+            for (std::size_t i = 0; i < n; ++i) at(s, i)->~T();
         }
+    }
 
-        // damage handling: if damageFlag true, evaluate severity (simulate threshold)
-        if (damageFlag) {
-            // simulate: severe damage threshold random or deterministic; we'll base on vehicleId for determinism
-            bool severe = (vehicleId % 2 == 0); // simulate: even id -> severe
-            if (severe) {
-                std::string msg = "Severe damage reported on return for vehicle id=" + std::to_string(vehicleId);
-                logger.log(msg);
-                // mark incident and throw InvalidReturnException
-                // still mark vehicle not rented (depending on policy), but we'll throw to caller
-                v->setRented(false);
-                activeRentals.erase(vehicleId);
-                throw InvalidReturnException(msg);
-            } else {
-                penalty += 100.0; // minor damage fee
-                logger.log("Minor damage fee applied for vehicle id=" + std::to_string(vehicleId));
-            }
+    template <class... Args>
+    T* create(Args&&... args) {
+        if (used == PerSlab) {
+            slabs.push_back(std::unique_ptr<Slab>(new Slab));
+            used = 0;
         }
+        T* p = new (slabs.back()->storage + sizeof(T) * used) T(std::forward<Args>(args)...);
+        ++used;
+        return p;
+    }
 
-        double total = baseCost + penalty;
+    std::size_t size() const { return slabs.empty() ? 0 : (slabs.size() - 1) * PerSlab + used; }
+};
 
-        // finalize return
-        v->setRented(false);
-        activeRentals.erase(vehicleId);
+// Open-addressing int -> V map (linear probing, backward-shift erase). Values
+// stay in the slot array and erased slots are reused in place, so once the
+// table has grown to the working-set size insert/erase never touch the heap.
+template <class V>
+class FlatIntMap {
+    struct Slot {
+        int key = 0;
+        bool used = false;
+        V value{};
+    };
+    std::vector<Slot> slots;
+    std::size_t mask;
+    std::size_t count = 0;
 
-        std::ostringstream oss;
-        oss << "Vehicle id=" << vehicleId << " returned by " << memberId << ". Base=" << baseCost
-            << " Penalty=" << penalty << " Total=" << total;
-        logger.log(oss.str());
-        std::cout << oss.str() << std::endl;
+    std::size_t home(int key) const {
+        std::uint32_t x = static_cast<std::uint32_t>(key) * 0x9E3779B1u;
+        return static_cast<std::size_t>(x ^ (x >> 15)) & mask;
     }
 
-    // Overloaded: chargeBattery(vehicleId, kwh)
-    void chargeBattery(int vehicleId, double kwh) noexcept(false) {
-        Vehicle* v = findVehicle(vehicleId);
-        if (!v) {
-            std::string msg = "Charge failed: Vehicle not found id=" + std::to_string(vehicleId);
-            logger.log(msg);
-            throw VehicleException(msg);
-        }
-        ElectricCar* ev = dynamic_cast<ElectricCar*>(v);
-        if (!ev) {
-            std::string msg = "Charge failed: vehicle id=" + std::to_string(vehicleId) + " is not an EV";
-            logger.log(msg);
-            throw VehicleException(msg);
+    void grow() {
+        std::vector<Slot> old(slots.size() * 2);
+        old.swap(slots);
+        mask = slots.size() - 1;
+        for (Slot &s : old) {
+            if (!s.used) continue;
+            std::size_t i = home(s.key);
+            while (slots[i].used) i = (i + 1) & mask;
+            slots[i].key = s.key;
+            slots[i].used = true;
+            slots[i].value = std::move(s.value);
         }
-        ev->charge(kwh);
-        std::ostringstream oss;
-        oss << "Charged EV id=" << vehicleId << " + " << kwh << "kWh (now " << ev->getCurrentCharge() << " kWh)";
-        logger.log(oss.str());
-        std::cout << oss.str() << std::endl;
     }
 
-    // Overloaded: chargeBattery(memberId, vehicleId, kwh) (just example overload)
-    void chargeBattery(const std::string &memberId, int vehicleId, double kwh) noexcept(false) {
-        // could verify member authorized; simple example logs member
-        chargeBattery(vehicleId, kwh);
-        logger.log("Charge requested by member " + memberId + " for vehicle " + std::to_string(vehicleId));
+public:
+    explicit FlatIntMap(std::size_t capacity = 16) {
+        std::size_t cap = 16;
+        while (cap < capacity * 2) cap <<= 1;
+        slots.resize(cap);
+        mask = cap - 1;
     }
 
-    void listFleet() const {
-        std::cout << "Fleet:" << std::endl;
-        for (const auto &p : fleet) {
-            std::cout << "  " << p->info() << (p->getIsRented() ? " [RENTED]" : "") << std::endl;
+    V* find(int key) {
+        for (std::size_t i = home(key);; i = (i + 1) & mask) {
+            if (!slots[i].used) return nullptr;
+            if (slots[i].key == key) return &slots[i].value;
         }
     }
-};
 
-int main() {
-    try {
-        Logger logger("rental_log.txt");
-        RentalManager manager(logger);
+    const V* find(int key) const { return const_cast<FlatIntMap*>(this)->find(key); }
+
+    // slot for key, existing or newly claimed; a reused slot still holds its old
+    // value, so callers assign every field
+    V& claim(int key) {
+        if ((count + 1) * 2 > slots.size()) grow();
+        std::size_t i = home(key);
+        for (; slots[i].used; i = (i + 1) & mask) {
+            if (slots[i].key == key) return slots[i].value;
+        }
+        slots[i].key = key;
+        slots[i].used = true;
+        ++count;
+        return slots[i].value;
+    }
+
+    bool erase(int key) {
+        std::size_t i = home(key);
+        for (;; i = (i + 1) & mask) {
+            if (!slots[i].used) return false;
+            if (slots[i].key == key) break;
+        }
+        // shift later members of the probe run back; values are swapped so
+        // their buffers (e.g. string capacity) stay in the table for reuse
+        for (std::size_t j = i;;) {
+            j = (j + 1) & mask;
+            if (!slots[j].used) break;
+            std::size_t k = home(slots[j].key);
+            bool stays = (i <= j) ? (i < k && k <= j) : (i < k || k <= j);
+            if (stays) continue;
+            slots[i].key = slots[j].key;
+            std::swap(slots[i].value, slots[j].value);
+            i = j;
+        }
+        slots[i].used = false;
+        --count;
+        return true;
+    }
+
+    std::size_t size() const { return count; }
+
+    template <class F>
+    void forEach(F &&f) const {
+        for (const Slot &s : slots) {
+            if (s.used) f(s.key, s.value);
+        }
+    }
+};
+
+// Maps a vehicle id to its slot in the fleet vector. Ids are usually handed
+// out sequentially, so a dense id -> slot table is used while the id range
+// stays compact; a sparse or negative id switches the index to a hash map.
+class VehicleIndex {
+public:
+    static constexpr std::uint32_t npos = 0xFFFFFFFFu;
+
+private:
+    std::vector<std::uint32_t> dense;
+    std::unordered_map<int, std::uint32_t> sparse;
+    bool useDense = true;
+    std::size_t count = 0;
+
+    bool fitsDense(int id) const {
+        // allow the table to be at most ~4x larger than the number of entries
+        return id >= 0 && static_cast<std::size_t>(id) < 4 * (count + 1) + 1024;
+    }
+
+    void switchToSparse() {
+        sparse.reserve(count * 2);
+        for (std::size_t id = 0; id < dense.size(); ++id) {
+            if (dense[id] != npos) sparse.emplace(static_cast<int>(id), dense[id]);
+        }
+        dense.clear();
+        dense.shrink_to_fit();
+        useDense = false;
+    }
+
+public:
+    // returns false if the id is already indexed (first insert wins)
+    bool insert(int id, std::uint32_t slot) {
+        if (useDense && !fitsDense(id)) switchToSparse();
+        if (useDense) {
+            std::size_t key = static_cast<std::size_t>(id);
+            if (key >= dense.size()) dense.resize(std::max(key + 1, dense.size() * 2), npos);
+            if (dense[key] != npos) return false;
+            dense[key] = slot;
+        } else if (!sparse.emplace(id, slot).second) {
+            return false;
+        }
+        ++count;
+        return true;
+    }
+
+    std::uint32_t find(int id) const {
+        if (useDense) {
+            std::size_t key = static_cast<std::size_t>(id);
+            return (id >= 0 && key < dense.size()) ? dense[key] : npos;
+        }
+        auto it = sparse.find(id);
+        return it == sparse.end() ? npos : it->second;
+    }
+
+    std::size_t size() const { return count; }
+    bool isDense() const { return useDense; }
+};
+
+// Free vehicles of a shard grouped per kind into buckets on an ordered key:
+// cars by passenger capacity, trucks by maxLoadKg, EVs by charge in 5% steps
+// of battery capacity. Buckets are never erased, so steady-state rent/return
+// only moves slot numbers in and out of existing vectors; each slot remembers
+// its bucket and position for O(1) removal.
+class AvailabilityIndex {
+public:
+    static constexpr std::uint32_t npos = 0xFFFFFFFFu;
+    static constexpr int kChargeSteps = 20;
+
+private:
+    using Buckets = std::map<double, std::vector<std::uint32_t>>;
+    struct Where {
+        std::vector<std::uint32_t> *bucket = nullptr; // map nodes are stable
+        std::uint32_t index = 0;
+    };
+    Buckets cars, trucks, evs;
+    std::vector<Where> where; // by slot; bucket == nullptr when not free or not indexed
+
+    void put(Buckets &b, double key, std::uint32_t slot) {
+        if (contains(slot)) return;
+        if (slot >= where.size()) where.resize(std::max<std::size_t>(slot + 1, where.size() * 2));
+        std::vector<std::uint32_t> &bucket = b[key];
+        where[slot] = Where{&bucket, static_cast<std::uint32_t>(bucket.size())};
+        bucket.push_back(slot);
+    }
+
+public:
+    static int chargeStep(double chargeKwh, double capacityKwh) {
+        if (capacityKwh <= 0.0) return 0;
+        return std::min(kChargeSteps, std::max(0, static_cast<int>(chargeKwh / capacityKwh * kChargeSteps)));
+    }
+
+    // indexes a free Car/Truck/ElectricCar; other kinds are ignored
+    void add(std::uint32_t slot, const FleetColumns &c, const Vehicle &v) {
+        switch (c.kind[slot]) {
+        case VehicleKind::Car:
+            put(cars, static_cast<const Car&>(v).getPassengerCapacity(), slot);
+            break;
+        case VehicleKind::Truck:
+            put(trucks, c.maxLoadKg[slot], slot);
+            break;
+        case VehicleKind::Electric:
+            put(evs, chargeStep(c.chargeKwh[slot], c.batteryCapacityKwh[slot]), slot);
+            break;
+        default:
+            break;
+        }
+    }
+
+    void remove(std::uint32_t slot) {
+        if (slot >= where.size() || !where[slot].bucket) return;
+        std::vector<std::uint32_t> &bucket = *where[slot].bucket;
+        std::uint32_t i = where[slot].index;
+        bucket[i] = bucket.back();
+        where[bucket[i]].index = i;
+        bucket.pop_back();
+        where[slot].bucket = nullptr;
+    }
+
+    bool contains(std::uint32_t slot) const { return slot < where.size() && where[slot].bucket; }
+
+    // the finders' default filter: every free slot will do
+    struct AnySlot {
+        bool operator()(std::uint32_t) const { return true; }
+    };
+
+    // Free slot in the smallest bucket with key >= minKey (best fit, so large
+    // vehicles stay free for requests that need them) that `accept` takes;
+    // npos if none. Rejected slots are skipped, not removed.
+    template <class Accept>
+    static std::uint32_t smallestAtLeast(const Buckets &b, double minKey, Accept &accept) {
+        for (auto it = b.lower_bound(minKey); it != b.end(); ++it) {
+            for (auto s = it->second.rbegin(); s != it->second.rend(); ++s) {
+                if (accept(*s)) return *s;
+            }
+        }
+        return npos;
+    }
+
+    template <class Accept = AnySlot>
+    std::uint32_t findCar(int minCapacity, Accept accept = Accept()) const {
+        return smallestAtLeast(cars, minCapacity, accept);
+    }
+
+    template <class Accept = AnySlot>
+    std::uint32_t findTruck(double loadKg, Accept accept = Accept()) const {
+        return smallestAtLeast(trucks, loadKg, accept);
+    }
+
+    // Most charged free EV with chargeKwh >= minFraction * capacity that
+    // `accept` takes. Buckets above the threshold's step always qualify on
+    // charge, so with the default filter only the threshold's own bucket is
+    // checked slot by slot, and only when nothing fuller is free.
+    template <class Accept = AnySlot>
+    std::uint32_t findEv(double minFraction, const FleetColumns &c, Accept accept = Accept()) const {
+        const double lowest = std::floor(std::max(0.0, minFraction) * kChargeSteps);
+        for (auto it = evs.rbegin(); it != evs.rend() && it->first >= lowest; ++it) {
+            for (auto s = it->second.rbegin(); s != it->second.rend(); ++s) {
+                if (c.chargeKwh[*s] >= minFraction * c.batteryCapacityKwh[*s] && accept(*s)) return *s;
+            }
+        }
+        return npos;
+    }
+};
+
+// Locks a shard mutex only when the manager runs in concurrent mode, so the
+// single-threaded path pays nothing. unlock() lets callers release early,
+// before logging or throwing.
+class ShardGuard {
+    std::mutex *m;
+public:
+    ShardGuard(std::mutex &mu, bool enabled) : m(enabled ? &mu : nullptr) {
+        if (m) m->lock();
+    }
+    ~ShardGuard() { unlock(); }
+    ShardGuard(const ShardGuard&) = delete;
+    ShardGuard& operator=(const ShardGuard&) = delete;
+    void unlock() {
+        if (m) {
+            m->unlock();
+            m = nullptr;
+        }
+    }
+};
+
+using MemberHandle = std::uint32_t;
+constexpr MemberHandle kNoMember = 0xFFFFFFFFu;
+
+// Interns member id strings into compact integer handles. RentalInfo keeps the
+// handle, so a rent stores 4 bytes instead of copying a string and the member
+// check on return is an integer compare. Concurrent managers stripe the
+// registry by hash; the low bits of a handle name its stripe.
+class MemberRegistry {
+    struct alignas(64) Stripe {
+        std::mutex mutex;
+        std::deque<std::string> names; // handle -> id; deque keeps elements in place
+        std::unordered_map<std::string_view, std::uint32_t> ids; // keys view into names
+    };
+    std::size_t stripeCount;
+    unsigned stripeBits;
+    bool locking;
+    std::unique_ptr<Stripe[]> stripes;
+
+    Stripe& stripeFor(std::string_view id) const {
+        return stripes[std::hash<std::string_view>{}(id) & (stripeCount - 1)];
+    }
+
+public:
+    explicit MemberRegistry(std::size_t stripes_ = 1, bool concurrent = false)
+        : stripeCount(1), stripeBits(0), locking(concurrent) {
+        while (stripeCount < stripes_) {
+            stripeCount <<= 1;
+            ++stripeBits;
+        }
+        stripes.reset(new Stripe[stripeCount]);
+    }
+
+    MemberHandle intern(std::string_view id) {
+        Stripe &st = stripeFor(id);
+        ShardGuard lk(st.mutex, locking);
+        auto it = st.ids.find(id);
+        std::uint32_t local;
+        if (it != st.ids.end()) {
+            local = it->second;
+        } else {
+            local = static_cast<std::uint32_t>(st.names.size());
+            st.names.emplace_back(id);
+            st.ids.emplace(std::string_view(st.names.back()), local);
+        }
+        return (local << stripeBits) | static_cast<std::uint32_t>(&st - stripes.get());
+    }
+
+    // handle of an id seen before, kNoMember otherwise; never inserts
+    MemberHandle find(std::string_view id) const {
+        Stripe &st = stripeFor(id);
+        ShardGuard lk(st.mutex, locking);
+        auto it = st.ids.find(id);
+        if (it == st.ids.end()) return kNoMember;
+        return (it->second << stripeBits) | static_cast<std::uint32_t>(&st - stripes.get());
+    }
+
+    // the interned id (empty for an unknown handle); the reference stays valid
+    // for the registry's lifetime
+    const std::string& name(MemberHandle h) const {
+        static const std::string unknown;
+        Stripe &st = stripes[h & (stripeCount - 1)];
+        ShardGuard lk(st.mutex, locking);
+        return (h >> stripeBits) < st.names.size() ? st.names[h >> stripeBits] : unknown;
+    }
+
+    std::size_t size() const {
+        std::size_t n = 0;
+        for (std::size_t s = 0; s < stripeCount; ++s) {
+            ShardGuard lk(stripes[s].mutex, locking);
+            n += stripes[s].names.size();
+        }
+        return n;
+    }
+};
+
+// One vehicle's future bookings as half-open [startNs, endNs) intervals,
+// kept sorted and non-overlapping, so they end in the order they start: a
+// conflict check is one binary search on the end times. A sorted vector
+// rather than a tree, since even hundreds of bookings per vehicle are a few
+// KB and an insert is one short memmove.
+class ReservationCalendar {
+public:
+    struct Entry {
+        std::int64_t startNs;
+        std::int64_t endNs;
+        double loadKg;        // expected Truck load, priced on pickup
+        MemberHandle member;
+        std::uint32_t serial; // low half of the ReservationId
+    };
+
+private:
+    std::vector<Entry> entries;
+
+    // first booking that ends after t
+    std::vector<Entry>::iterator firstEndingAfter(std::int64_t t) {
+        return std::upper_bound(entries.begin(), entries.end(), t,
+                                [](std::int64_t v, const Entry &e) { return v < e.endNs; });
+    }
+
+    std::vector<Entry>::const_iterator firstEndingAfter(std::int64_t t) const {
+        return std::upper_bound(entries.begin(), entries.end(), t,
+                                [](std::int64_t v, const Entry &e) { return v < e.endNs; });
+    }
+
+public:
+    bool empty() const { return entries.empty(); }
+    std::size_t size() const { return entries.size(); }
+    const std::vector<Entry>& all() const { return entries; }
+
+    // no booking overlaps [startNs, endNs)
+    bool isFree(std::int64_t startNs, std::int64_t endNs) const {
+        auto it = firstEndingAfter(startNs);
+        return it == entries.end() || it->startNs >= endNs;
+    }
+
+    // adds e unless it overlaps a booking
+    bool insert(const Entry &e) {
+        auto it = firstEndingAfter(e.startNs);
+        if (it != entries.end() && it->startNs < e.endNs) return false;
+        entries.insert(it, e);
+        return true;
+    }
+
+    const Entry* find(std::uint32_t serial) const {
+        for (const Entry &e : entries) {
+            if (e.serial == serial) return &e;
+        }
+        return nullptr;
+    }
+
+    bool erase(std::uint32_t serial) {
+        for (auto it = entries.begin(); it != entries.end(); ++it) {
+            if (it->serial == serial) {
+                entries.erase(it);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // forgets bookings that ended by nowNs without a pickup; they are a prefix
+    void dropEnded(std::int64_t nowNs) { entries.erase(entries.begin(), firstEndingAfter(nowNs)); }
+};
+
+class Journal;
+class Tracer;
+
+struct ManagerOptions {
+    // concurrent mode: vehicles and their rentals are split into lock-striped
+    // shards keyed by vehicle id, so operations on different shards never contend
+    bool concurrent = false;
+    std::size_t shardCount = 64; // rounded up to a power of two; ignored unless concurrent
+    bool echoToStdout = true;    // print rent/return/charge results to std::cout
+    Clock *clock = nullptr;      // due dates and late fees; nullptr = SystemClock
+    Journal *journal = nullptr;  // write-ahead journal of state changes; nullptr = none
+    Tracer *tracer = nullptr;    // trace spans of sampled rent/return/charge calls; nullptr = none
+    std::uint32_t latencySampleEvery = 16; // metrics: time 1 call in N per method (power of two, 1 = all)
+
+    static ManagerOptions concurrentMode(std::size_t shards = 64) {
+        ManagerOptions o;
+        o.concurrent = true;
+        o.shardCount = shards;
+        return o;
+    }
+};
+
+enum class RentalOp : std::uint8_t { Rent, Return, Charge };
+
+// result of one rent/return/charge attempt; Ok or the reason it failed
+enum class RentalStatus : std::uint8_t {
+    Ok,
+    NotFound,       // no vehicle with that id
+    NotAvailable,   // already rented
+    Overload,       // truck load above maxLoadKg
+    BatteryLow,     // EV charge below its start threshold
+    StartFailed,    // extension type's start() threw
+    NotRented,      // return for a vehicle without an active rental
+    MemberMismatch, // return by a different member than the renter
+    SevereDamage,   // return accepted but flagged as severe damage
+    NotElectric,    // charge requested for a non-EV
+    NoMatch,        // rentAny found no free vehicle meeting the constraints
+    PartitionUnavailable, // PartitionRouter: the owning partition did not answer
+    Reserved        // free now, but booked by a reservation within the rental period
+};
+
+// number of RentalStatus values; keep it after the last one when adding a status
+constexpr std::size_t kRentalStatusCount = static_cast<std::size_t>(RentalStatus::Reserved) + 1;
+
+inline const char* toString(RentalStatus s) {
+    switch (s) {
+    case RentalStatus::Ok: return "Ok";
+    case RentalStatus::NotFound: return "NotFound";
+    case RentalStatus::NotAvailable: return "NotAvailable";
+    case RentalStatus::Overload: return "Overload";
+    case RentalStatus::BatteryLow: return "BatteryLow";
+    case RentalStatus::StartFailed: return "StartFailed";
+    case RentalStatus::NotRented: return "NotRented";
+    case RentalStatus::MemberMismatch: return "MemberMismatch";
+    case RentalStatus::SevereDamage: return "SevereDamage";
+    case RentalStatus::NotElectric: return "NotElectric";
+    case RentalStatus::NoMatch: return "NoMatch";
+    case RentalStatus::PartitionUnavailable: return "PartitionUnavailable";
+    case RentalStatus::Reserved: return "Reserved";
+    }
+    return "Unknown";
+}
+
+// plain-data outcome of an operation, enough to rebuild the message or exception later
+struct RentalOutcome {
+    RentalStatus status = RentalStatus::Ok;
+    int vehicleId = 0;
+    double cost = 0.0;      // rent: quoted cost, return: total (base + penalty)
+    double baseCost = 0.0;  // return only
+    double penalty = 0.0;   // return only: late days + minor damage fee
+    bool minorDamage = false;
+    double loadKg = 0.0;    // Overload: requested load
+    double maxLoadKg = 0.0; // Overload: truck limit
+    double chargeKwh = 0.0; // Charge: battery level after charging
+
+    bool ok() const { return status == RentalStatus::Ok; }
+    explicit operator bool() const { return ok(); }
+};
+
+struct RentRequest {
+    std::string memberId;
+    int vehicleId;
+    int days;
+    double loadKg = 0.0;
+};
+
+// which vehicles RentalManager::listFleet prints
+enum class FleetFilter { All, Available, Rented };
+
+// what rentAny looks for; fields that do not apply to the requested kind are ignored
+struct RentConstraints {
+    int minCapacity = 0;            // Car: passenger capacity at least this
+    double loadKg = 0.0;            // Truck: load to carry, checked and priced as in rentVehicle
+    double minChargeFraction = 0.0; // ElectricCar: charge at least this share of battery capacity
+};
+
+// vehicle id in the high half, a per-shard serial in the low half; never 0
+using ReservationId = std::uint64_t;
+
+// result of a reservation call; Ok or the reason it failed
+enum class ReservationStatus : std::uint8_t {
+    Ok,
+    NotFound,        // no such vehicle, or no such reservation
+    InvalidInterval, // end not after start, or already over
+    Conflict,        // overlaps another booking or the current rental
+    Overload,        // Truck load above maxLoadKg
+    NoMatch,         // reserveTruck found no truck free for the interval
+    MemberMismatch,  // cancel or pickup by another member
+    Expired,         // pickup after the booking ended
+    TooEarly,        // pickup before the booking starts; the booking stays
+    RentFailed       // pickup: the rent itself failed, see ReservationOutcome::rental
+};
+
+inline const char* toString(ReservationStatus s) {
+    switch (s) {
+    case ReservationStatus::Ok: return "Ok";
+    case ReservationStatus::NotFound: return "NotFound";
+    case ReservationStatus::InvalidInterval: return "InvalidInterval";
+    case ReservationStatus::Conflict: return "Conflict";
+    case ReservationStatus::Overload: return "Overload";
+    case ReservationStatus::NoMatch: return "NoMatch";
+    case ReservationStatus::MemberMismatch: return "MemberMismatch";
+    case ReservationStatus::Expired: return "Expired";
+    case ReservationStatus::TooEarly: return "TooEarly";
+    case ReservationStatus::RentFailed: return "RentFailed";
+    }
+    return "Unknown";
+}
+
+struct ReservationOutcome {
+    ReservationStatus status = ReservationStatus::Ok;
+    ReservationId id = 0;
+    int vehicleId = 0;
+    std::chrono::system_clock::time_point start;
+    std::chrono::system_clock::time_point end;
+    double quotedCost = 0.0; // reserve: the booked days at the current tariff
+    RentalOutcome rental;    // pickup: the rent the booking turned into
+
+    bool ok() const { return status == ReservationStatus::Ok; }
+    explicit operator bool() const { return ok(); }
+};
+
+struct Reservation {
+    ReservationId id = 0;
+    int vehicleId = 0;
+    std::string memberId;
+    std::chrono::system_clock::time_point start;
+    std::chrono::system_clock::time_point end;
+    double loadKg = 0.0;
+};
+
+// input of RentalManager::scheduleCharging: one depot charging window
+struct ChargingBudget {
+    double depotKwh = 0.0;        // energy the depot can deliver in this window
+    double maxKwhPerVehicle = std::numeric_limits<double>::infinity(); // charger limit per EV
+    double targetFraction = 1.0;  // top-up goal as a share of battery capacity
+    std::vector<int> reservedIds; // EVs with an upcoming pickup; charged to target first
+};
+
+// what scheduleCharging did
+struct ChargingSummary {
+    std::size_t candidates = 0;      // free EVs below the target when planned
+    std::size_t charged = 0;
+    std::size_t madeStartable = 0;   // below the start threshold before, at or above after
+    std::size_t stillBelowStart = 0; // free EVs the budget could not lift to the threshold
+    std::size_t skipped = 0;         // rented between planning and applying
+    double deliveredKwh = 0.0;
+    double unusedKwh = 0.0;          // budget left over
+};
+
+struct ReturnRequest {
+    std::string memberId;
+    int vehicleId;
+    int actualDays;
+    bool damaged = false;
+};
+
+// a rental past its due date, as reported by RentalManager::pollOverdue
+struct OverdueRental {
+    int vehicleId = 0;
+    MemberHandle member = kNoMember;
+    std::string memberId;
+    std::chrono::system_clock::time_point dueDate;
+    int lateDays = 0;     // as returnVehicle would count them now
+    double lateFee = 0.0; // penalty a return now would add, damage aside
+};
+
+// per-item result of a batch call; error holds what the single-call API would have thrown
+struct BatchResult {
+    RentalOutcome outcome;
+    std::exception_ptr error;
+
+    bool ok() const { return outcome.ok(); }
+};
+
+// handle of a parked RentalManager::rentWhenReady call, 0 if it did not wait
+using RentWaitId = std::uint64_t;
+
+// Where RentalManager::rentWhenReady completions run. post() is called with
+// no manager lock held, from whichever thread made the vehicle ready.
+class RentExecutor {
+public:
+    virtual ~RentExecutor() = default;
+    virtual void post(std::function<void()> task) = 0;
+};
+
+// A fixed set of threads running posted tasks in order of arrival; the
+// destructor runs what is still queued, then joins.
+class ThreadPoolExecutor : public RentExecutor {
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::deque<std::function<void()>> tasks;
+    bool stopping = false;
+    std::vector<std::thread> threads;
+
+    void run() {
+        std::unique_lock<std::mutex> lk(mutex);
+        for (;;) {
+            wake.wait(lk, [&] { return stopping || !tasks.empty(); });
+            if (tasks.empty()) return; // stopping with nothing left
+            std::function<void()> task = std::move(tasks.front());
+            tasks.pop_front();
+            lk.unlock();
+            task();
+            lk.lock();
+        }
+    }
+
+public:
+    explicit ThreadPoolExecutor(unsigned threadCount = 1) {
+        for (unsigned i = 0; i < std::max(1u, threadCount); ++i) threads.emplace_back(&ThreadPoolExecutor::run, this);
+    }
+
+    ~ThreadPoolExecutor() override {
+        {
+            std::lock_guard<std::mutex> lk(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (std::thread &t : threads) t.join();
+    }
+
+    ThreadPoolExecutor(const ThreadPoolExecutor&) = delete;
+    ThreadPoolExecutor& operator=(const ThreadPoolExecutor&) = delete;
+
+    void post(std::function<void()> task) override {
+        {
+            std::lock_guard<std::mutex> lk(mutex);
+            tasks.push_back(std::move(task));
+        }
+        wake.notify_one();
+    }
+};
+
+// ---------------------------------------------------------------------------
+// Binary fleet snapshot
+// ---------------------------------------------------------------------------
+//
+// Layout (all sections 8-byte aligned, native byte order, checked on load):
+//   SnapshotHeader
+//   SnapshotVehicle[vehicleCount]   fleet in insertion order
+//   SnapshotRental[rentalCount]     active rentals; member indexes the member table
+//   SnapshotString[memberCount]     member table: offset/length into the string pool
+//   char[stringBytes]               member ids and model names
+// Records are fixed-size PODs read in place from the mapped file. Bump
+// kSnapshotVersion whenever a record changes shape.
+
+constexpr std::uint32_t kSnapshotVersion = 1;
+constexpr std::uint32_t kSnapshotByteOrder = 0x01020304u;
+
+// time points are stored as nanoseconds since the system_clock epoch
+inline std::int64_t toEpochNs(std::chrono::system_clock::time_point t) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(t.time_since_epoch()).count();
+}
+
+inline std::chrono::system_clock::time_point fromEpochNs(std::int64_t ns) {
+    return std::chrono::system_clock::time_point(
+        std::chrono::duration_cast<std::chrono::system_clock::duration>(std::chrono::nanoseconds(ns)));
+}
+
+struct SnapshotHeader {
+    char magic[8];             // "RNTLSNAP"
+    std::uint32_t version;
+    std::uint32_t byteOrder;   // kSnapshotByteOrder as written by this machine
+    std::uint64_t sequence;    // caller-supplied position (e.g. of a journal) the snapshot covers
+    std::int64_t takenAtNs;    // manager clock at save time
+    std::uint64_t vehicleCount;
+    std::uint64_t rentalCount;
+    std::uint64_t memberCount;
+    std::uint64_t stringBytes;
+    std::uint64_t vehicleOffset;
+    std::uint64_t rentalOffset;
+    std::uint64_t memberOffset;
+    std::uint64_t stringOffset;
+    std::uint64_t fileSize;
+};
+
+struct SnapshotVehicle {
+    std::int32_t id;
+    VehicleKind kind;
+    std::uint8_t rented;
+    std::uint16_t reserved;
+    std::uint32_t modelOffset;
+    std::uint32_t modelLength;
+    double dailyRate;
+    double spec;      // Car: passenger capacity, Truck: max load kg, EV: battery capacity kWh
+    double chargeKwh; // EV only
+};
+
+struct SnapshotRental {
+    std::int32_t vehicleId;
+    std::uint32_t member;
+    std::int64_t dueDateNs;
+    double expectedLoadKg;
+};
+
+struct SnapshotString {
+    std::uint32_t offset;
+    std::uint32_t length;
+};
+
+static_assert(sizeof(SnapshotVehicle) == 40 && std::is_trivially_copyable<SnapshotVehicle>::value,
+              "snapshot records are read in place");
+static_assert(sizeof(SnapshotRental) == 24 && sizeof(SnapshotHeader) % 8 == 0, "snapshot layout");
+
+// what saveSnapshot wrote or loadSnapshot restored
+struct SnapshotStats {
+    std::size_t vehicles = 0;
+    std::size_t rentals = 0;
+    std::size_t skippedExtensions = 0; // kind Other vehicles have no snapshot record
+    std::uint64_t sequence = 0;
+};
+
+// Read-only view of a whole file: mmap on POSIX, a heap copy elsewhere.
+class MappedFile {
+    const char *base = nullptr;
+    std::size_t length = 0;
+#ifdef _WIN32
+    std::vector<char> copy;
+#endif
+
+public:
+    explicit MappedFile(const std::string &path, const char *what = "snapshot") {
+        const std::string name = std::string(what) + " " + path;
+#ifdef _WIN32
+        std::ifstream in(path, std::ios::binary);
+        if (!in) throw std::runtime_error("Cannot open " + name);
+        copy.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        base = copy.data();
+        length = copy.size();
+#else
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) throw std::runtime_error("Cannot open " + name);
+        struct stat st;
+        if (::fstat(fd, &st) != 0) {
+            ::close(fd);
+            throw std::runtime_error("Cannot stat " + name);
+        }
+        length = static_cast<std::size_t>(st.st_size);
+        if (length > 0) {
+            void *p = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p == MAP_FAILED) {
+                ::close(fd);
+                throw std::runtime_error("Cannot map " + name);
+            }
+            ::madvise(p, length, MADV_SEQUENTIAL);
+            base = static_cast<const char*>(p);
+        }
+        ::close(fd);
+#endif
+    }
+
+    ~MappedFile() {
+#ifndef _WIN32
+        if (base) ::munmap(const_cast<char*>(base), length);
+#endif
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const char* data() const { return base; }
+    std::size_t size() const { return length; }
+};
+
+// ---------------------------------------------------------------------------
+// Fleet import files
+// ---------------------------------------------------------------------------
+//
+// RentalManager::importFleet onboards a fleet from either of two formats:
+//   CSV      one vehicle per line: kind,id,model,daily_rate,spec[,charge_kwh]
+//            with kind car, truck or electric and spec its passenger capacity,
+//            max load kg or battery capacity kWh; charge_kwh is required for
+//            electric and left empty otherwise. A first line starting with
+//            "kind," is a header. Fields are not quoted, so a model cannot
+//            contain a comma.
+//   columns  FleetFileHeader ("RNTLFCOL"), then one array per field, each
+//            8-byte aligned: int32 id, uint8 kind (VehicleKind), double daily
+//            rate, double spec, double charge kWh, uint32 model offset,
+//            uint32 model length, and last the model string pool.
+// Both are read through MappedFile and cut into chunks parsed on several
+// threads. FleetFileWriter writes the columnar form.
+
+constexpr std::uint32_t kFleetFileVersion = 1;
+
+enum class FleetFileFormat : std::uint8_t { Auto, Csv, Columns }; // Auto: columns when the magic matches
+
+struct FleetFileHeader {
+    char magic[8];           // "RNTLFCOL"
+    std::uint32_t version;
+    std::uint32_t byteOrder; // kSnapshotByteOrder as written by this machine
+    std::uint64_t rowCount;
+    std::uint64_t stringBytes;
+    std::uint64_t idOffset;
+    std::uint64_t kindOffset;
+    std::uint64_t rateOffset;
+    std::uint64_t specOffset;
+    std::uint64_t chargeOffset;
+    std::uint64_t modelOffsetOffset;
+    std::uint64_t modelLengthOffset;
+    std::uint64_t stringOffset;
+    std::uint64_t fileSize;
+};
+
+static_assert(sizeof(FleetFileHeader) % 8 == 0, "fleet file layout");
+
+// why a row of a fleet file was skipped; the rest of the file still loads
+enum class ImportProblem : std::uint8_t {
+    Ok,
+    Malformed,       // wrong field count, or a field that does not parse
+    UnknownKind,     // not car, truck or electric
+    InvalidRate,     // daily rate negative or not finite
+    InvalidCapacity, // Car passenger capacity not a positive integer
+    InvalidLoad,     // Truck max load not positive
+    InvalidBattery,  // battery capacity not positive, or charge outside [0, capacity]
+    DuplicateId      // id already in the fleet or on an earlier row
+};
+
+inline const char* toString(ImportProblem p) {
+    switch (p) {
+    case ImportProblem::Ok: return "Ok";
+    case ImportProblem::Malformed: return "Malformed";
+    case ImportProblem::UnknownKind: return "UnknownKind";
+    case ImportProblem::InvalidRate: return "InvalidRate";
+    case ImportProblem::InvalidCapacity: return "InvalidCapacity";
+    case ImportProblem::InvalidLoad: return "InvalidLoad";
+    case ImportProblem::InvalidBattery: return "InvalidBattery";
+    case ImportProblem::DuplicateId: return "DuplicateId";
+    }
+    return "Unknown";
+}
+
+struct ImportError {
+    std::uint64_t row; // 1-based: the CSV line, or the record of a columnar file
+    int vehicleId;     // 0 when the id itself did not parse
+    ImportProblem problem;
+};
+
+// what importFleet did
+struct FleetImportStats {
+    std::size_t rows = 0;            // data rows, blank lines and the header excluded
+    std::size_t imported = 0;
+    std::vector<ImportError> errors; // in row order
+};
+
+// one parsed row; model points into the mapped file
+struct ImportRow {
+    std::uint64_t row;
+    std::int32_t id;
+    VehicleKind kind;
+    ImportProblem problem; // from parsing; the value checks come later
+    std::uint32_t modelLength;
+    const char *model;
+    double dailyRate;
+    double spec;
+    double chargeKwh;
+};
+
+// the value checks of a row, after the parse problems
+inline ImportProblem checkImportRow(const ImportRow &r) {
+    if (r.problem != ImportProblem::Ok) return r.problem;
+    if (!std::isfinite(r.dailyRate) || r.dailyRate < 0.0) return ImportProblem::InvalidRate;
+    switch (r.kind) {
+    case VehicleKind::Car:
+        return r.spec >= 1.0 && r.spec <= std::numeric_limits<int>::max() && r.spec == std::floor(r.spec)
+                   ? ImportProblem::Ok : ImportProblem::InvalidCapacity;
+    case VehicleKind::Truck:
+        return std::isfinite(r.spec) && r.spec > 0.0 ? ImportProblem::Ok : ImportProblem::InvalidLoad;
+    default:
+        return std::isfinite(r.spec) && r.spec > 0.0 && r.chargeKwh >= 0.0 && r.chargeKwh <= r.spec
+                   ? ImportProblem::Ok : ImportProblem::InvalidBattery;
+    }
+}
+
+// Runs f(0) .. f(tasks - 1) on up to `workers` threads, the caller's included
+template <class F>
+void runOnWorkers(std::size_t tasks, std::size_t workers, F &&f) {
+    std::atomic<std::size_t> next{0};
+    auto run = [&] {
+        for (std::size_t t; (t = next.fetch_add(1, std::memory_order_relaxed)) < tasks;) f(t);
+    };
+    std::vector<std::thread> pool;
+    for (std::size_t w = 1; w < std::min(workers, tasks); ++w) pool.emplace_back(run);
+    run();
+    for (std::thread &t : pool) t.join();
+}
+
+// all cores, but at least ~1 MiB of input per chunk
+inline std::size_t importWorkers(std::size_t bytes) {
+    return std::min<std::size_t>(std::max(1u, std::thread::hardware_concurrency()), 1 + bytes / (1u << 20));
+}
+
+template <class T>
+bool parseImportField(std::string_view s, T &out) {
+    auto r = std::from_chars(s.data(), s.data() + s.size(), out);
+    return r.ec == std::errc() && r.ptr == s.data() + s.size() && !s.empty();
+}
+
+// Parses the CSV lines in [begin, end), which starts at a line start.
+// Rows are numbered from 1 within the chunk; returns the lines seen.
+inline std::uint64_t parseFleetCsvChunk(const char *begin, const char *end, bool firstChunk, std::vector<ImportRow> &rows) {
+    std::uint64_t line = 0;
+    for (const char *p = begin; p < end;) {
+        const char *eol = static_cast<const char*>(std::memchr(p, '\n', static_cast<std::size_t>(end - p)));
+        if (!eol) eol = end;
+        std::string_view text(p, static_cast<std::size_t>(eol - p));
+        p = eol < end ? eol + 1 : end;
+        ++line;
+        if (!text.empty() && text.back() == '\r') text.remove_suffix(1);
+        if (text.empty() || (firstChunk && line == 1 && text.substr(0, 5) == "kind,")) continue;
+
+        std::string_view field[6]; // this line's only, never a previous line's
+        std::size_t fields = 0;
+        for (std::size_t pos = 0;; ++fields) {
+            const std::size_t comma = text.find(',', pos);
+            if (fields < 6) field[fields] = text.substr(pos, comma == std::string_view::npos ? comma : comma - pos);
+            if (comma == std::string_view::npos) break;
+            pos = comma + 1;
+        }
+        ++fields;
+
+        ImportRow r{};
+        r.row = line;
+        r.problem = ImportProblem::Ok;
+        if (fields < 5) { // too short for any kind; its id field may not even exist
+            r.problem = ImportProblem::Malformed;
+            rows.push_back(r);
+            continue;
+        }
+        if (!parseImportField(field[1], r.id)) {
+            r.id = 0;
+            r.problem = ImportProblem::Malformed;
+        }
+        if (field[0] == "car") r.kind = VehicleKind::Car;
+        else if (field[0] == "truck") r.kind = VehicleKind::Truck;
+        else if (field[0] == "electric") r.kind = VehicleKind::Electric;
+        else if (r.problem == ImportProblem::Ok) r.problem = ImportProblem::UnknownKind;
+        if (r.problem == ImportProblem::Ok) {
+            const bool ev = r.kind == VehicleKind::Electric;
+            const bool shape = ev ? fields == 6 : (fields == 5 || (fields == 6 && field[5].empty()));
+            if (!shape || !parseImportField(field[3], r.dailyRate) || !parseImportField(field[4], r.spec) ||
+                (ev && !parseImportField(field[5], r.chargeKwh))) {
+                r.problem = ImportProblem::Malformed;
+            }
+            r.model = field[2].data();
+            r.modelLength = static_cast<std::uint32_t>(field[2].size());
+        }
+        rows.push_back(r);
+    }
+    return line;
+}
+
+// every row of a CSV fleet file, in file order
+inline std::vector<ImportRow> readFleetCsv(const char *base, std::size_t size, std::size_t chunks) {
+    // chunk boundaries move forward to the next line start
+    chunks = std::max<std::size_t>(1, chunks);
+    std::vector<std::size_t> start(chunks + 1, size);
+    start[0] = 0;
+    for (std::size_t k = 1; k < chunks; ++k) {
+        std::size_t at = std::max(start[k - 1], size / chunks * k);
+        const void *nl = at < size ? std::memchr(base + at, '\n', size - at) : nullptr;
+        start[k] = nl ? static_cast<std::size_t>(static_cast<const char*>(nl) - base) + 1 : size;
+    }
+    std::vector<std::vector<ImportRow>> parts(chunks);
+    std::vector<std::uint64_t> lines(chunks, 0);
+    runOnWorkers(chunks, chunks, [&](std::size_t k) {
+        parts[k].reserve((start[k + 1] - start[k]) / 32);
+        lines[k] = parseFleetCsvChunk(base + start[k], base + start[k + 1], k == 0, parts[k]);
+    });
+    std::size_t total = 0;
+    for (const auto &part : parts) total += part.size();
+    std::vector<ImportRow> rows;
+    rows.reserve(total);
+    std::uint64_t firstLine = 0;
+    for (std::size_t k = 0; k < chunks; ++k) {
+        for (ImportRow &r : parts[k]) {
+            r.row += firstLine;
+            rows.push_back(r);
+        }
+        firstLine += lines[k];
+        std::vector<ImportRow>().swap(parts[k]);
+    }
+    return rows;
+}
+
+// every row of a columnar fleet file; throws std::runtime_error for a bad header
+inline std::vector<ImportRow> readFleetColumns(const std::string &path, const char *base, std::size_t size,
+                                               std::size_t chunks) {
+    auto corrupt = [&](const char *what) { return std::runtime_error("Fleet file " + path + ": " + what); };
+    FleetFileHeader h;
+    if (size < sizeof(h)) throw corrupt("truncated header");
+    std::memcpy(&h, base, sizeof(h));
+    if (std::memcmp(h.magic, "RNTLFCOL", sizeof(h.magic)) != 0) throw corrupt("not a columnar fleet file");
+    if (h.byteOrder != kSnapshotByteOrder) throw corrupt("written with another byte order");
+    if (h.version != kFleetFileVersion) throw corrupt("unsupported version");
+    if (h.fileSize != size) throw corrupt("size mismatch");
+    auto columnFits = [&](std::uint64_t offset, std::size_t width) {
+        return offset % 8 == 0 && offset >= sizeof(h) && offset <= h.fileSize && h.rowCount <= (h.fileSize - offset) / width;
+    };
+    if (!columnFits(h.idOffset, 4) || !columnFits(h.kindOffset, 1) || !columnFits(h.rateOffset, 8) ||
+        !columnFits(h.specOffset, 8) || !columnFits(h.chargeOffset, 8) || !columnFits(h.modelOffsetOffset, 4) ||
+        !columnFits(h.modelLengthOffset, 4) || h.stringOffset > h.fileSize || h.stringBytes > h.fileSize - h.stringOffset) {
+        throw corrupt("column out of bounds");
+    }
+    const auto *ids = reinterpret_cast<const std::int32_t*>(base + h.idOffset);
+    const auto *kinds = reinterpret_cast<const std::uint8_t*>(base + h.kindOffset);
+    const auto *rates = reinterpret_cast<const double*>(base + h.rateOffset);
+    const auto *specs = reinterpret_cast<const double*>(base + h.specOffset);
+    const auto *charges = reinterpret_cast<const double*>(base + h.chargeOffset);
+    const auto *modelOffsets = reinterpret_cast<const std::uint32_t*>(base + h.modelOffsetOffset);
+    const auto *modelLengths = reinterpret_cast<const std::uint32_t*>(base + h.modelLengthOffset);
+    const char *strings = base + h.stringOffset;
+
+    const std::size_t count = static_cast<std::size_t>(h.rowCount);
+    std::vector<ImportRow> rows(count);
+    chunks = std::max<std::size_t>(1, chunks);
+    runOnWorkers(chunks, chunks, [&](std::size_t k) {
+        for (std::size_t i = count / chunks * k, end = k + 1 == chunks ? count : count / chunks * (k + 1); i < end; ++i) {
+            ImportRow &r = rows[i];
+            r.row = i + 1;
+            r.id = ids[i];
+            r.kind = static_cast<VehicleKind>(kinds[i]);
+            r.problem = kinds[i] <= static_cast<std::uint8_t>(VehicleKind::Electric) ? ImportProblem::Ok : ImportProblem::UnknownKind;
+            if (static_cast<std::uint64_t>(modelOffsets[i]) + modelLengths[i] > h.stringBytes) r.problem = ImportProblem::Malformed;
+            r.model = strings + modelOffsets[i];
+            r.modelLength = modelLengths[i];
+            r.dailyRate = rates[i];
+            r.spec = specs[i];
+            r.chargeKwh = charges[i];
+        }
+    });
+    return rows;
+}
+
+// Collects a fleet in the columnar import format and writes it in one go
+class FleetFileWriter {
+    std::vector<std::int32_t> ids;
+    std::vector<std::uint8_t> kinds;
+    std::vector<double> rates, specs, charges;
+    std::vector<std::uint32_t> modelOffsets, modelLengths;
+    std::string strings;
+
+public:
+    void add(VehicleKind kind, int id, std::string_view model, double dailyRate, double spec, double chargeKwh = 0.0) {
+        // consecutive rows of one model share its bytes
+        if (ids.empty() || model != std::string_view(strings).substr(modelOffsets.back(), modelLengths.back())) {
+            if (strings.size() + model.size() > 0xFFFFFFFFu) throw std::runtime_error("Fleet file string pool exceeds 4 GiB");
+            modelOffsets.push_back(static_cast<std::uint32_t>(strings.size()));
+            strings.append(model.data(), model.size());
+        } else {
+            modelOffsets.push_back(modelOffsets.back());
+        }
+        modelLengths.push_back(static_cast<std::uint32_t>(model.size()));
+        ids.push_back(id);
+        kinds.push_back(static_cast<std::uint8_t>(kind));
+        rates.push_back(dailyRate);
+        specs.push_back(spec);
+        charges.push_back(chargeKwh);
+    }
+
+    std::size_t size() const { return ids.size(); }
+
+    void save(const std::string &path) const {
+        const std::uint64_t n = ids.size();
+        auto aligned = [](std::uint64_t x) { return (x + 7) & ~std::uint64_t(7); };
+        FleetFileHeader h{};
+        std::memcpy(h.magic, "RNTLFCOL", sizeof(h.magic));
+        h.version = kFleetFileVersion;
+        h.byteOrder = kSnapshotByteOrder;
+        h.rowCount = n;
+        h.stringBytes = strings.size();
+        h.idOffset = sizeof(FleetFileHeader);
+        h.kindOffset = aligned(h.idOffset + 4 * n);
+        h.rateOffset = aligned(h.kindOffset + n);
+        h.specOffset = h.rateOffset + 8 * n;
+        h.chargeOffset = h.specOffset + 8 * n;
+        h.modelOffsetOffset = h.chargeOffset + 8 * n;
+        h.modelLengthOffset = aligned(h.modelOffsetOffset + 4 * n);
+        h.stringOffset = aligned(h.modelLengthOffset + 4 * n);
+        h.fileSize = h.stringOffset + strings.size();
+
+        const std::string tmp = path + ".tmp";
+        std::FILE *f = std::fopen(tmp.c_str(), "wb");
+        if (!f) throw std::runtime_error("Cannot create fleet file " + tmp);
+        std::uint64_t at = 0;
+        bool ok = true;
+        auto put = [&](std::uint64_t offset, const void *p, std::size_t bytes) {
+            static const char zeros[8] = {};
+            if (ok && offset > at) ok = std::fwrite(zeros, 1, offset - at, f) == offset - at;
+            if (ok && bytes > 0) ok = std::fwrite(p, 1, bytes, f) == bytes;
+            at = offset + bytes;
+        };
+        put(0, &h, sizeof(h));
+        put(h.idOffset, ids.data(), ids.size() * sizeof(std::int32_t));
+        put(h.kindOffset, kinds.data(), kinds.size());
+        put(h.rateOffset, rates.data(), rates.size() * sizeof(double));
+        put(h.specOffset, specs.data(), specs.size() * sizeof(double));
+        put(h.chargeOffset, charges.data(), charges.size() * sizeof(double));
+        put(h.modelOffsetOffset, modelOffsets.data(), modelOffsets.size() * sizeof(std::uint32_t));
+        put(h.modelLengthOffset, modelLengths.data(), modelLengths.size() * sizeof(std::uint32_t));
+        put(h.stringOffset, strings.data(), strings.size());
+        ok = std::fclose(f) == 0 && ok;
+        if (!ok || std::rename(tmp.c_str(), path.c_str()) != 0) {
+            std::remove(tmp.c_str());
+            throw std::runtime_error("Cannot write fleet file " + path);
+        }
+    }
+};
+
+// ---------------------------------------------------------------------------
+// Write-ahead journal
+// ---------------------------------------------------------------------------
+//
+// Append-only binary log of manager state transitions, separate from the
+// human-readable Logger. After a 16-byte file header ("RNTLJRNL", version,
+// byte order) every transition is one frame:
+//   JournalFrame (24 bytes) + payload
+//     AddVehicle: SnapshotVehicle (model at offset 0) + model bytes
+//     Rent:       JournalRent + member id bytes
+//     Return:     nothing
+//     Charge:     double kWh added
+// The checksum covers the frame after itself plus the payload, so a torn frame
+// at the tail (crash during write) is detected and dropped on reopen.
+// Recovery is loadSnapshot() + replay of the frames after its sequence.
+
+constexpr std::uint32_t kJournalVersion = 1;
+
+enum class JournalOp : std::uint8_t { AddVehicle, Rent, Return, Charge };
+
+struct JournalFileHeader {
+    char magic[8]; // "RNTLJRNL"
+    std::uint32_t version;
+    std::uint32_t byteOrder;
+};
+
+struct JournalFrame {
+    std::uint32_t payloadBytes;
+    std::uint32_t checksum;
+    std::uint64_t sequence;
+    JournalOp op;
+    std::uint8_t reserved[3];
+    std::int32_t vehicleId;
+};
+
+struct JournalRent {
+    std::int64_t dueDateNs;
+    double loadKg;
+};
+
+static_assert(sizeof(JournalFrame) == 24 && sizeof(JournalFileHeader) == 16, "journal layout");
+
+// FNV-1a, extended over several buffers
+inline std::uint32_t journalChecksum(const void *p, std::size_t n, std::uint32_t h = 2166136261u) {
+    const unsigned char *b = static_cast<const unsigned char*>(p);
+    for (std::size_t i = 0; i < n; ++i) h = (h ^ b[i]) * 16777619u;
+    return h;
+}
+
+struct JournalOptions {
+    // group commit: one flusher thread writes and syncs everything appended so
+    // far in one go; appends arriving during a sync join the next group. A
+    // non-zero commitWindow additionally holds each group open that long after
+    // its first append, trading latency for fewer syncs under light load.
+    bool groupCommit = true;
+    std::chrono::microseconds commitWindow{0};
+    std::size_t maxPendingBytes = 1 << 20; // flush before the window ends once this much is buffered
+    bool sync = true;                      // false: write without fsync (tests, benchmarks)
+
+    // baseline without coalescing: every append is written and synced on the calling thread
+    static JournalOptions syncEach() {
+        JournalOptions o;
+        o.groupCommit = false;
+        return o;
+    }
+};
+
+// Sequential reader over a journal file; stops at the end or at the first frame
+// that is cut short or fails its checksum.
+class JournalReader {
+    MappedFile file;
+    std::size_t pos = sizeof(JournalFileHeader);
+    bool torn = false;
+
+public:
+    struct Entry {
+        JournalFrame frame;
+        const char *payload;
+    };
+
+    explicit JournalReader(const std::string &path) : file(path) {
+        JournalFileHeader h;
+        if (file.size() < sizeof(h)) throw std::runtime_error("Journal " + path + ": truncated header");
+        std::memcpy(&h, file.data(), sizeof(h));
+        if (std::memcmp(h.magic, "RNTLJRNL", sizeof(h.magic)) != 0 || h.byteOrder != kSnapshotByteOrder ||
+            h.version != kJournalVersion) {
+            throw std::runtime_error("Journal " + path + ": not a compatible journal");
+        }
+    }
+
+    bool next(Entry &e) {
+        if (torn || pos == file.size()) return false;
+        if (file.size() - pos < sizeof(JournalFrame)) {
+            torn = true;
+            return false;
+        }
+        std::memcpy(&e.frame, file.data() + pos, sizeof(JournalFrame));
+        const std::size_t end = pos + sizeof(JournalFrame) + e.frame.payloadBytes;
+        if (e.frame.payloadBytes > file.size() - pos - sizeof(JournalFrame)) {
+            torn = true;
+            return false;
+        }
+        e.payload = file.data() + pos + sizeof(JournalFrame);
+        std::uint32_t sum = journalChecksum(file.data() + pos + 8, sizeof(JournalFrame) - 8);
+        if (journalChecksum(e.payload, e.frame.payloadBytes, sum) != e.frame.checksum) {
+            torn = true;
+            return false;
+        }
+        pos = end;
+        return true;
+    }
+
+    std::size_t validBytes() const { return pos; }
+    bool tornTail() const { return torn; }
+};
+
+// Which records of a binary log to keep: a set of events (all when empty)
+// and optionally one vehicle. Text records carry no vehicle id, so a vehicle
+// filter drops them.
+struct LogFilter {
+    std::uint32_t events = 0; // bit per LogEvent
+    std::optional<int> vehicleId;
+
+    LogFilter& event(LogEvent e) {
+        events |= 1u << static_cast<unsigned>(e);
+        return *this;
+    }
+
+    LogFilter& vehicle(int id) {
+        vehicleId = id;
+        return *this;
+    }
+
+    bool matches(const LogRecord &r) const {
+        if (events && !(events & (1u << static_cast<unsigned>(r.event)))) return false;
+        return !vehicleId || (r.event != LogEvent::Text && r.vehicleId == *vehicleId);
+    }
+};
+
+// Walks a binary log written by Logger. Records are read in place from the
+// mapping; next() with a filter looks at the fixed headers only and steps
+// over the text of records it skips. A record cut off by a crash ends the
+// walk (tornTail).
+class BinaryLogReader {
+    MappedFile file;
+    std::size_t pos = sizeof(LogFileHeader);
+    bool torn = false;
+
+public:
+    struct Entry {
+        LogRecord record;
+        std::string_view text;
+    };
+
+    explicit BinaryLogReader(const std::string &path) : file(path) {
+        LogFileHeader h;
+        if (file.size() < sizeof(h)) throw std::runtime_error("Log " + path + ": truncated header");
+        std::memcpy(&h, file.data(), sizeof(h));
+        if (std::memcmp(h.magic, "RNTLBLOG", sizeof(h.magic)) != 0 || h.byteOrder != kLogByteOrder ||
+            h.version != kLogVersion) {
+            throw std::runtime_error("Log " + path + ": not a compatible binary log");
+        }
+    }
+
+    bool next(Entry &e, const LogFilter &filter = LogFilter()) {
+        while (!torn && pos < file.size()) {
+            if (file.size() - pos < sizeof(LogRecord)) break;
+            std::memcpy(&e.record, file.data() + pos, sizeof(LogRecord));
+            if (e.record.textBytes > file.size() - pos - sizeof(LogRecord)) break;
+            const char *text = file.data() + pos + sizeof(LogRecord);
+            pos += sizeof(LogRecord) + e.record.textBytes;
+            if (!filter.matches(e.record)) continue;
+            e.text = std::string_view(text, e.record.textBytes);
+            return true;
+        }
+        if (pos < file.size()) torn = true;
+        return false;
+    }
+
+    bool tornTail() const { return torn; }
+};
+
+// Appends frames and makes them durable. RentalManager appends while holding
+// the shard lock, so sequence order matches the order transitions happened in,
+// and waits in commit() after releasing it, so other shards keep working while
+// a group is synced.
+class Journal {
+    std::string path;
+    JournalOptions opts;
+    std::FILE *file = nullptr;
+
+    std::mutex mutex;
+    std::condition_variable work;    // flusher: something to write, or stopping
+    std::condition_variable durable; // committers: durableSeq moved
+    std::string pending;             // encoded frames not yet handed to the file
+    std::string writing;             // the flusher's batch; swapped with pending
+    std::uint64_t lastSeq = 0;       // last sequence handed out
+    std::uint64_t durableSeq = 0;    // last sequence written (and synced)
+    std::chrono::steady_clock::time_point pendingSince;
+    bool stopping = false;
+    bool failed = false;
+    std::thread flusher;
+
+    bool writeOut(const std::string &bytes) {
+        bool ok = bytes.empty() || std::fwrite(bytes.data(), 1, bytes.size(), file) == bytes.size();
+        ok = std::fflush(file) == 0 && ok;
+#ifndef _WIN32
+        if (opts.sync) ok = ::fsync(::fileno(file)) == 0 && ok;
+#endif
+        return ok;
+    }
+
+    void flushLoop() {
+        std::unique_lock<std::mutex> lk(mutex);
+        for (;;) {
+            work.wait(lk, [&] { return stopping || !pending.empty(); });
+            if (pending.empty()) break; // stopping with nothing left
+            // gather more appends until the window closes, unless the buffer fills first
+            if (opts.commitWindow.count() > 0) {
+                auto deadline = pendingSince + opts.commitWindow;
+                work.wait_until(lk, deadline, [&] { return stopping || pending.size() >= opts.maxPendingBytes; });
+            }
+            writing.swap(pending);
+            pending.clear();
+            const std::uint64_t upto = lastSeq;
+            lk.unlock();
+            bool ok = writeOut(writing);
+            lk.lock();
+            if (!ok) failed = true;
+            durableSeq = upto;
+            durable.notify_all();
+        }
+    }
+
+public:
+    explicit Journal(const std::string &path_, const JournalOptions &options = JournalOptions())
+        : path(path_), opts(options) {
+        JournalFileHeader h{};
+        std::memcpy(h.magic, "RNTLJRNL", sizeof(h.magic));
+        h.version = kJournalVersion;
+        h.byteOrder = kSnapshotByteOrder;
+        std::size_t validBytes = 0;
+        std::error_code ec;
+        const std::uintmax_t size = std::filesystem::file_size(path, ec);
+        if (!ec && size > 0 && size < sizeof(h)) {
+            // a crash while creating the journal: start over if what is there is
+            // the start of our header
+            std::string head(static_cast<std::size_t>(size), '\0');
+            std::FILE *in = std::fopen(path.c_str(), "rb");
+            bool ours = in && std::fread(&head[0], 1, head.size(), in) == head.size() &&
+                        std::memcmp(head.data(), &h, head.size()) == 0;
+            if (in) std::fclose(in);
+            if (!ours) throw std::runtime_error("Journal " + path + ": not a compatible journal");
+            std::filesystem::resize_file(path, 0, ec);
+            if (ec) throw std::runtime_error("Cannot truncate torn journal " + path);
+        } else if (!ec && size > 0) {
+            // reopen: continue after the last intact frame and cut off a torn tail
+            JournalReader reader(path);
+            JournalReader::Entry e;
+            while (reader.next(e)) lastSeq = e.frame.sequence;
+            validBytes = reader.validBytes();
+            if (reader.tornTail()) {
+                std::filesystem::resize_file(path, validBytes, ec);
+                if (ec) throw std::runtime_error("Cannot truncate torn journal " + path);
+            }
+        }
+        durableSeq = lastSeq;
+        file = std::fopen(path.c_str(), "ab");
+        if (!file) throw std::runtime_error("Cannot open journal " + path);
+        if (validBytes == 0) {
+            if (!writeOut(std::string(reinterpret_cast<const char*>(&h), sizeof(h)))) {
+                std::fclose(file);
+                throw std::runtime_error("Cannot write journal " + path);
+            }
+        }
+        if (opts.groupCommit) flusher = std::thread(&Journal::flushLoop, this);
+    }
+
+    ~Journal() {
+        if (flusher.joinable()) {
+            {
+                std::lock_guard<std::mutex> lk(mutex);
+                stopping = true;
+            }
+            work.notify_one();
+            flusher.join();
+        }
+        if (file) std::fclose(file);
+    }
+
+    Journal(const Journal&) = delete;
+    Journal& operator=(const Journal&) = delete;
+
+    // Encodes one frame and returns its sequence. Nothing is durable until
+    // commit() returns for that sequence (or a later one).
+    std::uint64_t append(JournalOp op, int vehicleId, const void *payload, std::size_t bytes,
+                         std::string_view tail = std::string_view()) {
+        JournalFrame f{};
+        f.payloadBytes = static_cast<std::uint32_t>(bytes + tail.size());
+        f.op = op;
+        f.vehicleId = vehicleId;
+        std::lock_guard<std::mutex> lk(mutex);
+        f.sequence = ++lastSeq;
+        std::uint32_t sum = journalChecksum(reinterpret_cast<const char*>(&f) + 8, sizeof(f) - 8);
+        sum = journalChecksum(payload, bytes, sum);
+        f.checksum = journalChecksum(tail.data(), tail.size(), sum);
+        if (pending.empty()) pendingSince = std::chrono::steady_clock::now();
+        pending.append(reinterpret_cast<const char*>(&f), sizeof(f));
+        pending.append(static_cast<const char*>(payload), bytes);
+        pending.append(tail.data(), tail.size());
+        if (!opts.groupCommit) {
+            if (!writeOut(pending)) failed = true;
+            pending.clear();
+            durableSeq = f.sequence;
+        } else if (pending.size() == sizeof(f) + f.payloadBytes || pending.size() >= opts.maxPendingBytes) {
+            work.notify_one();
+        }
+        return f.sequence;
+    }
+
+    // Blocks until every frame up to seq is written and synced. Throws
+    // std::runtime_error once a write or sync has failed.
+    void commit(std::uint64_t seq) {
+        std::unique_lock<std::mutex> lk(mutex);
+        durable.wait(lk, [&] { return durableSeq >= seq || failed; });
+        if (failed) throw std::runtime_error("Journal write failed: " + path);
+    }
+
+    std::uint64_t lastSequence() {
+        std::lock_guard<std::mutex> lk(mutex);
+        return lastSeq;
+    }
+
+    const std::string& getPath() const { return path; }
+};
+
+// what replayJournal applied
+struct JournalReplayStats {
+    std::size_t applied = 0;
+    std::size_t skipped = 0;        // at or before the snapshot sequence
+    std::size_t inconsistent = 0;   // named a vehicle the manager does not have
+    std::uint64_t lastSequence = 0;
+    bool tornTail = false;
+};
+
+// ---------------------------------------------------------------------------
+// Metrics
+// ---------------------------------------------------------------------------
+//
+// Every thread that calls into a manager gets its own counter block, written
+// with plain relaxed stores and summed only when a snapshot is taken, so the
+// hot paths never contend on a shared cache line. Latencies go into log-linear
+// (HDR-style) histograms: 16 sub-buckets per power of two, i.e. about 6%
+// relative error. Outcome counters are exact; latency is sampled, one call
+// in ManagerOptions::latencySampleEvery per method and thread, timed in raw
+// ticks (the TSC on x86) that snapshots convert to ns. Timing every call
+// would add two timestamp reads to paths that take a few hundred ns.
+//
+// Build with -DRENTAL_NO_METRICS to compile the instrumentation out: the
+// recorder, timer and per-shard tallies become empty inline no-ops and the
+// snapshot reports enabled=false with only the active rental count filled in.
+
+// public methods that are timed; throwing and try* forms share an entry
+enum class MetricsMethod : std::uint8_t {
+    Rent, Return, Charge, RentAny, RentBatch, ReturnBatch, Quote, PollOverdue,
+    AddVehicle, ListFleet, SaveSnapshot, LoadSnapshot, ReplayJournal, ScheduleCharging, ImportFleet, Count
+};
+
+inline const char* toString(MetricsMethod m) {
+    switch (m) {
+    case MetricsMethod::Rent: return "rent";
+    case MetricsMethod::Return: return "return";
+    case MetricsMethod::Charge: return "charge";
+    case MetricsMethod::RentAny: return "rent_any";
+    case MetricsMethod::RentBatch: return "rent_batch";
+    case MetricsMethod::ReturnBatch: return "return_batch";
+    case MetricsMethod::Quote: return "quote";
+    case MetricsMethod::PollOverdue: return "poll_overdue";
+    case MetricsMethod::AddVehicle: return "add_vehicle";
+    case MetricsMethod::ListFleet: return "list_fleet";
+    case MetricsMethod::SaveSnapshot: return "save_snapshot";
+    case MetricsMethod::LoadSnapshot: return "load_snapshot";
+    case MetricsMethod::ReplayJournal: return "replay_journal";
+    case MetricsMethod::ScheduleCharging: return "schedule_charging";
+    case MetricsMethod::ImportFleet: return "import_fleet";
+    case MetricsMethod::Count: break;
+    }
+    return "unknown";
+}
+
+inline const char* toString(RentalOp op) {
+    switch (op) {
+    case RentalOp::Rent: return "rent";
+    case RentalOp::Return: return "return";
+    case RentalOp::Charge: return "charge";
+    }
+    return "unknown";
+}
+
+// exception type the throwing API raises for a status (see RentalManager::throwFailure)
+inline const char* exceptionName(RentalStatus s) {
+    switch (s) {
+    case RentalStatus::Ok: return "none";
+    case RentalStatus::NotAvailable:
+    case RentalStatus::NoMatch:
+    case RentalStatus::Reserved: return "VehicleNotAvailable";
+    case RentalStatus::Overload: return "OverloadException";
+    case RentalStatus::BatteryLow: return "BatteryLowException";
+    case RentalStatus::SevereDamage: return "InvalidReturnException";
+    case RentalStatus::PartitionUnavailable: return "PartitionUnavailableException";
+    default: return "VehicleException";
+    }
+}
+
+namespace metrics {
+
+// Raw timestamp for latency measurement: the TSC on x86 GCC/Clang builds,
+// steady_clock ticks elsewhere. Only differences of two values mean anything.
+inline std::uint64_t ticks() {
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+    return __rdtsc();
+#else
+    return static_cast<std::uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+}
+
+// ns per tick, measured against steady_clock since the first call (made
+// when the first recorder is built), so it sharpens as the process runs
+inline double nsPerTick() {
+    using Steady = std::chrono::steady_clock;
+    static const std::pair<std::uint64_t, Steady::time_point> origin{ticks(), Steady::now()};
+    const std::uint64_t t = ticks();
+    const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(Steady::now() - origin.second).count();
+    if (t <= origin.first || ns <= 0) return 1.0;
+    return static_cast<double>(ns) / static_cast<double>(t - origin.first);
+}
+
+constexpr std::size_t kOps = 3; // RentalOp values
+constexpr std::size_t kStatuses = kRentalStatusCount;
+constexpr std::size_t kMethods = static_cast<std::size_t>(MetricsMethod::Count);
+constexpr std::size_t kKinds = static_cast<std::size_t>(VehicleKind::Other) + 1;
+
+constexpr unsigned kSubBits = 4;   // 16 sub-buckets per power of two
+constexpr unsigned kMaxMsb = 39;   // values clamp at 2^40 ticks
+constexpr std::size_t kBuckets = (kMaxMsb - kSubBits + 2) << kSubBits;
+
+// values below 16 get exact buckets; above, the bucket keeps the leading
+// one plus the next four bits of the value
+inline std::size_t bucketOf(std::uint64_t v) {
+    if (v < (1u << kSubBits)) return static_cast<std::size_t>(v);
+#if defined(__GNUC__)
+    unsigned msb = 63u - static_cast<unsigned>(__builtin_clzll(v));
+#else
+    unsigned msb = 0;
+    while (v >> (msb + 1)) ++msb;
+#endif
+    if (msb > kMaxMsb) return kBuckets - 1;
+    std::size_t sub = static_cast<std::size_t>(v >> (msb - kSubBits)) & ((1u << kSubBits) - 1);
+    return ((msb - kSubBits + 1) << kSubBits) + sub;
+}
+
+// largest value that lands in bucket b
+inline std::uint64_t bucketUpper(std::size_t b) {
+    if (b < (1u << kSubBits)) return b;
+    unsigned msb = static_cast<unsigned>(b >> kSubBits) + kSubBits - 1;
+    std::uint64_t sub = b & ((1u << kSubBits) - 1);
+    std::uint64_t lower = ((std::uint64_t{1} << kSubBits) + sub) << (msb - kSubBits);
+    return lower + (std::uint64_t{1} << (msb - kSubBits)) - 1;
+}
+
+// merged latency histogram of one method, all threads summed; buckets
+// are in ticks, the accessors answer in ns
+struct Histogram {
+    std::vector<std::uint64_t> buckets = std::vector<std::uint64_t>(kBuckets, 0);
+    std::uint64_t count = 0;
+    std::uint64_t sumTicks = 0;
+    std::uint64_t maxTicks = 0;
+    double nsPerTick = 1.0;
+
+    // upper bound of the bucket holding quantile q (0..1); 0 when empty
+    double percentile(double q) const {
+        if (count == 0) return 0.0;
+        std::uint64_t rank = static_cast<std::uint64_t>(std::ceil(q * static_cast<double>(count)));
+        rank = std::max<std::uint64_t>(rank, 1);
+        std::uint64_t seen = 0;
+        for (std::size_t b = 0; b < kBuckets; ++b) {
+            seen += buckets[b];
+            if (seen >= rank) return static_cast<double>(std::min(bucketUpper(b), maxTicks)) * nsPerTick;
+        }
+        return maxNs();
+    }
+
+    double totalNs() const { return static_cast<double>(sumTicks) * nsPerTick; }
+    double maxNs() const { return static_cast<double>(maxTicks) * nsPerTick; }
+    double meanNs() const { return count ? totalNs() / static_cast<double>(count) : 0.0; }
+};
+
+} // namespace metrics
+
+// aggregated view returned by RentalManager::metricsSnapshot()
+struct MetricsSnapshot {
+    bool enabled = false;
+    std::uint64_t outcomes[metrics::kOps][metrics::kStatuses] = {}; // [RentalOp][RentalStatus]
+    metrics::Histogram latency[metrics::kMethods];                  // [MetricsMethod]
+    std::size_t activeRentals = 0;
+    std::size_t vehicles[metrics::kKinds] = {}; // [VehicleKind]
+    std::size_t rented[metrics::kKinds] = {};
+    std::uint64_t logDropped = 0;
+
+    std::uint64_t count(RentalOp op, RentalStatus s) const {
+        return outcomes[static_cast<std::size_t>(op)][static_cast<std::size_t>(s)];
+    }
+
+    // attempts of op that the throwing API would have failed with exception `name`
+    std::uint64_t countByException(RentalOp op, const std::string &name) const {
+        std::uint64_t n = 0;
+        for (std::size_t s = 1; s < metrics::kStatuses; ++s) {
+            if (name == exceptionName(static_cast<RentalStatus>(s))) n += outcomes[static_cast<std::size_t>(op)][s];
+        }
+        return n;
+    }
+
+    const metrics::Histogram& of(MetricsMethod m) const { return latency[static_cast<std::size_t>(m)]; }
+
+    // rented share of the fleet of one kind, 0 for an empty kind
+    double utilization(VehicleKind k) const {
+        std::size_t i = static_cast<std::size_t>(k);
+        return vehicles[i] ? static_cast<double>(rented[i]) / static_cast<double>(vehicles[i]) : 0.0;
+    }
+
+    // Prometheus-style text exposition: counters and summaries with quantiles
+    std::string exposition() const {
+        static const char *kinds[metrics::kKinds] = {"car", "truck", "electric", "other"};
+        std::ostringstream out;
+        out << "# TYPE rental_operations_total counter\n";
+        for (std::size_t op = 0; op < metrics::kOps; ++op) {
+            for (std::size_t s = 0; s < metrics::kStatuses; ++s) {
+                const RentalStatus status = static_cast<RentalStatus>(s);
+                out << "rental_operations_total{op=\"" << toString(static_cast<RentalOp>(op)) << "\",status=\""
+                    << toString(status) << "\",exception=\"" << exceptionName(status) << "\"} " << outcomes[op][s] << "\n";
+            }
+        }
+        out << "# TYPE rental_method_latency_ns summary\n";
+        for (std::size_t m = 0; m < metrics::kMethods; ++m) {
+            const metrics::Histogram &h = latency[m];
+            const char *name = toString(static_cast<MetricsMethod>(m));
+            for (double q : {0.5, 0.9, 0.99, 0.999}) {
+                out << "rental_method_latency_ns{method=\"" << name << "\",quantile=\"" << q << "\"} " << h.percentile(q) << "\n";
+            }
+            out << "rental_method_latency_ns_sum{method=\"" << name << "\"} " << h.totalNs() << "\n";
+            out << "rental_method_latency_ns_count{method=\"" << name << "\"} " << h.count << "\n";
+        }
+        out << "# TYPE rental_active_rentals gauge\n";
+        out << "rental_active_rentals " << activeRentals << "\n";
+        out << "# TYPE rental_fleet_vehicles gauge\n";
+        for (std::size_t k = 0; k < metrics::kKinds; ++k) out << "rental_fleet_vehicles{kind=\"" << kinds[k] << "\"} " << vehicles[k] << "\n";
+        out << "# TYPE rental_fleet_rented gauge\n";
+        for (std::size_t k = 0; k < metrics::kKinds; ++k) out << "rental_fleet_rented{kind=\"" << kinds[k] << "\"} " << rented[k] << "\n";
+        out << "# TYPE rental_fleet_utilization gauge\n";
+        for (std::size_t k = 0; k < metrics::kKinds; ++k) {
+            out << "rental_fleet_utilization{kind=\"" << kinds[k] << "\"} " << utilization(static_cast<VehicleKind>(k)) << "\n";
+        }
+        out << "# TYPE rental_log_dropped_total counter\n";
+        out << "rental_log_dropped_total " << logDropped << "\n";
+        return out.str();
+    }
+};
+
+// Running business totals, kept per shard as operations happen and summed by
+// fleetTotals(). Vehicle and rental counts are fleet state; the money and the
+// rent/return counts cover what this manager did since it was created, since a
+// snapshot or journal replay restores rentals but not what they earned.
+struct FleetTotals {
+    std::uint64_t rentals = 0;             // successful rents
+    std::uint64_t returns = 0;             // finished returns, severe damage included
+    std::uint64_t severeDamageReturns = 0; // returns that failed with InvalidReturnException
+    std::uint64_t minorDamageReturns = 0;
+    std::uint64_t charges = 0;             // chargeBattery calls and scheduled charges
+    std::uint64_t vehicles[metrics::kKinds] = {}; // [VehicleKind]
+    std::uint64_t rented[metrics::kKinds] = {};
+    double baseRevenue = 0.0;        // rental cost of finished returns
+    double lateFees = 0.0;
+    double damageFees = 0.0;         // minor damage fees
+    double outstandingRevenue = 0.0; // quoted cost of rentals still out (made by this manager)
+    double chargedKwh = 0.0;         // energy actually delivered
+
+    double penalties() const { return lateFees + damageFees; }
+    double revenue() const { return baseRevenue + penalties(); }
+
+    // includes vehicles that were added already rented, with no rental record
+    std::uint64_t rentedVehicles() const {
+        std::uint64_t n = 0;
+        for (std::uint64_t r : rented) n += r;
+        return n;
+    }
+
+    double utilization(VehicleKind k) const {
+        std::size_t i = static_cast<std::size_t>(k);
+        return vehicles[i] ? static_cast<double>(rented[i]) / static_cast<double>(vehicles[i]) : 0.0;
+    }
+
+    FleetTotals& operator+=(const FleetTotals &o) {
+        rentals += o.rentals;
+        returns += o.returns;
+        severeDamageReturns += o.severeDamageReturns;
+        minorDamageReturns += o.minorDamageReturns;
+        charges += o.charges;
+        for (std::size_t k = 0; k < metrics::kKinds; ++k) {
+            vehicles[k] += o.vehicles[k];
+            rented[k] += o.rented[k];
+        }
+        baseRevenue += o.baseRevenue;
+        lateFees += o.lateFees;
+        damageFees += o.damageFees;
+        outstandingRevenue += o.outstandingRevenue;
+        chargedKwh += o.chargedKwh;
+        return *this;
+    }
+};
+
+static_assert(std::is_trivially_copyable<FleetTotals>::value && sizeof(FleetTotals) % sizeof(std::uint64_t) == 0,
+              "FleetTotals is published word by word");
+
+// One shard's FleetTotals behind a seqlock. The writer edits a private copy
+// under the shard lock and publish()es it: the sequence goes odd, the words
+// are rewritten, the sequence goes even. read() copies the words without any
+// lock and retries while a publish is in progress or happened meanwhile, so
+// a poller never blocks an operation and never sees half of one.
+class PublishedTotals {
+    static constexpr std::size_t kWords = sizeof(FleetTotals) / sizeof(std::uint64_t);
+
+    std::atomic<std::uint64_t> seq{0};
+    std::atomic<std::uint64_t> words[kWords];
+    FleetTotals working; // writer side, guarded by the shard lock
+
+public:
+    PublishedTotals() {
+        std::uint64_t zero[kWords];
+        std::memcpy(zero, &working, sizeof(working));
+        for (std::size_t i = 0; i < kWords; ++i) words[i].store(zero[i], std::memory_order_relaxed);
+    }
+
+    // writer's copy; the caller holds the shard lock and publishes before releasing it
+    FleetTotals& edit() { return working; }
+
+    void publish() {
+        std::uint64_t w[kWords];
+        std::memcpy(w, &working, sizeof(working));
+        const std::uint64_t s = seq.load(std::memory_order_relaxed);
+        seq.store(s + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for (std::size_t i = 0; i < kWords; ++i) words[i].store(w[i], std::memory_order_relaxed);
+        seq.store(s + 2, std::memory_order_release);
+    }
+
+    FleetTotals read() const {
+        std::uint64_t w[kWords];
+        for (;;) {
+            const std::uint64_t s = seq.load(std::memory_order_acquire);
+            if (s & 1) {
+                std::this_thread::yield(); // a publish is in progress
+                continue;
+            }
+            for (std::size_t i = 0; i < kWords; ++i) w[i] = words[i].load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (seq.load(std::memory_order_relaxed) == s) break;
+        }
+        FleetTotals t;
+        std::memcpy(&t, w, sizeof(t));
+        return t;
+    }
+};
+
+#ifndef RENTAL_NO_METRICS
+// Per-manager recorder. Each thread finds its block through a small
+// thread_local cache keyed by recorder id (ids are never reused, so a cache
+// entry of a destroyed manager can never match), falling back to a locked
+// lookup by thread id the first time or after the cache rotated it out.
+class MetricsRecorder {
+    struct MethodBlock {
+        std::atomic<std::uint64_t> buckets[metrics::kBuckets] = {};
+        std::atomic<std::uint64_t> sumTicks{0};
+        std::atomic<std::uint64_t> maxTicks{0};
+    };
+
+    struct alignas(64) ThreadBlock {
+        std::atomic<std::uint64_t> outcomes[metrics::kOps][metrics::kStatuses] = {};
+        MethodBlock methods[metrics::kMethods];
+    };
+
+    struct CacheEntry {
+        std::uint64_t owner = 0;
+        ThreadBlock *block = nullptr;
+    };
+    static constexpr std::size_t kCacheEntries = 4;
+    static thread_local CacheEntry cache[kCacheEntries];
+    static thread_local std::size_t cacheNext;
+
+    static std::uint64_t nextId() {
+        static std::atomic<std::uint64_t> ids{0};
+        return ids.fetch_add(1, std::memory_order_relaxed) + 1;
+    }
+
+    static thread_local std::uint32_t sampleClock[metrics::kMethods];
+
+    const std::uint64_t id = nextId();
+    std::uint32_t sampleMask = 0;
+    mutable std::mutex mutex; // guards blocks and owners
+    std::deque<ThreadBlock> blocks;
+    std::unordered_map<std::thread::id, ThreadBlock*> owners;
+
+    // only the owning thread writes a block, so load + store is enough
+    static void bump(std::atomic<std::uint64_t> &c, std::uint64_t by = 1) {
+        c.store(c.load(std::memory_order_relaxed) + by, std::memory_order_relaxed);
+    }
+
+    ThreadBlock& local() {
+        for (CacheEntry &e : cache) {
+            if (e.owner == id) return *e.block;
+        }
+        ThreadBlock *block;
+        {
+            std::lock_guard<std::mutex> lk(mutex);
+            ThreadBlock *&slot = owners[std::this_thread::get_id()];
+            if (!slot) slot = &blocks.emplace_back();
+            block = slot;
+        }
+        cache[cacheNext++ % kCacheEntries] = CacheEntry{id, block};
+        return *block;
+    }
+
+public:
+    void countOutcome(RentalOp op, RentalStatus s) {
+        bump(local().outcomes[static_cast<std::size_t>(op)][static_cast<std::size_t>(s)]);
+    }
+
+    // sampleEvery is rounded down to a power of two
+    explicit MetricsRecorder(std::uint32_t sampleEvery = 1) {
+        while (sampleEvery > 1 && (sampleMask << 1 | 1) < sampleEvery) sampleMask = sampleMask << 1 | 1;
+        metrics::nsPerTick(); // pins the tick calibration origin
+    }
+
+    // whether this call of m on this thread is one of the timed samples
+    bool sample(MetricsMethod m) const {
+        return (++sampleClock[static_cast<std::size_t>(m)] & sampleMask) == 0;
+    }
+
+    void recordLatency(MetricsMethod m, std::uint64_t ticks) {
+        MethodBlock &b = local().methods[static_cast<std::size_t>(m)];
+        bump(b.buckets[metrics::bucketOf(ticks)]);
+        bump(b.sumTicks, ticks);
+        if (ticks > b.maxTicks.load(std::memory_order_relaxed)) b.maxTicks.store(ticks, std::memory_order_relaxed);
+    }
+
+    // adds every thread's counters into out
+    void mergeInto(MetricsSnapshot &out) const {
+        const double nsPerTick = metrics::nsPerTick();
+        for (metrics::Histogram &h : out.latency) h.nsPerTick = nsPerTick;
+        std::lock_guard<std::mutex> lk(mutex);
+        for (const ThreadBlock &t : blocks) {
+            for (std::size_t op = 0; op < metrics::kOps; ++op) {
+                for (std::size_t s = 0; s < metrics::kStatuses; ++s) {
+                    out.outcomes[op][s] += t.outcomes[op][s].load(std::memory_order_relaxed);
+                }
+            }
+            for (std::size_t m = 0; m < metrics::kMethods; ++m) {
+                const MethodBlock &b = t.methods[m];
+                metrics::Histogram &h = out.latency[m];
+                for (std::size_t i = 0; i < metrics::kBuckets; ++i) {
+                    std::uint64_t n = b.buckets[i].load(std::memory_order_relaxed);
+                    h.buckets[i] += n;
+                    h.count += n;
+                }
+                h.sumTicks += b.sumTicks.load(std::memory_order_relaxed);
+                h.maxTicks = std::max(h.maxTicks, b.maxTicks.load(std::memory_order_relaxed));
+            }
+        }
+        out.enabled = true;
+    }
+};
+
+thread_local MetricsRecorder::CacheEntry MetricsRecorder::cache[MetricsRecorder::kCacheEntries];
+thread_local std::size_t MetricsRecorder::cacheNext = 0;
+thread_local std::uint32_t MetricsRecorder::sampleClock[metrics::kMethods] = {};
+
+// times one public call into the recorder's histogram for m, if sampled
+class MethodTimer {
+    MetricsRecorder &recorder;
+    MetricsMethod method;
+    std::uint64_t start;
+public:
+    MethodTimer(MetricsRecorder &r, MetricsMethod m)
+        : recorder(r), method(m), start(r.sample(m) ? metrics::ticks() : 0) {}
+    ~MethodTimer() {
+        if (start) recorder.recordLatency(method, metrics::ticks() - start);
+    }
+    MethodTimer(const MethodTimer&) = delete;
+    MethodTimer& operator=(const MethodTimer&) = delete;
+};
+#else
+class MetricsRecorder {
+public:
+    explicit MetricsRecorder(std::uint32_t = 1) {}
+    void countOutcome(RentalOp, RentalStatus) {}
+    void recordLatency(MetricsMethod, std::uint64_t) {}
+    void mergeInto(MetricsSnapshot&) const {}
+};
+
+class MethodTimer {
+public:
+    MethodTimer(MetricsRecorder&, MetricsMethod) {}
+};
+#endif
+
+// ---------------------------------------------------------------------------
+// Tracing
+// ---------------------------------------------------------------------------
+//
+// Scoped spans around the stages of rent, return and charge: lock wait,
+// lookup, pricing, start(), the activeRentals update, journal append and
+// commit, the log write and the stdout write. A Tracer set in
+// ManagerOptions::tracer samples one call in sampleEvery per thread; the
+// spans of a sampled call go into the calling thread's ring buffer as raw
+// ticks and are only converted when exported, so an unsampled call pays a
+// thread-local test per stage. writeChromeTrace() emits Chrome trace event
+// JSON, which chrome://tracing and the Perfetto UI both open.
+
+enum class TraceStage : std::uint8_t {
+    Rent, Return, Charge, // whole calls; the sampling decision is made here
+    Lock, Lookup, Pricing, Start, ActiveRentals, Journal, Commit, Log, Stdout, Count
+};
+
+inline const char* toString(TraceStage s) {
+    switch (s) {
+    case TraceStage::Rent: return "rent";
+    case TraceStage::Return: return "return";
+    case TraceStage::Charge: return "charge";
+    case TraceStage::Lock: return "lock";
+    case TraceStage::Lookup: return "find_vehicle";
+    case TraceStage::Pricing: return "pricing";
+    case TraceStage::Start: return "start";
+    case TraceStage::ActiveRentals: return "active_rentals";
+    case TraceStage::Journal: return "journal_append";
+    case TraceStage::Commit: return "journal_commit";
+    case TraceStage::Log: return "log";
+    case TraceStage::Stdout: return "stdout";
+    case TraceStage::Count: break;
+    }
+    return "unknown";
+}
+
+// one finished span as returned by Tracer::collect; times in ticks
+struct TraceEvent {
+    std::uint64_t startTicks;
+    std::uint64_t endTicks;
+    std::uint32_t thread; // 1-based, in order of each thread's first sampled call
+    TraceStage stage;
+    std::uint8_t depth;   // 0 for the call, 1 for its stages, ...
+    int vehicleId;        // of the call the span belongs to
+};
+
+class Tracer {
+public:
+    // Only the owning thread writes a ring; collect() copies it concurrently
+    // and keeps only the spans that were not overwritten meanwhile.
+    struct Ring {
+        struct Slot {
+            std::atomic<std::uint64_t> start{0}, end{0};
+            std::atomic<std::uint64_t> meta{0}; // stage | depth << 8 | vehicle id << 32
+        };
+        std::atomic<std::uint64_t> head{0}; // spans ever written
+        std::uint32_t thread = 0;
+        std::unique_ptr<Slot[]> slots;
+
+        void push(std::uint64_t start, std::uint64_t end, TraceStage stage, std::uint32_t depth, int vehicleId,
+                  std::uint64_t mask) {
+            const std::uint64_t h = head.load(std::memory_order_relaxed);
+            // as in a seqlock writer: a collect() that reads any of the stores
+            // below also sees head >= h, so it drops the span they overwrite
+            std::atomic_thread_fence(std::memory_order_release);
+            Slot &s = slots[h & mask];
+            s.start.store(start, std::memory_order_relaxed);
+            s.end.store(end, std::memory_order_relaxed);
+            s.meta.store(static_cast<std::uint64_t>(stage) | static_cast<std::uint64_t>(depth & 0xFF) << 8 |
+                         static_cast<std::uint64_t>(static_cast<std::uint32_t>(vehicleId)) << 32,
+                         std::memory_order_relaxed);
+            head.store(h + 1, std::memory_order_release);
+        }
+    };
+
+    // the traced call the calling thread is in, shared by every tracer
+    struct ThreadState {
+        Tracer *tracer = nullptr; // of the sampled call in progress
+        Ring *ring = nullptr;
+        std::uint32_t depth = 0;  // open spans of that call
+        int vehicleId = 0;
+        std::uint32_t sampleClock = 0;
+    };
+    static thread_local ThreadState current;
+
+    // a traced call reads the TSC twice per span, about a dozen spans per
+    // rent + return; 1 in 256 keeps that well under 1% of the call on average
+    static constexpr std::uint32_t kDefaultSampleEvery = 256;
+
+    // sampleEvery is rounded down to a power of two, 0 pauses tracing;
+    // each thread keeps its last ringSpans spans (rounded up to a power of two)
+    explicit Tracer(std::uint32_t sampleEvery = kDefaultSampleEvery, std::size_t ringSpans = 1 << 14) {
+        while (ringMask + 1 < ringSpans) ringMask = ringMask << 1 | 1;
+        setSampleEvery(sampleEvery);
+        metrics::nsPerTick(); // pins the tick calibration origin
+    }
+
+    Tracer(const Tracer&) = delete;
+    Tracer& operator=(const Tracer&) = delete;
+
+    void setSampleEvery(std::uint32_t every) {
+        std::uint32_t mask = 0;
+        while (every > 1 && (mask << 1 | 1) < every) mask = mask << 1 | 1;
+        sampleMask.store(every == 0 ? kPaused : mask, std::memory_order_relaxed);
+    }
+
+    // starts a call span on this thread if this call is sampled
+    bool beginCall(int vehicleId) {
+        const std::uint32_t mask = sampleMask.load(std::memory_order_relaxed);
+        ThreadState &t = current;
+        if (mask == kPaused || (t.sampleClock++ & mask) != 0) return false;
+        t.tracer = this;
+        t.ring = &local();
+        t.vehicleId = vehicleId;
+        return true;
+    }
+
+    std::uint64_t ringMaskValue() const { return ringMask; }
+
+    // the spans still held by every thread's ring, by thread then start
+    std::vector<TraceEvent> collect() const {
+        std::vector<TraceEvent> out;
+        std::lock_guard<std::mutex> lk(mutex);
+        for (const Ring &r : rings) {
+            const std::uint64_t head = r.head.load(std::memory_order_acquire);
+            const std::uint64_t first = head > ringMask + 1 ? head - ringMask - 1 : 0;
+            const std::size_t mark = out.size();
+            for (std::uint64_t i = first; i < head; ++i) {
+                const Ring::Slot &s = r.slots[i & ringMask];
+                const std::uint64_t meta = s.meta.load(std::memory_order_relaxed);
+                out.push_back(TraceEvent{s.start.load(std::memory_order_relaxed), s.end.load(std::memory_order_relaxed),
+                                         r.thread, static_cast<TraceStage>(meta & 0xFF),
+                                         static_cast<std::uint8_t>(meta >> 8),
+                                         static_cast<int>(static_cast<std::uint32_t>(meta >> 32))});
+            }
+            // drop what the owner overwrote while we copied
+            std::atomic_thread_fence(std::memory_order_acquire);
+            const std::uint64_t after = r.head.load(std::memory_order_relaxed);
+            const std::uint64_t valid = after > ringMask ? after - ringMask : 0;
+            if (valid > first) out.erase(out.begin() + static_cast<std::ptrdiff_t>(mark),
+                                         out.begin() + static_cast<std::ptrdiff_t>(mark + std::min(valid, head) - first));
+        }
+        std::stable_sort(out.begin(), out.end(), [](const TraceEvent &a, const TraceEvent &b) {
+            return a.thread != b.thread ? a.thread < b.thread : a.startTicks < b.startTicks;
+        });
+        return out;
+    }
+
+    // Chrome trace event JSON ("X" complete events, microseconds since the
+    // tracer was built); load it in chrome://tracing or ui.perfetto.dev
+    void writeChromeTrace(std::ostream &out) const {
+        const std::vector<TraceEvent> events = collect();
+        const double usPerTick = metrics::nsPerTick() / 1000.0;
+        std::string text = "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+        char buf[160];
+        std::uint32_t named = 0;
+        bool first = true;
+        for (const TraceEvent &e : events) {
+            if (e.thread != named) {
+                named = e.thread;
+                std::snprintf(buf, sizeof(buf),
+                              "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"thread %u\"}}",
+                              first ? "" : ",", e.thread, e.thread);
+                text += buf;
+                first = false;
+            }
+            const double ts = static_cast<double>(e.startTicks - std::min(e.startTicks, originTicks)) * usPerTick;
+            const double dur = static_cast<double>(e.endTicks - std::min(e.endTicks, e.startTicks)) * usPerTick;
+            std::snprintf(buf, sizeof(buf),
+                          ",\n{\"name\":\"%s\",\"cat\":\"rental\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f,"
+                          "\"args\":{\"vehicle\":%d}}",
+                          toString(e.stage), e.thread, ts, dur, e.vehicleId);
+            text += buf;
+        }
+        text += "\n]}\n";
+        out << text;
+    }
+
+    // spans recorded since the tracer was built, dropped ones included
+    std::uint64_t recorded() const {
+        std::lock_guard<std::mutex> lk(mutex);
+        std::uint64_t n = 0;
+        for (const Ring &r : rings) n += r.head.load(std::memory_order_relaxed);
+        return n;
+    }
+
+private:
+    static constexpr std::uint32_t kPaused = 0xFFFFFFFFu;
+
+    const std::uint64_t originTicks = metrics::ticks();
+    std::uint64_t ringMask = 0;
+    std::atomic<std::uint32_t> sampleMask{0};
+    mutable std::mutex mutex; // guards rings and owners
+    std::deque<Ring> rings;
+    std::unordered_map<std::thread::id, Ring*> owners;
+
+    // only called for sampled calls, so the lookup stays off the common path
+    Ring& local() {
+        std::lock_guard<std::mutex> lk(mutex);
+        Ring *&slot = owners[std::this_thread::get_id()];
+        if (!slot) {
+            Ring &r = rings.emplace_back();
+            r.thread = static_cast<std::uint32_t>(rings.size());
+            r.slots.reset(new Ring::Slot[ringMask + 1]);
+            slot = &r;
+        }
+        return *slot;
+    }
+};
+
+thread_local Tracer::ThreadState Tracer::current;
+
+// One stage of a traced call, closed by the destructor or end(). With a call
+// stage (Rent, Return, Charge) at the top it decides whether the call is
+// sampled; any other stage records only inside a sampled call.
+class TraceSpan {
+    Tracer::Ring *ring = nullptr;
+    std::uint64_t start = 0;
+    TraceStage stage;
+
+public:
+    TraceSpan(Tracer *tracer, TraceStage s, int vehicleId = 0) : stage(s) {
+        if (!tracer) return;
+        Tracer::ThreadState &t = Tracer::current;
+        if (t.depth == 0) {
+            if (s > TraceStage::Charge || !tracer->beginCall(vehicleId)) return;
+        } else if (t.tracer != tracer) {
+            return;
+        }
+        ring = t.ring;
+        ++t.depth;
+        start = metrics::ticks();
+    }
+
+    ~TraceSpan() { end(); }
+
+    void end() {
+        if (!ring) return;
+        const std::uint64_t stop = metrics::ticks();
+        Tracer::ThreadState &t = Tracer::current;
+        --t.depth;
+        ring->push(start, stop, stage, t.depth, t.vehicleId, t.tracer->ringMaskValue());
+        if (t.depth == 0) t.tracer = nullptr;
+        ring = nullptr;
+    }
+
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+};
+
+// Tariff is a pricing policy (StandardTariff, RuntimeTariff or a fixed
+// regional one, see TariffRates). With a constexpr tariff the fees compile to
+// constants; RentalManager is the standard-tariff instantiation.
+template <class Tariff>
+class BasicRentalManager {
+    // rentals: vehicleId -> (member, dueDate)
+    struct RentalInfo {
+        MemberHandle member = kNoMember;
+        std::chrono::system_clock::time_point dueDate;
+        double expectedLoadKg = 0.0; // used if truck
+        std::uint32_t serial = 0;    // matches this rental's due-index entry
+        double quotedCost = 0.0;     // rent-time quote, 0 for restored or replayed rentals
+    };
+
+    // a rentWhenReady call parked on one vehicle until it is returned or charged
+    struct RentWaiter {
+        std::unique_ptr<RentWaiter> next; // FIFO per slot
+        MemberHandle member;
+        std::string memberId;
+        int vehicleId;
+        int days;
+        double loadKg;
+        RentalStatus waitingOn; // NotAvailable or BatteryLow, the last attempt's status
+        std::function<void(const RentalOutcome&)> done;
+        RentExecutor *executor;
+        std::uint32_t serial; // low half of its RentWaitId
+    };
+
+    struct WaitQueue {
+        std::unique_ptr<RentWaiter> head;
+        RentWaiter *tail = nullptr;
+    };
+
+    // waiters whose rent was retried under a shard lock, completed after it is released
+    struct ServedWaiters {
+        std::vector<std::pair<std::unique_ptr<RentWaiter>, RentalOutcome>> items;
+        std::uint64_t seq = 0; // journal sequence of their rents
+    };
+
+    // Due-date index entry. The per-shard heap is lazy: a return leaves its
+    // entry behind and pops skip entries whose serial no longer matches the
+    // active rental. The heap is rebuilt from activeRentals once stale entries
+    // outnumber live ones, so it stays within ~2x the active rentals.
+    struct DueEntry {
+        std::int64_t dueNs;
+        int vehicleId;
+        std::uint32_t serial;
+    };
+
+    // std heap algorithms build a max-heap; ordering by "later" puts the earliest due date on top
+    static bool dueLater(const DueEntry &a, const DueEntry &b) { return a.dueNs > b.dueNs; }
+
+    // one lock stripe: the vehicles whose id maps here plus their active rentals
+    struct alignas(64) Shard {
+        std::mutex mutex;
+        std::vector<Vehicle*> vehicles; // slot -> vehicle, owned by the pools below
+        SlabPool<Car> cars;
+        SlabPool<Truck> trucks;
+        SlabPool<ElectricCar> evs;
+        std::vector<std::unique_ptr<Vehicle>> extensions; // kind Other, copied through clone()
+        FleetColumns columns; // same slots as vehicles; mirrors rented/charge state
+        AvailabilityIndex available; // free vehicles by kind and capacity/load/charge
+        VehicleIndex index;   // shard key -> slot
+        FlatIntMap<RentalInfo> activeRentals;
+        std::vector<DueEntry> dueHeap; // min-heap on dueNs over activeRentals (plus stale entries)
+        std::uint32_t nextSerial = 0;
+        std::vector<ReservationCalendar> calendars; // by slot, grown on the first booking
+        std::uint32_t nextReservation = 0;
+        // Trucks by maxLoadKg for reserveTruck, every index-resolved truck
+        // free or not; extended from the columns and re-sorted on demand
+        std::vector<std::pair<double, std::uint32_t>> trucksByLoad;
+        std::size_t trucksScanned = 0; // column slots already looked at
+        std::vector<WaitQueue> waiters; // by slot, grown on the first rentWhenReady that waits
+        std::size_t waiting = 0;        // waiters over all slots
+        std::uint32_t nextWait = 0;     // last RentWaitId serial handed out
+        PublishedTotals totals; // per-kind counts plus revenue and charge totals, see fleetTotals()
+
+        // keep the per-kind counts in step with columns.rented; the caller publishes
+        void tallyAdded(VehicleKind kind, bool rented) {
+            FleetTotals &t = totals.edit();
+            ++t.vehicles[static_cast<std::size_t>(kind)];
+            if (rented) ++t.rented[static_cast<std::size_t>(kind)];
+        }
+
+        void tallyRented(VehicleKind kind, bool rented) {
+            FleetTotals &t = totals.edit();
+            if (rented) ++t.rented[static_cast<std::size_t>(kind)];
+            else --t.rented[static_cast<std::size_t>(kind)];
+        }
+
+        // copies v into the pool for its kind
+        Vehicle* adopt(const Vehicle &v) {
+            switch (v.getKind()) {
+            case VehicleKind::Car: return cars.create(static_cast<const Car&>(v));
+            case VehicleKind::Truck: return trucks.create(static_cast<const Truck&>(v));
+            case VehicleKind::Electric: return evs.create(static_cast<const ElectricCar&>(v));
+            default:
+                extensions.push_back(v.clone());
+                return extensions.back().get();
+            }
+        }
+    };
+
+    // position of a vehicle in insertion order, used by listFleet
+    struct FleetRef {
+        std::uint32_t shard;
+        std::uint32_t slot;
+    };
+
+    Logger &logger;
+    ManagerOptions opts;
+    Clock *clock;
+    MemberRegistry members;
+    Tariff tariff;
+    std::size_t shardCount;
+    unsigned shardBits;
+    std::unique_ptr<Shard[]> shards;
+    std::mutex orderMutex; // guards fleetOrder in concurrent mode
+    std::vector<FleetRef> fleetOrder;
+    std::function<void(const OverdueRental&)> overdueCallback;
+    std::atomic<std::size_t> anyCursor{0}; // rotating first shard for rentAny
+    MetricsRecorder recorder{opts.latencySampleEvery};
+
+    std::size_t shardOf(int vehicleId) const {
+        return static_cast<std::size_t>(static_cast<unsigned>(vehicleId)) & (shardCount - 1);
+    }
+
+    // ids inside a shard share their low bits, so drop them to keep the dense index compact
+    int shardKey(int vehicleId) const {
+        return vehicleId >= 0 ? (vehicleId >> shardBits) : vehicleId;
+    }
+
+    Shard& shardFor(int vehicleId) const { return shards[shardOf(vehicleId)]; }
+
+    // helper to find a vehicle's slot by id (O(1) through the shard index); caller holds the shard lock
+    std::uint32_t findSlot(const Shard &sh, int vehicleId) const {
+        return sh.index.find(shardKey(vehicleId));
+    }
+
+    Vehicle* findVehicle(const Shard &sh, int vehicleId) const {
+        std::uint32_t slot = findSlot(sh, vehicleId);
+        return slot == VehicleIndex::npos ? nullptr : sh.vehicles[slot];
+    }
+
+    // every isRented change goes through here so the columns and the
+    // availability index stay in sync
+    static void markRented(Shard &sh, std::uint32_t slot, bool rented) {
+        sh.vehicles[slot]->setRented(rented);
+        if ((sh.columns.rented[slot] != 0) != rented) sh.tallyRented(sh.columns.kind[slot], rented);
+        sh.columns.rented[slot] = rented ? 1 : 0;
+        if (rented) sh.available.remove(slot);
+        else sh.available.add(slot, sh.columns, *sh.vehicles[slot]);
+    }
+
+    std::chrono::system_clock::time_point daysFromNow(int days) {
+        return clock->now() + std::chrono::hours(24LL * days);
+    }
+
+    void echo(const std::string &msg) const {
+        if (opts.echoToStdout) std::cout << msg << std::endl;
+    }
+
+    // false when both the log and stdout are off, so success lines need not be formatted
+    bool reporting() const { return logger.enabled() || opts.echoToStdout; }
+
+    // Journal frames for a transition that just happened. The caller still holds
+    // the shard lock, so frame order matches the order of the state changes;
+    // commitJournal() waits for durability after the lock is released.
+    // Each returns the frame's sequence, 0 without a journal.
+    std::uint64_t journalRent(const Shard &sh, int vehicleId, std::string_view memberId) {
+        if (!opts.journal) return 0;
+        TraceSpan span(opts.tracer, TraceStage::Journal);
+        const RentalInfo &info = *sh.activeRentals.find(vehicleId);
+        JournalRent r{toEpochNs(info.dueDate), info.expectedLoadKg};
+        return opts.journal->append(JournalOp::Rent, vehicleId, &r, sizeof(r), memberId);
+    }
+
+    // a severe-damage return still releases the vehicle, so it is journaled too
+    std::uint64_t journalReturn(const RentalOutcome &o) {
+        if (!opts.journal || !(o.ok() || o.status == RentalStatus::SevereDamage)) return 0;
+        TraceSpan span(opts.tracer, TraceStage::Journal);
+        return opts.journal->append(JournalOp::Return, o.vehicleId, nullptr, 0);
+    }
+
+    std::uint64_t journalCharge(int vehicleId, double kwh) {
+        if (!opts.journal) return 0;
+        TraceSpan span(opts.tracer, TraceStage::Journal);
+        return opts.journal->append(JournalOp::Charge, vehicleId, &kwh, sizeof(kwh));
+    }
+
+    void commitJournal(std::uint64_t seq) {
+        if (!seq) return;
+        TraceSpan span(opts.tracer, TraceStage::Commit);
+        opts.journal->commit(seq);
+    }
+
+    // Constructs a Car, Truck or ElectricCar in place in the shard's pool and
+    // adds its column and index entries (snapshot load and import); caller
+    // holds the shard lock and publishes the totals
+    std::uint32_t placeVehicle(Shard &sh, VehicleKind kind, int id, const std::string &model, double dailyRate,
+                               double spec, double chargeKwh, bool rented) {
+        Vehicle *v;
+        switch (kind) {
+        case VehicleKind::Car:
+            v = sh.cars.create(id, model, dailyRate, static_cast<int>(spec));
+            break;
+        case VehicleKind::Truck:
+            v = sh.trucks.create(id, model, dailyRate, spec);
+            break;
+        default:
+            v = sh.evs.create(id, model, dailyRate, spec, chargeKwh);
+            break;
+        }
+        v->setRented(rented);
+        sh.vehicles.push_back(v);
+        std::uint32_t slot = sh.columns.append(*v);
+        sh.tallyAdded(kind, rented);
+        if (sh.index.insert(shardKey(id), slot) && !rented) sh.available.add(slot, sh.columns, *v);
+        return slot;
+    }
+
+    // snapshot/journal record of a Car, Truck or ElectricCar; the model offset is left to the caller
+    static SnapshotVehicle snapshotRecord(const FleetColumns &c, std::uint32_t slot, const Vehicle &v) {
+        SnapshotVehicle r{};
+        r.id = c.id[slot];
+        r.kind = c.kind[slot];
+        r.rented = c.rented[slot];
+        r.dailyRate = c.dailyRate[slot];
+        r.modelLength = static_cast<std::uint32_t>(c.model(slot).size());
+        switch (r.kind) {
+        case VehicleKind::Car:
+            r.spec = static_cast<const Car&>(v).getPassengerCapacity();
+            break;
+        case VehicleKind::Truck:
+            r.spec = c.maxLoadKg[slot];
+            break;
+        default:
+            r.spec = c.batteryCapacityKwh[slot];
+            r.chargeKwh = c.chargeKwh[slot];
+            break;
+        }
+        return r;
+    }
+
+    // a pooled-kind vehicle rebuilt from its record
+    static std::unique_ptr<Vehicle> vehicleFromRecord(const SnapshotVehicle &r, const std::string &model) {
+        std::unique_ptr<Vehicle> v;
+        switch (r.kind) {
+        case VehicleKind::Car:
+            v = std::make_unique<Car>(r.id, model, r.dailyRate, static_cast<int>(r.spec));
+            break;
+        case VehicleKind::Truck:
+            v = std::make_unique<Truck>(r.id, model, r.dailyRate, r.spec);
+            break;
+        case VehicleKind::Electric:
+            v = std::make_unique<ElectricCar>(r.id, model, r.dailyRate, r.spec, r.chargeKwh);
+            break;
+        default:
+            return nullptr;
+        }
+        v->setRented(r.rented != 0);
+        return v;
+    }
+
+    // every shard lock, always taken in index order, for whole-fleet consistent views
+    std::vector<std::unique_ptr<ShardGuard>> lockAllShards() const {
+        std::vector<std::unique_ptr<ShardGuard>> locks;
+        locks.reserve(shardCount);
+        for (std::size_t s = 0; s < shardCount; ++s) {
+            locks.push_back(std::make_unique<ShardGuard>(shards[s].mutex, opts.concurrent));
+        }
+        return locks;
+    }
+
+public:
+    BasicRentalManager(Logger &log, const ManagerOptions &options = ManagerOptions(), Tariff pricing = Tariff())
+        : logger(log), opts(options), clock(options.clock ? options.clock : &SystemClock::instance()),
+          members(options.concurrent ? options.shardCount : 1, options.concurrent), tariff(pricing) {
+        shardCount = 1;
+        shardBits = 0;
+        if (opts.concurrent) {
+            while (shardCount < opts.shardCount) {
+                shardCount <<= 1;
+                ++shardBits;
+            }
+        }
+        shards.reset(new Shard[shardCount]);
+    }
+
+    // rentWhenReady calls still parked complete with the status they waited
+    // on, through their executors like any other completion. All of them are
+    // unlinked from the shards first; their callbacks must not touch the
+    // manager, which is going away (a null executor runs them right here).
+    ~BasicRentalManager() {
+        std::vector<std::unique_ptr<RentWaiter>> parked;
+        for (std::size_t s = 0; s < shardCount; ++s) {
+            for (WaitQueue &q : shards[s].waiters) {
+                for (std::unique_ptr<RentWaiter> w = std::move(q.head); w; ) {
+                    std::unique_ptr<RentWaiter> next = std::move(w->next);
+                    parked.push_back(std::move(w));
+                    w = std::move(next);
+                }
+                q.tail = nullptr;
+            }
+            shards[s].waiting = 0;
+        }
+        for (std::unique_ptr<RentWaiter> &w : parked) completeWait(w->executor, std::move(w->done), abandonedWait(*w));
+    }
+
+    bool isConcurrent() const { return opts.concurrent; }
+    Clock& getClock() const { return *clock; }
+    std::size_t getShardCount() const { return shardCount; }
+
+    // add vehicle (copies it into the shard's pool for its kind to keep ownership)
+    void addVehicle(const Vehicle &v) {
+        MethodTimer timer(recorder, MetricsMethod::AddVehicle);
+        commitJournal(insertVehicle(v, true));
+    }
+
+    // read-only lookup for callers that only need to inspect a vehicle;
+    // in concurrent mode the pointed-to state may change under the caller
+    const Vehicle* getVehicle(int vehicleId) const {
+        Shard &sh = shardFor(vehicleId);
+        ShardGuard lk(sh.mutex, opts.concurrent);
+        return findVehicle(sh, vehicleId);
+    }
+
+    std::size_t fleetSize() {
+        ShardGuard lk(orderMutex, opts.concurrent);
+        return fleetOrder.size();
+    }
+
+private:
+    // addVehicle without the durability wait; replay passes journaled=false.
+    // Returns the journal sequence, 0 if nothing was journaled.
+    std::uint64_t insertVehicle(const Vehicle &v, bool journaled) {
+        std::size_t s = shardOf(v.getId());
+        Shard &sh = shards[s];
+        ShardGuard lk(sh.mutex, opts.concurrent);
+        sh.vehicles.push_back(sh.adopt(v));
+        std::uint32_t slot = sh.columns.append(v);
+        sh.tallyAdded(v.getKind(), v.getIsRented());
+        sh.totals.publish();
+        // duplicate ids keep resolving to the first vehicle, as the old linear scan did,
+        // so only the first one is offered to rentAny
+        if (sh.index.insert(shardKey(v.getId()), slot) && !v.getIsRented()) {
+            sh.available.add(slot, sh.columns, *sh.vehicles[slot]);
+        }
+        std::uint64_t seq = 0;
+        if (journaled && opts.journal && v.getKind() != VehicleKind::Other) {
+            SnapshotVehicle r = snapshotRecord(sh.columns, slot, v);
+            std::string_view model = sh.columns.model(slot);
+            r.modelOffset = 0;
+            seq = opts.journal->append(JournalOp::AddVehicle, v.getId(), &r, sizeof(r), model);
+        }
+        // still under the shard lock, so a snapshot never sees the frame without the vehicle
+        ShardGuard orderLock(orderMutex, opts.concurrent);
+        fleetOrder.push_back(FleetRef{static_cast<std::uint32_t>(s), slot});
+        return seq;
+    }
+
+    // Records an active rental and indexes its due date; caller holds the shard lock
+    void recordRental(Shard &sh, int vehicleId, MemberHandle member, std::chrono::system_clock::time_point due,
+                      double loadKg, double quotedCost) {
+        RentalInfo &info = sh.activeRentals.claim(vehicleId);
+        info.member = member;
+        info.dueDate = due;
+        info.expectedLoadKg = loadKg;
+        info.quotedCost = quotedCost;
+        info.serial = ++sh.nextSerial;
+        sh.dueHeap.push_back(DueEntry{toEpochNs(due), vehicleId, info.serial});
+        if (sh.dueHeap.size() >= 2 * sh.activeRentals.size() + 64) {
+            // drop stale entries in place (at least half of them), so the work
+            // is amortized O(1) per rent and the vector never reallocates
+            auto live = [&](const DueEntry &e) {
+                const RentalInfo *r = sh.activeRentals.find(e.vehicleId);
+                return r && r->serial == e.serial;
+            };
+            sh.dueHeap.erase(std::partition(sh.dueHeap.begin(), sh.dueHeap.end(), live), sh.dueHeap.end());
+            std::make_heap(sh.dueHeap.begin(), sh.dueHeap.end(), dueLater);
+        } else {
+            std::push_heap(sh.dueHeap.begin(), sh.dueHeap.end(), dueLater);
+        }
+    }
+
+    // whole days late at `now`, counting a started day as one; 0 if not past due
+    static int lateDays(std::chrono::system_clock::time_point now, std::chrono::system_clock::time_point due) {
+        if (now <= due) return 0;
+        auto diff = std::chrono::duration_cast<std::chrono::hours>(now - due).count();
+        return static_cast<int>(diff / 24) + 1; // at least 1 day
+    }
+
+    // days late times the tariff's lateFeePerDay
+    double lateFee(int days) const { return days * tariff.rates().lateFeePerDay; }
+
+    static ReservationId reservationId(int vehicleId, std::uint32_t serial) {
+        return (static_cast<ReservationId>(static_cast<std::uint32_t>(vehicleId)) << 32) | serial;
+    }
+
+    static int reservationVehicle(ReservationId id) { return static_cast<int>(static_cast<std::uint32_t>(id >> 32)); }
+
+    // rental days a booking of [startNs, endNs) is priced at: started days, at least 1
+    static int bookedDays(std::int64_t startNs, std::int64_t endNs) {
+        constexpr std::int64_t day = 24LL * 3600 * 1000000000LL;
+        return static_cast<int>(std::max<std::int64_t>(1, (endNs - startNs + day - 1) / day));
+    }
+
+    // When the vehicle in slot is back for bookings: its rental's due date (or
+    // now if overdue), never for one added already rented without a rental
+    // record, the start of time when free. Caller holds the shard lock.
+    std::int64_t busyUntilNs(const Shard &sh, std::uint32_t slot, std::int64_t nowNs) const {
+        if (!sh.columns.rented[slot]) return std::numeric_limits<std::int64_t>::min();
+        const RentalInfo *info = sh.activeRentals.find(sh.columns.id[slot]);
+        if (!info) return std::numeric_limits<std::int64_t>::max();
+        return std::max(toEpochNs(info->dueDate), nowNs);
+    }
+
+    // slot can take [startNs, endNs): back from its rental by then and not booked
+    bool bookable(const Shard &sh, std::uint32_t slot, std::int64_t startNs, std::int64_t endNs, std::int64_t nowNs) const {
+        if (startNs < busyUntilNs(sh, slot, nowNs)) return false;
+        return slot >= sh.calendars.size() || sh.calendars[slot].isFree(startNs, endNs);
+    }
+
+    // books slot for [startNs, endNs); caller holds the shard lock
+    // memberId is interned only once the booking is made
+    ReservationOutcome reserveLocked(Shard &sh, std::uint32_t slot, const std::string &memberId, std::int64_t startNs,
+                                     std::int64_t endNs, double loadKg) {
+        ReservationOutcome r;
+        r.vehicleId = sh.columns.id[slot];
+        r.start = fromEpochNs(startNs);
+        r.end = fromEpochNs(endNs);
+        const Vehicle &v = *sh.vehicles[slot];
+        if (v.getKind() == VehicleKind::Truck && loadKg > sh.columns.maxLoadKg[slot]) {
+            r.status = ReservationStatus::Overload;
+            return r;
+        }
+        const std::int64_t nowNs = toEpochNs(clock->now());
+        if (slot < sh.calendars.size()) sh.calendars[slot].dropEnded(nowNs);
+        if (!bookable(sh, slot, startNs, endNs, nowNs)) {
+            r.status = ReservationStatus::Conflict;
+            return r;
+        }
+        if (slot >= sh.calendars.size()) sh.calendars.resize(slot + 1);
+        std::uint32_t serial = ++sh.nextReservation;
+        if (serial == 0) serial = ++sh.nextReservation; // keep ids non-zero after wrapping
+        sh.calendars[slot].insert(ReservationCalendar::Entry{startNs, endNs, loadKg, members.intern(memberId), serial});
+        r.id = reservationId(r.vehicleId, serial);
+        r.quotedCost = rentalCost(v, bookedDays(startNs, endNs), loadKg, tariff.rates());
+        return r;
+    }
+
+    // brings trucksByLoad up to date with the columns; caller holds the shard lock
+    void indexTrucks(Shard &sh) const {
+        const std::size_t n = sh.columns.id.size();
+        if (sh.trucksScanned == n) return;
+        for (std::size_t slot = sh.trucksScanned; slot < n; ++slot) {
+            if (sh.columns.kind[slot] != VehicleKind::Truck) continue;
+            if (findSlot(sh, sh.columns.id[slot]) != slot) continue; // duplicate id, never resolved
+            sh.trucksByLoad.emplace_back(sh.columns.maxLoadKg[slot], static_cast<std::uint32_t>(slot));
+        }
+        sh.trucksScanned = n;
+        std::sort(sh.trucksByLoad.begin(), sh.trucksByLoad.end());
+    }
+
+    // smallest truck of the shard with maxLoadKg >= loadKg that can take
+    // [startNs, endNs), npos if none; caller holds the shard lock
+    std::uint32_t findBookableTruck(Shard &sh, double loadKg, std::int64_t startNs, std::int64_t endNs,
+                                    std::int64_t nowNs) const {
+        indexTrucks(sh);
+        auto it = std::lower_bound(sh.trucksByLoad.begin(), sh.trucksByLoad.end(), std::make_pair(loadKg, 0u));
+        for (; it != sh.trucksByLoad.end(); ++it) {
+            if (bookable(sh, it->second, startNs, endNs, nowNs)) return it->second;
+        }
+        return VehicleIndex::npos;
+    }
+
+    // statuses a rentWhenReady waits out: the vehicle may be returned or charged later
+    static bool worthWaiting(RentalStatus s) { return s == RentalStatus::NotAvailable || s == RentalStatus::BatteryLow; }
+
+    // rentLocked with an extension's start() exception turned into StartFailed
+    // (and kept in startError when given); nothing is marked rented then
+    RentalOutcome tryRentLocked(Shard &sh, MemberHandle member, int vehicleId, int days, double loadKg,
+                                const std::string *newMember = nullptr, std::exception_ptr *startError = nullptr) {
+        try {
+            return rentLocked(sh, member, vehicleId, days, loadKg, newMember);
+        } catch (...) {
+            if (startError) *startError = std::current_exception();
+            RentalOutcome o;
+            o.vehicleId = vehicleId;
+            o.status = RentalStatus::StartFailed;
+            return o;
+        }
+    }
+
+    // Retries the rents parked on vehicleId after a return or charge, oldest
+    // first, until one rents it or the oldest still has to wait. Failures
+    // that waiting cannot fix (an overload, ...) complete as well. Caller
+    // holds the shard lock and completes `served` after releasing it.
+    void serveWaiters(Shard &sh, int vehicleId, ServedWaiters &served) {
+        if (sh.waiting == 0) return;
+        const std::uint32_t slot = findSlot(sh, vehicleId);
+        if (slot == VehicleIndex::npos || slot >= sh.waiters.size()) return;
+        WaitQueue &q = sh.waiters[slot];
+        while (q.head) {
+            RentalOutcome o = tryRentLocked(sh, q.head->member, vehicleId, q.head->days, q.head->loadKg);
+            if (worthWaiting(o.status)) {
+                q.head->waitingOn = o.status;
+                break;
+            }
+            std::unique_ptr<RentWaiter> w = std::move(q.head);
+            q.head = std::move(w->next);
+            if (!q.head) q.tail = nullptr;
+            --sh.waiting;
+            recorder.countOutcome(RentalOp::Rent, o.status);
+            if (o.ok()) served.seq = std::max(served.seq, journalRent(sh, vehicleId, w->memberId));
+            served.items.emplace_back(std::move(w), o);
+            if (o.ok()) break; // taken; the rest wait for the next return
+        }
+    }
+
+    // logs the rents of served waiters and runs their completions; call with
+    // no shard lock held, after committing served.seq
+    void completeServed(ServedWaiters &served) {
+        for (auto &item : served.items) {
+            RentWaiter &w = *item.first;
+            const RentalOutcome &o = item.second;
+            if (o.ok() && reporting()) report(logRecord(LogEvent::Rent, RentalOp::Rent, o, w.days, w.loadKg), w.memberId, true);
+            completeWait(w.executor, std::move(w.done), o);
+        }
+        served.items.clear();
+    }
+
+    // Completes what is left in served when the scope unwinds: waiters handed
+    // a vehicle under the lock still get their outcome when the journal
+    // commit or a log write after it throws (the rent stays applied, like
+    // the caller's own change). Declare it once the shard lock is released;
+    // the normal path empties served through completeServed.
+    class ServedGuard {
+    public:
+        explicit ServedGuard(ServedWaiters &s) : served(s) {}
+        ServedGuard(const ServedGuard&) = delete;
+        ServedGuard& operator=(const ServedGuard&) = delete;
+        ~ServedGuard() {
+            for (auto &item : served.items) {
+                try {
+                    completeWait(item.first->executor, std::move(item.first->done), item.second);
+                } catch (...) {
+                    // a failing executor must not end the unwinding; go on with the rest
+                }
+            }
+        }
+
+    private:
+        ServedWaiters &served;
+    };
+
+    // outcome of a waiter dropped before its vehicle got ready: the status it waited on
+    static RentalOutcome abandonedWait(const RentWaiter &w) {
+        RentalOutcome o;
+        o.vehicleId = w.vehicleId;
+        o.status = w.waitingOn;
+        return o;
+    }
+
+    static void completeWait(RentExecutor *executor, std::function<void(const RentalOutcome&)> done, const RentalOutcome &o) {
+        if (!done) return;
+        if (executor) executor->post([done = std::move(done), o] { done(o); });
+        else done(o);
+    }
+
+    // Core of rentVehicle; caller holds the shard lock. Expected failures come
+    // back as a status, only an extension type's start() may throw. A string
+    // caller passes members.find()'s handle plus newMember, interned only if
+    // the rent goes through, so rejected rents never grow the registry.
+    RentalOutcome rentLocked(Shard &sh, MemberHandle member, int vehicleId, int days, double loadKg,
+                             const std::string *newMember = nullptr) {
+        return rentLocked(sh, member, vehicleId, days, loadKg, daysFromNow(days), newMember);
+    }
+
+    // due is where the rental ends: days from now, or a picked-up booking's end
+    RentalOutcome rentLocked(Shard &sh, MemberHandle member, int vehicleId, int days, double loadKg,
+                             std::chrono::system_clock::time_point due, const std::string *newMember = nullptr) {
+        RentalOutcome o;
+        o.vehicleId = vehicleId;
+        TraceSpan lookupSpan(opts.tracer, TraceStage::Lookup);
+        std::uint32_t slot = findSlot(sh, vehicleId);
+        lookupSpan.end();
+        if (slot == VehicleIndex::npos) {
+            o.status = RentalStatus::NotFound;
+            return o;
+        }
+        Vehicle* v = sh.vehicles[slot];
+        if (v->getIsRented()) {
+            o.status = RentalStatus::NotAvailable;
+            return o;
+        }
+        if (slot < sh.calendars.size() && !sh.calendars[slot].empty() &&
+            !sh.calendars[slot].isFree(toEpochNs(clock->now()), toEpochNs(due))) {
+            o.status = RentalStatus::Reserved;
+            return o;
+        }
+
+        // Truck load check; the kind tag replaces the dynamic_cast<Truck*> probe
+        if (v->getKind() == VehicleKind::Truck) {
+            double maxLoad = static_cast<Truck*>(v)->getMaxLoadKg();
+            if (loadKg > maxLoad) {
+                o.status = RentalStatus::Overload;
+                o.loadKg = loadKg;
+                o.maxLoadKg = maxLoad;
+                return o;
+            }
+        }
+        // Truck uses the rentCost(days, loadKg) overload, others rentCost(int)
+        {
+            TraceSpan span(opts.tracer, TraceStage::Pricing);
+            o.cost = rentalCost(*v, days, loadKg, tariff.rates());
+        }
+
+        // Attempt to start the vehicle
+        TraceSpan startSpan(opts.tracer, TraceStage::Start);
+        switch (v->getKind()) {
+        case VehicleKind::Car:
+        case VehicleKind::Truck:
+            break; // Vehicle::start is a no-op
+        case VehicleKind::Electric:
+            if (!static_cast<ElectricCar*>(v)->canStart()) {
+                o.status = RentalStatus::BatteryLow;
+                return o;
+            }
+            break;
+        default:
+            v->start(); // may throw; manager does not mark rented
+        }
+        startSpan.end();
+
+        // mark as rented and record due date
+        TraceSpan rentalsSpan(opts.tracer, TraceStage::ActiveRentals);
+        if (member == kNoMember && newMember) member = members.intern(*newMember);
+        markRented(sh, slot, true);
+        recordRental(sh, vehicleId, member, due, loadKg, o.cost);
+        FleetTotals &t = sh.totals.edit();
+        ++t.rentals;
+        t.outstandingRevenue += o.cost;
+        sh.totals.publish();
+        return o;
+    }
+
+    // Core of returnVehicle; caller holds the shard lock
+    // member is kNoMember when the caller's id was never interned, which always mismatches
+    RentalOutcome returnLocked(Shard &sh, MemberHandle member, int vehicleId, int actualDays, bool damageFlag) {
+        RentalOutcome o;
+        o.vehicleId = vehicleId;
+        TraceSpan lookupSpan(opts.tracer, TraceStage::Lookup);
+        std::uint32_t slot = findSlot(sh, vehicleId);
+        if (slot == VehicleIndex::npos) {
+            o.status = RentalStatus::NotFound;
+            return o;
+        }
+        const RentalInfo *rental = sh.activeRentals.find(vehicleId);
+        lookupSpan.end();
+        if (!rental) {
+            o.status = RentalStatus::NotRented;
+            return o;
+        }
+        if (rental->member != member) {
+            o.status = RentalStatus::MemberMismatch;
+            return o;
+        }
+
+        // base cost for the actual days; trucks use the recorded expectedLoadKg
+        TraceSpan pricingSpan(opts.tracer, TraceStage::Pricing);
+        const RentalInfo &info = *rental;
+        const auto &rates = tariff.rates(); // one version of a runtime tariff for the whole return
+        o.baseCost = rentalCost(*sh.vehicles[slot], actualDays, info.expectedLoadKg, rates);
+
+        // penalty if late: if now > dueDate
+        const double lateFee = lateDays(clock->now(), info.dueDate) * rates.lateFeePerDay;
+        o.penalty += lateFee;
+
+        // damage handling: if damageFlag true, evaluate severity (simulate threshold)
+        if (damageFlag) {
+            // simulate: severe damage threshold random or deterministic; we'll base on vehicleId for determinism
+            bool severe = (vehicleId % 2 == 0); // simulate: even id -> severe
+            if (severe) {
+                // mark incident; vehicle is still released (depending on policy) but the caller gets an error
+                o.status = RentalStatus::SevereDamage;
+            } else {
+                o.penalty += rates.minorDamageFee;
+                o.minorDamage = true;
+            }
+        }
+
+        o.cost = o.baseCost + o.penalty;
+        pricingSpan.end();
+
+        // finalize return; a severe-damage return still ends the rental, so it is billed too
+        TraceSpan rentalsSpan(opts.tracer, TraceStage::ActiveRentals);
+        FleetTotals &t = sh.totals.edit();
+        ++t.returns;
+        if (o.status == RentalStatus::SevereDamage) ++t.severeDamageReturns;
+        if (o.minorDamage) {
+            ++t.minorDamageReturns;
+            t.damageFees += rates.minorDamageFee;
+        }
+        t.baseRevenue += o.baseCost;
+        t.lateFees += lateFee;
+        t.outstandingRevenue -= info.quotedCost;
+        markRented(sh, slot, false);
+        sh.activeRentals.erase(vehicleId);
+        sh.totals.publish();
+        return o;
+    }
+
+    // Core of chargeBattery; caller holds the shard lock
+    RentalOutcome chargeLocked(Shard &sh, int vehicleId, double kwh) {
+        RentalOutcome o;
+        o.vehicleId = vehicleId;
+        TraceSpan lookupSpan(opts.tracer, TraceStage::Lookup);
+        std::uint32_t slot = findSlot(sh, vehicleId);
+        lookupSpan.end();
+        if (slot == VehicleIndex::npos) {
+            o.status = RentalStatus::NotFound;
+            return o;
+        }
+        Vehicle* v = sh.vehicles[slot];
+        if (v->getKind() != VehicleKind::Electric) {
+            o.status = RentalStatus::NotElectric;
+            return o;
+        }
+        o.chargeKwh = chargeSlot(sh, slot, kwh);
+        return o;
+    }
+
+    // charges the ElectricCar in slot, keeping columns and availability in
+    // step; returns the new charge. Caller holds the shard lock.
+    static double chargeSlot(Shard &sh, std::uint32_t slot, double kwh) {
+        ElectricCar* ev = static_cast<ElectricCar*>(sh.vehicles[slot]);
+        const double capacity = sh.columns.batteryCapacityKwh[slot];
+        const int before = AvailabilityIndex::chargeStep(sh.columns.chargeKwh[slot], capacity);
+        ev->charge(kwh);
+        const double now = ev->getCurrentCharge();
+        FleetTotals &t = sh.totals.edit();
+        ++t.charges;
+        t.chargedKwh += now - sh.columns.chargeKwh[slot];
+        sh.totals.publish();
+        sh.columns.chargeKwh[slot] = now;
+        if (AvailabilityIndex::chargeStep(now, capacity) != before && sh.available.contains(slot)) {
+            // move a free EV to the bucket of its new charge level
+            sh.available.remove(slot);
+            sh.available.add(slot, sh.columns, *ev);
+        }
+        return now;
+    }
+
+    // Runs f(shardIndex) for every shard, spread over worker threads in
+    // concurrent mode (one per core, at most one per shard); f takes the
+    // shard lock itself.
+    template <class F>
+    void forEachShardParallel(F &&f) {
+        std::size_t workers = 1;
+        if (opts.concurrent) {
+            workers = std::min<std::size_t>(shardCount, std::max(1u, std::thread::hardware_concurrency()));
+        }
+        std::atomic<std::size_t> next{0};
+        auto run = [&] {
+            for (std::size_t s; (s = next.fetch_add(1, std::memory_order_relaxed)) < shardCount;) f(s);
+        };
+        std::vector<std::thread> pool;
+        for (std::size_t w = 1; w < workers; ++w) pool.emplace_back(run);
+        run();
+        for (std::thread &t : pool) t.join();
+    }
+
+    // message carried by the exception for a failed outcome
+    static std::string failureMessage(RentalOp op, const RentalOutcome &o) {
+        std::string id = std::to_string(o.vehicleId);
+        switch (o.status) {
+        case RentalStatus::NotFound:
+            if (op == RentalOp::Return) return "Return failed: Vehicle not found id=" + id;
+            if (op == RentalOp::Charge) return "Charge failed: Vehicle not found id=" + id;
+            return "Vehicle not found id=" + id;
+        case RentalStatus::NotAvailable:
+            return "Vehicle not available (already rented) id=" + id;
+        case RentalStatus::Overload:
+            return "Requested load " + std::to_string(o.loadKg) + " > max " + std::to_string(o.maxLoadKg);
+        case RentalStatus::BatteryLow:
+            return "Battery too low to start vehicle id=" + id;
+        case RentalStatus::StartFailed:
+            return "Start failed for vehicle id=" + id;
+        case RentalStatus::NotRented:
+            return "Return failed: Vehicle not rented id=" + id;
+        case RentalStatus::MemberMismatch:
+            return "Return failed: member mismatch for vehicle id=" + id;
+        case RentalStatus::SevereDamage:
+            return "Severe damage reported on return for vehicle id=" + id;
+        case RentalStatus::NotElectric:
+            return "Charge failed: vehicle id=" + id + " is not an EV";
+        case RentalStatus::NoMatch:
+            return "No available vehicle matches the request";
+        case RentalStatus::PartitionUnavailable:
+            return "Partition unavailable for vehicle id=" + id;
+        case RentalStatus::Reserved:
+            return "Vehicle reserved during the rental period id=" + id;
+        case RentalStatus::Ok:
+            break;
+        }
+        return std::string();
+    }
+
+    // line written to the log for a failed outcome
+    static std::string failureLogLine(RentalOp op, const RentalOutcome &o) {
+        switch (o.status) {
+        case RentalStatus::Overload:
+            return "Overload attempt: " + failureMessage(op, o);
+        case RentalStatus::BatteryLow:
+        case RentalStatus::StartFailed:
+            return "Start failed for vehicle id=" + std::to_string(o.vehicleId) + " -> exception thrown while starting";
+        default:
+            return failureMessage(op, o);
+        }
+    }
+
+    // throws the exception type the public throwing API uses for this outcome
+    [[noreturn]] static void throwFailure(RentalOp op, const RentalOutcome &o) {
+        std::string msg = failureMessage(op, o);
+        switch (o.status) {
+        case RentalStatus::NotAvailable:
+        case RentalStatus::NoMatch:
+        case RentalStatus::Reserved: throw VehicleNotAvailable(msg);
+        case RentalStatus::Overload: throw OverloadException(msg);
+        case RentalStatus::BatteryLow: throw BatteryLowException(msg);
+        case RentalStatus::SevereDamage: throw InvalidReturnException(msg);
+        case RentalStatus::PartitionUnavailable: throw PartitionUnavailableException(msg);
+        default: throw VehicleException(msg);
+        }
+    }
+
+    static std::exception_ptr makeError(RentalOp op, const RentalOutcome &o) {
+        try {
+            throwFailure(op, o);
+        } catch (...) {
+            return std::current_exception();
+        }
+    }
+
+    static std::string rentLine(const std::string &memberId, int days, const RentalOutcome &o) {
+        std::ostringstream oss;
+        oss << "Rented vehicle id=" << o.vehicleId << " to member=" << memberId << " for " << days
+            << " days; cost=" << o.cost;
+        return oss.str();
+    }
+
+    static std::string returnLine(const std::string &memberId, const RentalOutcome &o) {
+        std::ostringstream oss;
+        oss << "Vehicle id=" << o.vehicleId << " returned by " << memberId << ". Base=" << o.baseCost
+            << " Penalty=" << o.penalty << " Total=" << o.cost;
+        return oss.str();
+    }
+
+    static std::string minorDamageLine(const RentalOutcome &o) {
+        return "Minor damage fee applied for vehicle id=" + std::to_string(o.vehicleId);
+    }
+
+    static std::string chargeLine(int vehicleId, double kwh, double chargeKwh) {
+        std::ostringstream oss;
+        oss << "Charged EV id=" << vehicleId << " + " << kwh << "kWh (now " << chargeKwh << " kWh)";
+        return oss.str();
+    }
+
+    static std::string chargeRequestLine(const std::string &memberId, int vehicleId) {
+        return "Charge requested by member " + memberId + " for vehicle " + std::to_string(vehicleId);
+    }
+
+    // typed log record of an outcome; amount is the requested load or kWh
+    static LogRecord logRecord(LogEvent event, RentalOp op, const RentalOutcome &o, int days = 0, double amount = 0.0) {
+        LogRecord r;
+        r.event = event;
+        r.op = static_cast<std::uint8_t>(op);
+        r.status = static_cast<std::uint8_t>(o.status);
+        r.flags = o.minorDamage ? kLogMinorDamage : 0;
+        r.vehicleId = o.vehicleId;
+        r.days = days;
+        r.cost = o.cost;
+        r.baseCost = o.baseCost;
+        r.penalty = o.penalty;
+        if (event == LogEvent::Charge) {
+            r.amount = amount;
+            r.level = o.chargeKwh;
+        } else {
+            r.amount = o.status == RentalStatus::Overload ? o.loadKg : amount;
+            r.level = o.maxLoadKg;
+        }
+        return r;
+    }
+
+    // Logs one event: a typed record in a structured log, the formatted line
+    // in a text log. The line is only built when the text log or stdout needs
+    // it. text is the member id (empty when the line has none).
+    void report(const LogRecord &r, const std::string &text, bool echoed) {
+        const bool toStdout = echoed && opts.echoToStdout;
+        TraceSpan logSpan(opts.tracer, TraceStage::Log);
+        if (logger.structured()) {
+            logger.logEvent(r, text);
+            if (!toStdout) return;
+        } else if (!logger.enabled() && !toStdout) {
+            return;
+        }
+        std::string line = logLine(r, text);
+        if (!logger.structured()) logger.log(line);
+        logSpan.end();
+        if (toStdout) {
+            TraceSpan stdoutSpan(opts.tracer, TraceStage::Stdout);
+            echo(line);
+        }
+    }
+
+    // order of request indices grouped by shard, so a batch takes each shard lock once
+    template <class Request>
+    std::vector<std::uint32_t> groupByShard(const std::vector<Request> &requests) const {
+        std::vector<std::uint32_t> order(requests.size());
+        for (std::uint32_t i = 0; i < order.size(); ++i) order[i] = i;
+        if (shardCount > 1) {
+            std::stable_sort(order.begin(), order.end(), [&](std::uint32_t a, std::uint32_t b) {
+                return shardOf(requests[a].vehicleId) < shardOf(requests[b].vehicleId);
+            });
+        }
+        return order;
+    }
+
+    // runs op(request, result) for each request, holding each shard lock once per run of same-shard items
+    template <class Request, class Op>
+    std::vector<BatchResult> runBatch(const std::vector<Request> &requests, Op &&op) {
+        std::vector<BatchResult> results(requests.size());
+        std::vector<std::uint32_t> order = groupByShard(requests);
+        std::size_t i = 0;
+        while (i < order.size()) {
+            std::size_t s = shardOf(requests[order[i]].vehicleId);
+            Shard &sh = shards[s];
+            ShardGuard lk(sh.mutex, opts.concurrent);
+            for (; i < order.size() && shardOf(requests[order[i]].vehicleId) == s; ++i) {
+                op(sh, requests[order[i]], results[order[i]]);
+            }
+        }
+        return results;
+    }
+
+    // one combined log write and stdout write for a whole batch
+    void emitBatch(const std::string &logText, const std::string &echoText) {
+        if (!logText.empty()) logger.log(logText);
+        if (opts.echoToStdout && !echoText.empty()) std::cout << echoText << std::flush;
+    }
+
+    // lock, run the rent core, unlock; logs and echoes on success only.
+    // An extension type's start() exception is a StartFailed outcome (the
+    // exception goes to startError); a journal or log failure after the rent
+    // was applied propagates, as it does from return and charge.
+    // member is kNoMember for an id not seen before; it is interned on success
+    RentalOutcome rentAttempt(MemberHandle member, const std::string &memberId, int vehicleId, int days, double loadKg,
+                              std::exception_ptr *startError = nullptr) {
+        MethodTimer timer(recorder, MetricsMethod::Rent);
+        TraceSpan call(opts.tracer, TraceStage::Rent, vehicleId);
+        Shard &sh = shardFor(vehicleId);
+        TraceSpan lockSpan(opts.tracer, TraceStage::Lock);
+        ShardGuard lk(sh.mutex, opts.concurrent);
+        lockSpan.end();
+        RentalOutcome o = tryRentLocked(sh, member, vehicleId, days, loadKg, &memberId, startError);
+        recorder.countOutcome(RentalOp::Rent, o.status);
+        std::uint64_t seq = o.ok() ? journalRent(sh, vehicleId, memberId) : 0;
+        lk.unlock();
+        commitJournal(seq);
+        if (o.ok() && reporting()) report(logRecord(LogEvent::Rent, RentalOp::Rent, o, days, loadKg), memberId, true);
+        return o;
+    }
+
+    RentalOutcome returnAttempt(MemberHandle member, const std::string &memberId, int vehicleId, int actualDays, bool damageFlag) {
+        MethodTimer timer(recorder, MetricsMethod::Return);
+        TraceSpan call(opts.tracer, TraceStage::Return, vehicleId);
+        Shard &sh = shardFor(vehicleId);
+        TraceSpan lockSpan(opts.tracer, TraceStage::Lock);
+        ShardGuard lk(sh.mutex, opts.concurrent);
+        lockSpan.end();
+        RentalOutcome o = returnLocked(sh, member, vehicleId, actualDays, damageFlag);
+        recorder.countOutcome(RentalOp::Return, o.status);
+        std::uint64_t seq = journalReturn(o);
+        ServedWaiters served;
+        if (o.ok() || o.status == RentalStatus::SevereDamage) serveWaiters(sh, vehicleId, served);
+        lk.unlock();
+        ServedGuard guard(served);
+        commitJournal(std::max(seq, served.seq));
+        if (o.ok() && reporting()) {
+            if (o.minorDamage) report(logRecord(LogEvent::MinorDamage, RentalOp::Return, o), std::string(), false);
+            report(logRecord(LogEvent::Return, RentalOp::Return, o, actualDays), memberId, true);
+        }
+        completeServed(served);
+        return o;
+    }
+
+public:
+    // Member ids are interned on their first successful rent or booking;
+    // callers that keep a handle can use the MemberHandle overloads below and
+    // skip the registry lookup.
+    MemberRegistry& memberRegistry() { return members; }
+    MemberHandle internMember(const std::string &memberId) { return members.intern(memberId); }
+
+    // Non-throwing API. Expected business failures (not found, already rented,
+    // overload, low battery, ...) come back as a status with numeric details and
+    // cost no allocation or logging; describeFailure() rebuilds the message.
+    // Durability failures are not business failures: when the journal or log
+    // write behind an applied rent, return or charge fails, its exception
+    // propagates and the change stays applied in memory.
+    RentalOutcome tryRentVehicle(const std::string &memberId, int vehicleId, int days, double loadKg = 0.0) {
+        return rentAttempt(members.find(memberId), memberId, vehicleId, days, loadKg);
+    }
+
+    RentalOutcome tryRentVehicle(MemberHandle member, int vehicleId, int days, double loadKg = 0.0) {
+        return rentAttempt(member, members.name(member), vehicleId, days, loadKg);
+    }
+
+    RentalOutcome tryReturnVehicle(const std::string &memberId, int vehicleId, int actualDays, bool damageFlag) {
+        return returnAttempt(members.find(memberId), memberId, vehicleId, actualDays, damageFlag);
+    }
+
+    RentalOutcome tryReturnVehicle(MemberHandle member, int vehicleId, int actualDays, bool damageFlag) {
+        return returnAttempt(member, members.name(member), vehicleId, actualDays, damageFlag);
+    }
+
+    // Rents any free vehicle of `kind` that meets the constraints, picked from
+    // the shards' availability indexes instead of scanning the fleet: the
+    // smallest sufficient Car or Truck, the most charged ElectricCar. Shards are
+    // tried from a rotating start so concurrent callers spread out; the pick is
+    // marked rented under the same shard lock. The chosen id comes back in
+    // outcome.vehicleId, NoMatch if nothing qualifies.
+    RentalOutcome tryRentAny(const std::string &memberId, VehicleKind kind, int days,
+                             const RentConstraints &want = RentConstraints()) {
+        MethodTimer timer(recorder, MetricsMethod::RentAny);
+        const MemberHandle member = members.find(memberId);
+        const double loadKg = kind == VehicleKind::Truck ? want.loadKg : 0.0;
+        const std::size_t start = opts.concurrent ? anyCursor.fetch_add(1, std::memory_order_relaxed) : 0;
+        const auto due = daysFromNow(days);
+        const std::int64_t nowNs = toEpochNs(clock->now()), dueNs = toEpochNs(due);
+        for (std::size_t n = 0; n < shardCount; ++n) {
+            Shard &sh = shards[(start + n) & (shardCount - 1)];
+            ShardGuard lk(sh.mutex, opts.concurrent);
+            // free vehicles booked within the rental period are passed over for the next fit
+            auto unbooked = [&](std::uint32_t s) {
+                return s >= sh.calendars.size() || sh.calendars[s].empty() || sh.calendars[s].isFree(nowNs, dueNs);
+            };
+            std::uint32_t slot;
+            switch (kind) {
+            case VehicleKind::Car: slot = sh.available.findCar(want.minCapacity, unbooked); break;
+            case VehicleKind::Truck: slot = sh.available.findTruck(loadKg, unbooked); break;
+            case VehicleKind::Electric: slot = sh.available.findEv(want.minChargeFraction, sh.columns, unbooked); break;
+            default: slot = AvailabilityIndex::npos; break;
+            }
+            if (slot == AvailabilityIndex::npos) continue;
+            const int vehicleId = sh.columns.id[slot];
+            // fails for an EV below its start threshold (this shard's fullest)
+            RentalOutcome o = rentLocked(sh, member, vehicleId, days, loadKg, due, &memberId);
+            if (!o.ok()) continue;
+            recorder.countOutcome(RentalOp::Rent, o.status);
+            std::uint64_t seq = journalRent(sh, vehicleId, memberId);
+            lk.unlock();
+            commitJournal(seq);
+            if (reporting()) report(logRecord(LogEvent::Rent, RentalOp::Rent, o, days, loadKg), memberId, true);
+            return o;
+        }
+        RentalOutcome o;
+        o.status = RentalStatus::NoMatch;
+        recorder.countOutcome(RentalOp::Rent, o.status);
+        return o;
+    }
+
+    RentalOutcome tryChargeBattery(int vehicleId, double kwh) {
+        MethodTimer timer(recorder, MetricsMethod::Charge);
+        TraceSpan call(opts.tracer, TraceStage::Charge, vehicleId);
+        Shard &sh = shardFor(vehicleId);
+        TraceSpan lockSpan(opts.tracer, TraceStage::Lock);
+        ShardGuard lk(sh.mutex, opts.concurrent);
+        lockSpan.end();
+        RentalOutcome o = chargeLocked(sh, vehicleId, kwh);
+        recorder.countOutcome(RentalOp::Charge, o.status);
+        std::uint64_t seq = o.ok() ? journalCharge(vehicleId, kwh) : 0;
+        ServedWaiters served;
+        if (o.ok()) serveWaiters(sh, vehicleId, served);
+        lk.unlock();
+        ServedGuard guard(served);
+        commitJournal(std::max(seq, served.seq));
+        if (o.ok() && reporting()) report(logRecord(LogEvent::Charge, RentalOp::Charge, o, 0, kwh), std::string(), true);
+        completeServed(served);
+        return o;
+    }
+
+    // Prices n (vehicle id, days, load) quotes into out[0..n) without renting:
+    // vehicle fields are gathered from the shards in chunks and priced with
+    // priceBulk. Extension vehicles fall back to their virtual rentCost;
+    // unknown ids yield NaN.
+    void quote(const int *vehicleIds, const std::int32_t *days, const double *loadKg, std::size_t n, double *out) {
+        MethodTimer timer(recorder, MetricsMethod::Quote);
+        constexpr std::size_t kChunk = 256;
+        VehicleKind kind[kChunk];
+        double rate[kChunk], capacity[kChunk], charge[kChunk];
+        std::pair<std::size_t, double> extensions[kChunk];
+        for (std::size_t first = 0; first < n; first += kChunk) {
+            const std::size_t m = std::min(kChunk, n - first);
+            std::size_t extensionCount = 0;
+            for (std::size_t j = 0; j < m; ++j) {
+                const int id = vehicleIds[first + j];
+                Shard &sh = shardFor(id);
+                ShardGuard lk(sh.mutex, opts.concurrent);
+                const std::uint32_t slot = findSlot(sh, id);
+                kind[j] = slot == VehicleIndex::npos ? VehicleKind::Other : sh.columns.kind[slot];
+                rate[j] = slot == VehicleIndex::npos ? 0.0 : sh.columns.dailyRate[slot];
+                capacity[j] = slot == VehicleIndex::npos ? 0.0 : sh.columns.batteryCapacityKwh[slot];
+                charge[j] = slot == VehicleIndex::npos ? 0.0 : sh.columns.chargeKwh[slot];
+                if (slot != VehicleIndex::npos && kind[j] == VehicleKind::Other) {
+                    extensions[extensionCount++] = {j, sh.vehicles[slot]->rentCost(days[first + j])};
+                }
+            }
+            PricingColumns in;
+            in.count = m;
+            in.kind = kind;
+            in.dailyRate = rate;
+            in.days = days + first;
+            in.loadKg = loadKg + first;
+            in.batteryCapacityKwh = capacity;
+            in.chargeKwh = charge;
+            priceBulk(in, out + first, tariff.rates());
+            for (std::size_t e = 0; e < extensionCount; ++e) out[first + extensions[e].first] = extensions[e].second;
+        }
+    }
+
+    // message the throwing API would attach to the exception for this outcome
+    static std::string describeFailure(RentalOp op, const RentalOutcome &o) { return failureMessage(op, o); }
+
+    // the text log line of a binary log record (without the timestamp);
+    // text is the record's member id or message
+    static std::string logLine(const LogRecord &r, std::string_view text) {
+        RentalOutcome o;
+        o.status = static_cast<RentalStatus>(r.status);
+        o.vehicleId = r.vehicleId;
+        o.cost = r.cost;
+        o.baseCost = r.baseCost;
+        o.penalty = r.penalty;
+        o.minorDamage = (r.flags & kLogMinorDamage) != 0;
+        o.loadKg = r.amount;
+        o.maxLoadKg = r.level;
+        const std::string member(text);
+        switch (r.event) {
+        case LogEvent::Rent: return rentLine(member, r.days, o);
+        case LogEvent::Return: return returnLine(member, o);
+        case LogEvent::MinorDamage: return minorDamageLine(o);
+        case LogEvent::Charge: return chargeLine(r.vehicleId, r.amount, r.level);
+        case LogEvent::Failure: return failureLogLine(static_cast<RentalOp>(r.op), o);
+        case LogEvent::ChargeRequest: return chargeRequestLine(member, r.vehicleId);
+        case LogEvent::Text: break;
+        }
+        return member;
+    }
+
+    // throws what the throwing API raises for this outcome; for front ends
+    // that get outcomes from elsewhere (PartitionRouter)
+    [[noreturn]] static void raiseFailure(RentalOp op, const RentalOutcome &o) { throwFailure(op, o); }
+
+    // rentVehicle: optional loadKg default to 0
+    void rentVehicle(const std::string &memberId, int vehicleId, int days, double loadKg = 0.0) noexcept(false) {
+        std::exception_ptr startError;
+        RentalOutcome o = rentAttempt(members.find(memberId), memberId, vehicleId, days, loadKg, &startError);
+        if (!o.ok()) {
+            report(logRecord(LogEvent::Failure, RentalOp::Rent, o), std::string(), false);
+            if (startError) std::rethrow_exception(startError); // the extension's own exception; not rented
+            throwFailure(RentalOp::Rent, o);
+        }
+    }
+
+    // throwing form of tryRentAny; returns the id of the rented vehicle
+    int rentAny(const std::string &memberId, VehicleKind kind, int days,
+                const RentConstraints &want = RentConstraints()) noexcept(false) {
+        RentalOutcome o = tryRentAny(memberId, kind, days, want);
+        if (!o.ok()) {
+            report(logRecord(LogEvent::Failure, RentalOp::Rent, o), std::string(), false);
+            throwFailure(RentalOp::Rent, o);
+        }
+        return o.vehicleId;
+    }
+
+    // returnVehicle
+    void returnVehicle(const std::string &memberId, int vehicleId, int actualDays, bool damageFlag) noexcept(false) {
+        RentalOutcome o = tryReturnVehicle(memberId, vehicleId, actualDays, damageFlag);
+        if (!o.ok()) {
+            report(logRecord(LogEvent::Failure, RentalOp::Return, o), std::string(), false);
+            throwFailure(RentalOp::Return, o);
+        }
+    }
+
+    // Overloaded: chargeBattery(vehicleId, kwh)
+    void chargeBattery(int vehicleId, double kwh) noexcept(false) {
+        RentalOutcome o = tryChargeBattery(vehicleId, kwh);
+        if (!o.ok()) {
+            report(logRecord(LogEvent::Failure, RentalOp::Charge, o), std::string(), false);
+            throwFailure(RentalOp::Charge, o);
+        }
+    }
+
+    // Overloaded: chargeBattery(memberId, vehicleId, kwh) (just example overload)
+    void chargeBattery(const std::string &memberId, int vehicleId, double kwh) noexcept(false) {
+        // could verify member authorized; simple example logs member
+        chargeBattery(vehicleId, kwh);
+        RentalOutcome o;
+        o.vehicleId = vehicleId;
+        report(logRecord(LogEvent::ChargeRequest, RentalOp::Charge, o), memberId, false);
+    }
+
+    // Depot charging window: plans how to spend budget.depotKwh over the free
+    // ElectricCars and applies it, instead of one chargeBattery call per EV.
+    // Energy goes, in this order, to reserved EVs up to the target, to every
+    // EV below its start() threshold up to the threshold (emptiest first),
+    // then to all of them up to the target (emptiest first), each capped at
+    // maxKwhPerVehicle. Shards are scanned and charged in parallel (concurrent
+    // mode); an EV rented between the two steps is skipped. Charges are
+    // journaled like chargeBattery, but the whole window writes one summary
+    // log line.
+    ChargingSummary scheduleCharging(const ChargingBudget &budget) {
+        MethodTimer timer(recorder, MetricsMethod::ScheduleCharging);
+        struct Candidate {
+            std::uint32_t slot;
+            std::uint32_t rank; // tier * kRankSteps + charge fraction step
+            double charge;
+            double capacity;
+            bool reserved;
+            double allocated;
+        };
+        struct Ranked {
+            std::uint32_t shard;
+            std::uint32_t index;
+        };
+        // tiers: reserved 0, below the start threshold 1, rest 2; within a tier
+        // the emptiest come first, ranked to 1/kRankSteps of capacity with a
+        // counting sort (a comparison sort of 100k EVs costs more than the rest)
+        constexpr std::uint32_t kRankSteps = 1024;
+        std::vector<int> reserved = budget.reservedIds;
+        std::sort(reserved.begin(), reserved.end());
+        std::vector<std::vector<Candidate>> perShard(shardCount);
+        forEachShardParallel([&](std::size_t s) {
+            Shard &sh = shards[s];
+            ShardGuard lk(sh.mutex, opts.concurrent);
+            const FleetColumns &c = sh.columns;
+            for (std::uint32_t slot = 0; slot < c.id.size(); ++slot) {
+                if (c.kind[slot] != VehicleKind::Electric || c.rented[slot]) continue;
+                if (c.chargeKwh[slot] >= budget.targetFraction * c.batteryCapacityKwh[slot]) continue;
+                const bool isReserved = std::binary_search(reserved.begin(), reserved.end(), c.id[slot]);
+                const double fraction = c.batteryCapacityKwh[slot] > 0 ? c.chargeKwh[slot] / c.batteryCapacityKwh[slot] : 1.0;
+                const std::uint32_t tier = isReserved ? 0 : (fraction < kEvStartChargeFraction ? 1 : 2);
+                const auto step = static_cast<std::uint32_t>(std::clamp(fraction, 0.0, 1.0) * (kRankSteps - 1));
+                perShard[s].push_back(Candidate{slot, tier * kRankSteps + step, c.chargeKwh[slot],
+                                                c.batteryCapacityKwh[slot], isReserved, 0.0});
+            }
+        });
+
+        std::vector<std::uint32_t> start(3 * kRankSteps + 1, 0);
+        for (const auto &list : perShard) {
+            for (const Candidate &c : list) ++start[c.rank + 1];
+        }
+        for (std::size_t r = 1; r < start.size(); ++r) start[r] += start[r - 1];
+        std::vector<Ranked> ranked(start.back());
+        for (std::size_t s = 0; s < shardCount; ++s) {
+            for (std::uint32_t i = 0; i < perShard[s].size(); ++i) {
+                ranked[start[perShard[s][i].rank]++] = Ranked{static_cast<std::uint32_t>(s), i};
+            }
+        }
+
+        ChargingSummary summary;
+        summary.candidates = ranked.size();
+        double left = std::max(0.0, budget.depotKwh);
+        // tops each ranked EV up to level(c), within the per-vehicle cap and what is left
+        auto fill = [&](bool reservedOnly, auto level) {
+            for (const Ranked &r : ranked) {
+                if (left <= 0.0) return;
+                Candidate &c = perShard[r.shard][r.index];
+                if (reservedOnly && !c.reserved) break; // reserved EVs sort first
+                double want = level(c) - (c.charge + c.allocated);
+                want = std::min({want, budget.maxKwhPerVehicle - c.allocated, left});
+                if (want <= 0.0) continue;
+                c.allocated += want;
+                left -= want;
+            }
+        };
+        auto target = [&](const Candidate &c) { return budget.targetFraction * c.capacity; };
+        fill(true, target);
+        fill(false, [](const Candidate &c) { return kEvStartChargeFraction * c.capacity; });
+        fill(false, target);
+        struct ShardResult {
+            std::size_t charged = 0, madeStartable = 0, stillBelowStart = 0, skipped = 0;
+            double delivered = 0.0;
+            std::uint64_t seq = 0;
+            ServedWaiters served;
+        };
+        std::vector<ShardResult> results(shardCount);
+        forEachShardParallel([&](std::size_t s) {
+            if (perShard[s].empty()) return;
+            Shard &sh = shards[s];
+            ShardResult &res = results[s];
+            ShardGuard lk(sh.mutex, opts.concurrent);
+            for (const Candidate &c : perShard[s]) {
+                if (sh.columns.rented[c.slot]) {
+                    ++res.skipped;
+                    continue;
+                }
+                const double before = sh.columns.chargeKwh[c.slot];
+                const double threshold = kEvStartChargeFraction * sh.columns.batteryCapacityKwh[c.slot];
+                double after = before;
+                if (c.allocated > 0.0) {
+                    after = chargeSlot(sh, c.slot, c.allocated);
+                    res.seq = std::max(res.seq, journalCharge(sh.columns.id[c.slot], c.allocated));
+                    recorder.countOutcome(RentalOp::Charge, RentalStatus::Ok);
+                    ++res.charged;
+                    res.delivered += after - before;
+                }
+                if (before < threshold && after >= threshold) ++res.madeStartable;
+                if (after < threshold) ++res.stillBelowStart;
+                if (c.allocated > 0.0) serveWaiters(sh, sh.columns.id[c.slot], res.served);
+            }
+        });
+        std::uint64_t seq = 0;
+        ServedWaiters served;
+        for (ShardResult &r : results) {
+            summary.charged += r.charged;
+            summary.madeStartable += r.madeStartable;
+            summary.stillBelowStart += r.stillBelowStart;
+            summary.skipped += r.skipped;
+            summary.deliveredKwh += r.delivered;
+            seq = std::max({seq, r.seq, r.served.seq});
+            for (auto &item : r.served.items) served.items.push_back(std::move(item));
+        }
+        ServedGuard guard(served);
+        commitJournal(seq);
+        summary.unusedKwh = std::max(0.0, std::max(0.0, budget.depotKwh) - summary.deliveredKwh);
+
+        if (reporting()) {
+            std::ostringstream oss;
+            oss << "Charging window: charged " << summary.charged << " of " << summary.candidates << " EVs, "
+                << summary.deliveredKwh << " kWh of " << budget.depotKwh << " kWh budget; "
+                << summary.madeStartable << " made startable, " << summary.stillBelowStart << " still below start, "
+                << summary.skipped << " skipped (rented)";
+            logger.log(oss.str());
+            echo(oss.str());
+        }
+        completeServed(served);
+        return summary;
+    }
+
+    // Batch rent: every request is attempted, failures are reported per item
+    // instead of aborting the batch. Requests are grouped by shard so each
+    // lock is taken once, and all log/stdout lines go out in one write each,
+    // in request order.
+    std::vector<BatchResult> rentVehicles(const std::vector<RentRequest> &requests) {
+        MethodTimer timer(recorder, MetricsMethod::RentBatch);
+        std::uint64_t seq = 0;
+        std::vector<BatchResult> results = runBatch(requests, [&](Shard &sh, const RentRequest &r, BatchResult &res) {
+            res.outcome = tryRentLocked(sh, members.find(r.memberId), r.vehicleId, r.days, r.loadKg, &r.memberId,
+                                        &res.error);
+            if (res.outcome.ok()) seq = std::max(seq, journalRent(sh, r.vehicleId, r.memberId));
+        });
+        commitJournal(seq); // one durability wait for the whole batch
+
+        const bool report = reporting();
+        const bool structured = logger.structured();
+        std::string logText, echoText;
+        for (std::size_t i = 0; i < requests.size(); ++i) {
+            const RentalOutcome &o = results[i].outcome;
+            recorder.countOutcome(RentalOp::Rent, o.status);
+            if (!o.ok() && !results[i].error) results[i].error = makeError(RentalOp::Rent, o);
+            if (!report) continue;
+            if (structured) {
+                // one record per item; only the echo needs text
+                const RentRequest &r = requests[i];
+                if (o.ok()) {
+                    logger.logEvent(logRecord(LogEvent::Rent, RentalOp::Rent, o, r.days, r.loadKg), r.memberId);
+                    if (opts.echoToStdout) echoText += rentLine(r.memberId, r.days, o) + '\n';
+                } else {
+                    logger.logEvent(logRecord(LogEvent::Failure, RentalOp::Rent, o));
+                }
+                continue;
+            }
+            std::string line;
+            if (o.ok()) {
+                line = rentLine(requests[i].memberId, requests[i].days, o);
+                echoText += line + '\n';
+            } else {
+                line = failureLogLine(RentalOp::Rent, o);
+            }
+            if (!logText.empty()) logText += '\n';
+            logText += line;
+        }
+        emitBatch(logText, echoText);
+        return results;
+    }
+
+    // Batch return, same contract as rentVehicles
+    std::vector<BatchResult> returnVehicles(const std::vector<ReturnRequest> &requests) {
+        MethodTimer timer(recorder, MetricsMethod::ReturnBatch);
+        std::uint64_t seq = 0;
+        ServedWaiters served;
+        std::vector<BatchResult> results = runBatch(requests, [&](Shard &sh, const ReturnRequest &r, BatchResult &res) {
+            res.outcome = returnLocked(sh, members.find(r.memberId), r.vehicleId, r.actualDays, r.damaged);
+            seq = std::max(seq, journalReturn(res.outcome));
+            if (res.outcome.ok() || res.outcome.status == RentalStatus::SevereDamage) serveWaiters(sh, r.vehicleId, served);
+        });
+        ServedGuard guard(served);
+        commitJournal(std::max(seq, served.seq));
+
+        std::string logText, echoText;
+        auto addLog = [&](const std::string &line) {
+            if (!logText.empty()) logText += '\n';
+            logText += line;
+        };
+        const bool report = reporting();
+        const bool structured = logger.structured();
+        for (std::size_t i = 0; i < requests.size(); ++i) {
+            const RentalOutcome &o = results[i].outcome;
+            recorder.countOutcome(RentalOp::Return, o.status);
+            if (!o.ok()) results[i].error = makeError(RentalOp::Return, o);
+            if (!report) continue;
+            if (structured) {
+                const ReturnRequest &r = requests[i];
+                if (o.ok()) {
+                    if (o.minorDamage) logger.logEvent(logRecord(LogEvent::MinorDamage, RentalOp::Return, o));
+                    logger.logEvent(logRecord(LogEvent::Return, RentalOp::Return, o, r.actualDays), r.memberId);
+                    if (opts.echoToStdout) echoText += returnLine(r.memberId, o) + '\n';
+                } else {
+                    logger.logEvent(logRecord(LogEvent::Failure, RentalOp::Return, o));
+                }
+                continue;
+            }
+            if (o.ok()) {
+                if (o.minorDamage) addLog(minorDamageLine(o));
+                std::string line = returnLine(requests[i].memberId, o);
+                addLog(line);
+                echoText += line + '\n';
+            } else {
+                addLog(failureLogLine(RentalOp::Return, o));
+            }
+        }
+        emitBatch(logText, echoText);
+        completeServed(served);
+        return results;
+    }
+
+    // Called by pollOverdue for every newly overdue rental, outside the shard
+    // locks. Set it before polling starts (e.g. before an OverdueMonitor runs).
+    void setOverdueCallback(std::function<void(const OverdueRental&)> callback) {
+        overdueCallback = std::move(callback);
+    }
+
+    // Rentals that went past their due date since the previous poll, each
+    // reported once per rental. Each shard pops only its due entries off the
+    // due-date heap, so finding k overdue rentals costs O(k log n) and a shard
+    // with nothing due costs one compare: cheap enough to call every second.
+    std::vector<OverdueRental> pollOverdue() {
+        MethodTimer timer(recorder, MetricsMethod::PollOverdue);
+        std::vector<OverdueRental> overdue;
+        const auto now = clock->now();
+        const std::int64_t nowNs = toEpochNs(now);
+        for (std::size_t s = 0; s < shardCount; ++s) {
+            Shard &sh = shards[s];
+            ShardGuard lk(sh.mutex, opts.concurrent);
+            // strictly earlier, matching returnVehicle, which charges only when now > dueDate
+            while (!sh.dueHeap.empty() && sh.dueHeap.front().dueNs < nowNs) {
+                DueEntry e = sh.dueHeap.front();
+                std::pop_heap(sh.dueHeap.begin(), sh.dueHeap.end(), dueLater);
+                sh.dueHeap.pop_back();
+                RentalInfo *info = sh.activeRentals.find(e.vehicleId);
+                if (!info || info->serial != e.serial) continue; // returned (and maybe re-rented) since
+                OverdueRental r;
+                r.vehicleId = e.vehicleId;
+                r.member = info->member;
+                r.dueDate = info->dueDate;
+                r.lateDays = lateDays(now, info->dueDate);
+                r.lateFee = lateFee(r.lateDays);
+                overdue.push_back(r);
+            }
+        }
+        for (OverdueRental &r : overdue) r.memberId = members.name(r.member);
+        if (overdueCallback) {
+            for (const OverdueRental &r : overdue) overdueCallback(r);
+        }
+        return overdue;
+    }
+
+    // Books vehicleId for [start, end) ahead of time, priced in quotedCost at
+    // the current tariff. Conflict if the interval overlaps another booking or
+    // starts before the current rental is due; a walk-in rent whose period
+    // would run into a booking fails with RentalStatus::Reserved instead.
+    // Bookings live in memory only, not in snapshots or the journal.
+    ReservationOutcome tryReserve(const std::string &memberId, int vehicleId, std::chrono::system_clock::time_point start,
+                                  std::chrono::system_clock::time_point end, double loadKg = 0.0) {
+        ReservationOutcome r;
+        r.vehicleId = vehicleId;
+        r.start = start;
+        r.end = end;
+        if (end <= start || end <= clock->now()) {
+            r.status = ReservationStatus::InvalidInterval;
+            return r;
+        }
+        Shard &sh = shardFor(vehicleId);
+        ShardGuard lk(sh.mutex, opts.concurrent);
+        std::uint32_t slot = findSlot(sh, vehicleId);
+        if (slot == VehicleIndex::npos) {
+            r.status = ReservationStatus::NotFound;
+            return r;
+        }
+        return reserveLocked(sh, slot, memberId, toEpochNs(start), toEpochNs(end), loadKg);
+    }
+
+    // Id of a Truck with maxLoadKg >= minLoadKg free for all of [start, end),
+    // the smallest sufficient one of the first shard that has any. Only a
+    // hint once the shard lock is gone; tryReserveTruck books atomically.
+    std::optional<int> findFreeTruck(double minLoadKg, std::chrono::system_clock::time_point start,
+                                     std::chrono::system_clock::time_point end) {
+        const std::int64_t nowNs = toEpochNs(clock->now());
+        for (std::size_t s = 0; s < shardCount; ++s) {
+            Shard &sh = shards[s];
+            ShardGuard lk(sh.mutex, opts.concurrent);
+            std::uint32_t slot = findBookableTruck(sh, minLoadKg, toEpochNs(start), toEpochNs(end), nowNs);
+            if (slot != VehicleIndex::npos) return sh.columns.id[slot];
+        }
+        return std::nullopt;
+    }
+
+    // Books the truck findFreeTruck would pick for loadKg under the same shard
+    // lock; shards are tried from a rotating start, as in tryRentAny. NoMatch
+    // if no truck is free for the interval.
+    ReservationOutcome tryReserveTruck(const std::string &memberId, double loadKg,
+                                       std::chrono::system_clock::time_point start,
+                                       std::chrono::system_clock::time_point end) {
+        ReservationOutcome r;
+        r.start = start;
+        r.end = end;
+        const std::int64_t nowNs = toEpochNs(clock->now());
+        if (end <= start || toEpochNs(end) <= nowNs) {
+            r.status = ReservationStatus::InvalidInterval;
+            return r;
+        }
+        const std::size_t first = opts.concurrent ? anyCursor.fetch_add(1, std::memory_order_relaxed) : 0;
+        for (std::size_t n = 0; n < shardCount; ++n) {
+            Shard &sh = shards[(first + n) & (shardCount - 1)];
+            ShardGuard lk(sh.mutex, opts.concurrent);
+            std::uint32_t slot = findBookableTruck(sh, loadKg, toEpochNs(start), toEpochNs(end), nowNs);
+            if (slot != VehicleIndex::npos) return reserveLocked(sh, slot, memberId, toEpochNs(start), toEpochNs(end), loadKg);
+        }
+        r.status = ReservationStatus::NoMatch;
+        return r;
+    }
+
+    ReservationStatus cancelReservation(const std::string &memberId, ReservationId id) {
+        const int vehicleId = reservationVehicle(id);
+        Shard &sh = shardFor(vehicleId);
+        ShardGuard lk(sh.mutex, opts.concurrent);
+        std::uint32_t slot = findSlot(sh, vehicleId);
+        if (slot == VehicleIndex::npos || slot >= sh.calendars.size()) return ReservationStatus::NotFound;
+        ReservationCalendar &cal = sh.calendars[slot];
+        const ReservationCalendar::Entry *e = cal.find(static_cast<std::uint32_t>(id));
+        if (!e) return ReservationStatus::NotFound;
+        if (e->member != members.find(memberId)) return ReservationStatus::MemberMismatch;
+        cal.erase(e->serial);
+        return ReservationStatus::Ok;
+    }
+
+    // Turns a booking into an active rental from now until the booking's end,
+    // priced for the days started from now, through the same checks as
+    // rentVehicle (and logged and journaled like it). Pickup is only allowed
+    // inside [start, end): the booking stays when it has not started yet
+    // (TooEarly) or the rent fails (RentFailed, details in rental), and is
+    // dropped when it already ended (Expired).
+    ReservationOutcome tryPickUp(const std::string &memberId, ReservationId id) {
+        MethodTimer timer(recorder, MetricsMethod::Rent);
+        ReservationOutcome r;
+        r.id = id;
+        r.vehicleId = reservationVehicle(id);
+        Shard &sh = shardFor(r.vehicleId);
+        ShardGuard lk(sh.mutex, opts.concurrent);
+        std::uint32_t slot = findSlot(sh, r.vehicleId);
+        const ReservationCalendar::Entry *e =
+            slot == VehicleIndex::npos || slot >= sh.calendars.size() ? nullptr : sh.calendars[slot].find(static_cast<std::uint32_t>(id));
+        if (!e) {
+            r.status = ReservationStatus::NotFound;
+            return r;
+        }
+        const ReservationCalendar::Entry booking = *e;
+        r.start = fromEpochNs(booking.startNs);
+        r.end = fromEpochNs(booking.endNs);
+        if (booking.member != members.find(memberId)) {
+            r.status = ReservationStatus::MemberMismatch;
+            return r;
+        }
+        const std::int64_t nowNs = toEpochNs(clock->now());
+        if (nowNs < booking.startNs) {
+            r.status = ReservationStatus::TooEarly;
+            return r;
+        }
+        ReservationCalendar &cal = sh.calendars[slot];
+        cal.erase(booking.serial);
+        if (booking.endNs <= nowNs) {
+            r.status = ReservationStatus::Expired;
+            return r;
+        }
+        try {
+            r.rental = rentLocked(sh, booking.member, r.vehicleId, bookedDays(nowNs, booking.endNs), booking.loadKg, r.end);
+        } catch (...) {
+            r.rental = RentalOutcome();
+            r.rental.vehicleId = r.vehicleId;
+            r.rental.status = RentalStatus::StartFailed;
+        }
+        recorder.countOutcome(RentalOp::Rent, r.rental.status);
+        if (!r.rental.ok()) {
+            cal.insert(booking);
+            r.status = ReservationStatus::RentFailed;
+            return r;
+        }
+        std::uint64_t seq = journalRent(sh, r.vehicleId, memberId);
+        lk.unlock();
+        commitJournal(seq);
+        if (reporting()) {
+            report(logRecord(LogEvent::Rent, RentalOp::Rent, r.rental, bookedDays(nowNs, booking.endNs), booking.loadKg),
+                   memberId, true);
+        }
+        return r;
+    }
+
+    // the vehicle's bookings in time order (ended ones linger until the next booking on it)
+    std::vector<Reservation> reservationsOf(int vehicleId) {
+        std::vector<Reservation> out;
+        std::vector<ReservationCalendar::Entry> entries;
+        {
+            Shard &sh = shardFor(vehicleId);
+            ShardGuard lk(sh.mutex, opts.concurrent);
+            std::uint32_t slot = findSlot(sh, vehicleId);
+            if (slot == VehicleIndex::npos || slot >= sh.calendars.size()) return out;
+            entries = sh.calendars[slot].all();
+        }
+        out.reserve(entries.size());
+        for (const ReservationCalendar::Entry &e : entries) {
+            Reservation r;
+            r.id = reservationId(vehicleId, e.serial);
+            r.vehicleId = vehicleId;
+            r.memberId = members.name(e.member);
+            r.start = fromEpochNs(e.startNs);
+            r.end = fromEpochNs(e.endNs);
+            r.loadKg = e.loadKg;
+            out.push_back(std::move(r));
+        }
+        return out;
+    }
+
+    // Rents vehicleId as soon as it can be: now if it is free and startable,
+    // else once a return frees it or a charge lifts it over its start
+    // threshold, with no thread or poll per request. done gets the final
+    // outcome, the rent or a failure waiting cannot fix (NotFound, Overload,
+    // Reserved, ...), on executor, or inline in the thread that made the
+    // vehicle ready when executor is null. Waiters on one vehicle are served
+    // oldest first; a plain rent can still take the vehicle ahead of them.
+    // Returns the id cancelWaitingRent takes when the call was parked, 0 when
+    // done already has its outcome. done must not call back into the manager
+    // (it may run from the destructor, see there).
+    RentWaitId rentWhenReady(const std::string &memberId, int vehicleId, int days, double loadKg,
+                             std::function<void(const RentalOutcome&)> done, RentExecutor *executor = nullptr) {
+        MethodTimer timer(recorder, MetricsMethod::Rent);
+        MemberHandle member = members.find(memberId);
+        Shard &sh = shardFor(vehicleId);
+        ShardGuard lk(sh.mutex, opts.concurrent);
+        RentalOutcome o = tryRentLocked(sh, member, vehicleId, days, loadKg, &memberId);
+        if (worthWaiting(o.status)) {
+            if (member == kNoMember) member = members.intern(memberId); // a parked waiter keeps its handle
+            const std::uint32_t slot = findSlot(sh, vehicleId);
+            if (slot >= sh.waiters.size()) sh.waiters.resize(std::max<std::size_t>(slot + 1, sh.columns.id.size()));
+            std::uint32_t serial = ++sh.nextWait;
+            if (serial == 0) serial = ++sh.nextWait; // keep ids non-zero after wrapping
+            std::unique_ptr<RentWaiter> w(new RentWaiter{nullptr, member, memberId, vehicleId, days, loadKg,
+                                                         o.status, std::move(done), executor, serial});
+            WaitQueue &q = sh.waiters[slot];
+            RentWaiter *last = w.get();
+            if (q.tail) q.tail->next = std::move(w);
+            else q.head = std::move(w);
+            q.tail = last;
+            ++sh.waiting;
+            return reservationId(vehicleId, serial); // packed like a ReservationId
+        }
+        recorder.countOutcome(RentalOp::Rent, o.status);
+        std::uint64_t seq = o.ok() ? journalRent(sh, vehicleId, memberId) : 0;
+        lk.unlock();
+        commitJournal(seq);
+        if (o.ok() && reporting()) report(logRecord(LogEvent::Rent, RentalOp::Rent, o, days, loadKg), memberId, true);
+        completeWait(executor, std::move(done), o);
+        return 0;
+    }
+
+    // Gives up a parked rentWhenReady: its done gets the status it waited on
+    // (NotAvailable or BatteryLow), through its executor. False when the id
+    // is not parked any more, because it completed or was cancelled already.
+    // A timeout is a cancelWaitingRent from the caller's timer.
+    bool cancelWaitingRent(RentWaitId id) {
+        const int vehicleId = reservationVehicle(id);
+        const std::uint32_t serial = static_cast<std::uint32_t>(id);
+        Shard &sh = shardFor(vehicleId);
+        ShardGuard lk(sh.mutex, opts.concurrent);
+        const std::uint32_t slot = findSlot(sh, vehicleId);
+        if (serial == 0 || slot == VehicleIndex::npos || slot >= sh.waiters.size()) return false;
+        WaitQueue &q = sh.waiters[slot];
+        std::unique_ptr<RentWaiter> *link = &q.head;
+        RentWaiter *prev = nullptr;
+        while (*link && (*link)->serial != serial) {
+            prev = link->get();
+            link = &(*link)->next;
+        }
+        if (!*link) return false;
+        std::unique_ptr<RentWaiter> w = std::move(*link);
+        *link = std::move(w->next);
+        if (q.tail == w.get()) q.tail = prev;
+        --sh.waiting;
+        lk.unlock();
+        completeWait(w->executor, std::move(w->done), abandonedWait(*w));
+        return true;
+    }
+
+#if defined(__cpp_impl_coroutine)
+    // co_await manager.rentWhenReady(member, id, days): the coroutine form of
+    // the call above, resumed with the final RentalOutcome on executor or in
+    // the thread that made the vehicle ready. Completing before the suspend
+    // finishes just carries on without suspending.
+    class RentWhenReadyAwaiter {
+    public:
+        RentWhenReadyAwaiter(BasicRentalManager &m, std::string memberId, int vehicleId, int days, double loadKg,
+                             RentExecutor *executor)
+            : manager(m), member(std::move(memberId)), vehicleId(vehicleId), days(days), loadKg(loadKg),
+              executor(executor) {}
+
+        bool await_ready() const noexcept { return false; }
+
+        bool await_suspend(std::coroutine_handle<> h) {
+            handle = h;
+            manager.rentWhenReady(member, vehicleId, days, loadKg, [this](const RentalOutcome &o) {
+                outcome = o;
+                if (state.exchange(kDone, std::memory_order_acq_rel) == kSuspended) handle.resume();
+            }, executor);
+            // kDone already: completed inline, resume without suspending
+            return state.exchange(kSuspended, std::memory_order_acq_rel) != kDone;
+        }
+
+        RentalOutcome await_resume() const { return outcome; }
+
+    private:
+        static constexpr int kDone = 1, kSuspended = 2;
+        BasicRentalManager &manager;
+        std::string member;
+        int vehicleId, days;
+        double loadKg;
+        RentExecutor *executor;
+        RentalOutcome outcome;
+        std::coroutine_handle<> handle;
+        std::atomic<int> state{0};
+    };
+
+    RentWhenReadyAwaiter rentWhenReady(const std::string &memberId, int vehicleId, int days, double loadKg = 0.0,
+                                       RentExecutor *executor = nullptr) {
+        return RentWhenReadyAwaiter(*this, memberId, vehicleId, days, loadKg, executor);
+    }
+#endif
+
+    // rentWhenReady calls still parked on a vehicle
+    std::size_t waitingRents() {
+        std::size_t n = 0;
+        for (std::size_t s = 0; s < shardCount; ++s) {
+            ShardGuard lk(shards[s].mutex, opts.concurrent);
+            n += shards[s].waiting;
+        }
+        return n;
+    }
+
+    // member currently renting the vehicle, kNoMember if it is not rented
+    MemberHandle renterOf(int vehicleId) {
+        Shard &sh = shardFor(vehicleId);
+        ShardGuard lk(sh.mutex, opts.concurrent);
+        const RentalInfo *info = sh.activeRentals.find(vehicleId);
+        return info ? info->member : kNoMember;
+    }
+
+    std::size_t activeRentalCount() {
+        std::size_t n = 0;
+        for (std::size_t s = 0; s < shardCount; ++s) {
+            ShardGuard lk(shards[s].mutex, opts.concurrent);
+            n += shards[s].activeRentals.size();
+        }
+        return n;
+    }
+
+    // rates the manager prices with right now
+    TariffRates tariffRates() const { return tariff.rates(); }
+
+    // Revenue, penalty, charge and utilization totals, summed from the copies
+    // each shard publishes after every rent, return and charge. Lock-free and
+    // O(shards), so a dashboard can poll it while renters run; every shard is
+    // consistent on its own (no operation spans two shards), the sum is not a
+    // single point in time across shards.
+    FleetTotals fleetTotals() const {
+        FleetTotals t;
+        for (std::size_t s = 0; s < shardCount; ++s) t += shards[s].totals.read();
+        return t;
+    }
+
+    // Counters and latency histograms summed over all threads, plus the
+    // active rental count and per-kind fleet utilization read shard by shard.
+    // Each shard is consistent on its own; shards are read one after another.
+    MetricsSnapshot metricsSnapshot() const {
+        MetricsSnapshot snap;
+        recorder.mergeInto(snap);
+        for (std::size_t s = 0; s < shardCount; ++s) {
+            Shard &sh = shards[s];
+            ShardGuard lk(sh.mutex, opts.concurrent);
+            snap.activeRentals += sh.activeRentals.size();
+            const FleetTotals &t = sh.totals.edit();
+            for (std::size_t k = 0; k < metrics::kKinds; ++k) {
+                snap.vehicles[k] += t.vehicles[k];
+                snap.rented[k] += t.rented[k];
+            }
+        }
+        snap.logDropped = logger.droppedCount();
+        return snap;
+    }
+
+    // Calls f(const FleetColumns&) once per shard while that shard is locked.
+    template <class F>
+    void scanColumns(F &&f) {
+        for (std::size_t s = 0; s < shardCount; ++s) {
+            ShardGuard lk(shards[s].mutex, opts.concurrent);
+            f(static_cast<const FleetColumns&>(shards[s].columns));
+        }
+    }
+
+    std::size_t countAvailable(VehicleKind kind) {
+        std::size_t n = 0;
+        scanColumns([&](const FleetColumns &c) { n += c.countAvailable(kind); });
+        return n;
+    }
+
+    // e.g. countFreeEvsWithCharge(0.2): free EVs with at least 20% charge
+    std::size_t countFreeEvsWithCharge(double minFraction) {
+        std::size_t n = 0;
+        scanColumns([&](const FleetColumns &c) { n += c.countFreeEvsWithCharge(minFraction); });
+        return n;
+    }
+
+    // Writes the fleet and active rentals as a binary snapshot. The file is
+    // written to path + ".tmp", flushed to disk and renamed over path, so a
+    // crash leaves either the old or the new snapshot. Every shard lock is held
+    // for one consistent view. Extension vehicles (kind Other) have no record
+    // and are counted in skippedExtensions together with their rentals.
+    // sequence is stored in the header; with a journal attached, the journal
+    // position at the cut is stored instead (frames are appended under the
+    // shard locks held here), which is where replay resumes.
+    SnapshotStats saveSnapshot(const std::string &path, std::uint64_t sequence = 0) {
+        MethodTimer timer(recorder, MetricsMethod::SaveSnapshot);
+        SnapshotStats stats;
+        std::vector<SnapshotVehicle> vehicles;
+        std::vector<SnapshotRental> rentals;
+        std::vector<SnapshotString> memberTable;
+        std::string strings;
+        std::int64_t takenAtNs;
+
+        auto addString = [&](std::string_view sv) {
+            if (strings.size() + sv.size() > 0xFFFFFFFFu) throw std::runtime_error("Snapshot string pool exceeds 4 GiB");
+            SnapshotString ref{static_cast<std::uint32_t>(strings.size()), static_cast<std::uint32_t>(sv.size())};
+            strings.append(sv.data(), sv.size());
+            return ref;
+        };
+
+        {
+            auto locks = lockAllShards();
+            ShardGuard orderLock(orderMutex, opts.concurrent);
+            takenAtNs = toEpochNs(clock->now());
+            if (opts.journal) sequence = opts.journal->lastSequence();
+            stats.sequence = sequence;
+
+            // models repeat across a fleet; views point into the shards' column pools, stable while locked
+            std::unordered_map<std::string_view, SnapshotString> models;
+            vehicles.reserve(fleetOrder.size());
+            for (const FleetRef &ref : fleetOrder) {
+                const Shard &sh = shards[ref.shard];
+                const FleetColumns &c = sh.columns;
+                const std::uint32_t slot = ref.slot;
+                if (c.kind[slot] == VehicleKind::Other) {
+                    ++stats.skippedExtensions;
+                    continue;
+                }
+                SnapshotVehicle r = snapshotRecord(c, slot, *sh.vehicles[slot]);
+                std::string_view model = c.model(slot);
+                auto it = models.find(model);
+                if (it == models.end()) it = models.emplace(model, addString(model)).first;
+                r.modelOffset = it->second.offset;
+                r.modelLength = it->second.length;
+                vehicles.push_back(r);
+            }
+
+            FlatIntMap<std::uint32_t> memberIndex; // handle -> member table entry
+            for (std::size_t s = 0; s < shardCount; ++s) {
+                const Shard &sh = shards[s];
+                sh.activeRentals.forEach([&](int vehicleId, const RentalInfo &info) {
+                    const Vehicle *v = findVehicle(sh, vehicleId);
+                    if (!v || v->getKind() == VehicleKind::Other) {
+                        ++stats.skippedExtensions;
+                        return;
+                    }
+                    const int key = static_cast<int>(info.member);
+                    const std::uint32_t *known = memberIndex.find(key);
+                    std::uint32_t m;
+                    if (known) {
+                        m = *known;
+                    } else {
+                        m = static_cast<std::uint32_t>(memberTable.size());
+                        memberIndex.claim(key) = m;
+                        memberTable.push_back(addString(members.name(info.member)));
+                    }
+                    SnapshotRental r{};
+                    r.vehicleId = vehicleId;
+                    r.member = m;
+                    r.dueDateNs = toEpochNs(info.dueDate);
+                    r.expectedLoadKg = info.expectedLoadKg;
+                    rentals.push_back(r);
+                });
+            }
+        }
+
+        SnapshotHeader h{};
+        std::memcpy(h.magic, "RNTLSNAP", sizeof(h.magic));
+        h.version = kSnapshotVersion;
+        h.byteOrder = kSnapshotByteOrder;
+        h.sequence = sequence;
+        h.takenAtNs = takenAtNs;
+        h.vehicleCount = vehicles.size();
+        h.rentalCount = rentals.size();
+        h.memberCount = memberTable.size();
+        h.stringBytes = strings.size();
+        h.vehicleOffset = sizeof(SnapshotHeader);
+        h.rentalOffset = h.vehicleOffset + vehicles.size() * sizeof(SnapshotVehicle);
+        h.memberOffset = h.rentalOffset + rentals.size() * sizeof(SnapshotRental);
+        h.stringOffset = h.memberOffset + memberTable.size() * sizeof(SnapshotString);
+        h.fileSize = h.stringOffset + strings.size();
+
+        const std::string tmp = path + ".tmp";
+        std::FILE *f = std::fopen(tmp.c_str(), "wb");
+        if (!f) throw std::runtime_error("Cannot create snapshot " + tmp);
+        bool ok = std::fwrite(&h, sizeof(h), 1, f) == 1;
+        auto put = [&](const void *p, std::size_t n) {
+            if (ok && n > 0) ok = std::fwrite(p, 1, n, f) == n;
+        };
+        put(vehicles.data(), vehicles.size() * sizeof(SnapshotVehicle));
+        put(rentals.data(), rentals.size() * sizeof(SnapshotRental));
+        put(memberTable.data(), memberTable.size() * sizeof(SnapshotString));
+        put(strings.data(), strings.size());
+        ok = std::fflush(f) == 0 && ok;
+#ifndef _WIN32
+        ok = ::fsync(::fileno(f)) == 0 && ok;
+#endif
+        ok = std::fclose(f) == 0 && ok;
+        if (!ok || std::rename(tmp.c_str(), path.c_str()) != 0) {
+            std::remove(tmp.c_str());
+            throw std::runtime_error("Cannot write snapshot " + path);
+        }
+        stats.vehicles = vehicles.size();
+        stats.rentals = rentals.size();
+        return stats;
+    }
+
+    // Restores a snapshot into a manager with an empty fleet. Records are used
+    // in place from the mapped file: the per-vehicle work is constructing its
+    // pooled object plus the column and index entries, with no parsing. Throws
+    // std::runtime_error for a missing, truncated, foreign, newer or
+    // inconsistent file (a repeated vehicle id, a rental naming a vehicle the
+    // snapshot lacks) before touching any state.
+    SnapshotStats loadSnapshot(const std::string &path) {
+        MethodTimer timer(recorder, MetricsMethod::LoadSnapshot);
+        MappedFile file(path);
+        const char *base = file.data();
+        auto corrupt = [&](const char *what) { return std::runtime_error("Snapshot " + path + ": " + what); };
+
+        SnapshotHeader h;
+        if (file.size() < sizeof(h)) throw corrupt("truncated header");
+        std::memcpy(&h, base, sizeof(h));
+        if (std::memcmp(h.magic, "RNTLSNAP", sizeof(h.magic)) != 0) throw corrupt("not a snapshot");
+        if (h.byteOrder != kSnapshotByteOrder) throw corrupt("written with another byte order");
+        if (h.version != kSnapshotVersion) throw corrupt("unsupported version");
+        if (h.fileSize != file.size()) throw corrupt("size mismatch");
+        auto sectionFits = [&](std::uint64_t offset, std::uint64_t count, std::size_t width) {
+            return offset % 8 == 0 && offset >= sizeof(h) && offset <= h.fileSize &&
+                   count <= (h.fileSize - offset) / width;
+        };
+        if (!sectionFits(h.vehicleOffset, h.vehicleCount, sizeof(SnapshotVehicle)) ||
+            !sectionFits(h.rentalOffset, h.rentalCount, sizeof(SnapshotRental)) ||
+            !sectionFits(h.memberOffset, h.memberCount, sizeof(SnapshotString)) ||
+            h.stringOffset > h.fileSize || h.stringBytes > h.fileSize - h.stringOffset) {
+            throw corrupt("section out of bounds");
+        }
+
+        const auto *vehicles = reinterpret_cast<const SnapshotVehicle*>(base + h.vehicleOffset);
+        const auto *rentals = reinterpret_cast<const SnapshotRental*>(base + h.rentalOffset);
+        const auto *memberTable = reinterpret_cast<const SnapshotString*>(base + h.memberOffset);
+        const char *strings = base + h.stringOffset;
+        const std::size_t vehicleCount = static_cast<std::size_t>(h.vehicleCount);
+        const std::size_t rentalCount = static_cast<std::size_t>(h.rentalCount);
+        const std::size_t memberCount = static_cast<std::size_t>(h.memberCount);
+        auto inPool = [&](std::uint32_t offset, std::uint32_t length) {
+            return static_cast<std::uint64_t>(offset) + length <= h.stringBytes;
+        };
+
+        // validate everything a record can get wrong before the first mutation
+        std::vector<std::size_t> perShard(shardCount, 0);
+        FlatIntMap<std::uint8_t> known(vehicleCount);
+        for (std::size_t i = 0; i < vehicleCount; ++i) {
+            const SnapshotVehicle &r = vehicles[i];
+            if (r.kind != VehicleKind::Car && r.kind != VehicleKind::Truck && r.kind != VehicleKind::Electric) {
+                throw corrupt("unknown vehicle kind");
+            }
+            if (!inPool(r.modelOffset, r.modelLength)) throw corrupt("model name out of bounds");
+            if (known.find(r.id)) throw corrupt("duplicate vehicle id");
+            known.claim(r.id) = 1;
+            ++perShard[shardOf(r.id)];
+        }
+        for (std::size_t i = 0; i < memberCount; ++i) {
+            if (!inPool(memberTable[i].offset, memberTable[i].length)) throw corrupt("member id out of bounds");
+        }
+        for (std::size_t i = 0; i < rentalCount; ++i) {
+            if (rentals[i].member >= memberCount) throw corrupt("rental member out of range");
+            if (!known.find(rentals[i].vehicleId)) throw corrupt("rental for unknown vehicle");
+        }
+
+        auto locks = lockAllShards();
+        ShardGuard orderLock(orderMutex, opts.concurrent);
+        if (!fleetOrder.empty()) throw std::runtime_error("loadSnapshot needs an empty fleet");
+        std::vector<MemberHandle> handles(memberCount);
+        for (std::size_t i = 0; i < memberCount; ++i) {
+            handles[i] = members.intern(std::string_view(strings + memberTable[i].offset, memberTable[i].length));
+        }
+        for (std::size_t s = 0; s < shardCount; ++s) {
+            shards[s].vehicles.reserve(perShard[s]);
+            shards[s].columns.reserve(perShard[s]);
+        }
+        // Slots follow record order within a shard, so the fleet order is known
+        // up front. byShard lists record indices grouped by shard (counting sort),
+        // letting each shard be rebuilt with sequential writes.
+        std::vector<std::size_t> shardStart(shardCount + 1, 0);
+        for (std::size_t s = 0; s < shardCount; ++s) shardStart[s + 1] = shardStart[s] + perShard[s];
+        std::vector<std::uint32_t> byShard(vehicleCount);
+        fleetOrder.resize(vehicleCount);
+        for (std::size_t s = 0; s < shardCount; ++s) perShard[s] = 0;
+        for (std::size_t i = 0; i < vehicleCount; ++i) {
+            const std::size_t s = shardOf(vehicles[i].id);
+            const std::size_t slot = perShard[s]++;
+            fleetOrder[i] = FleetRef{static_cast<std::uint32_t>(s), static_cast<std::uint32_t>(slot)};
+            byShard[shardStart[s] + slot] = static_cast<std::uint32_t>(i);
+        }
+
+        // shards are independent, so a concurrent manager restores them on several threads
+        std::atomic<std::size_t> nextShard{0};
+        auto restore = [&] {
+            std::string model; // reused while consecutive vehicles share a model
+            for (std::size_t s; (s = nextShard.fetch_add(1, std::memory_order_relaxed)) < shardCount;) {
+                Shard &sh = shards[s];
+                for (std::size_t k = shardStart[s]; k < shardStart[s + 1]; ++k) {
+                    const SnapshotVehicle &r = vehicles[byShard[k]];
+                    std::string_view name(strings + r.modelOffset, r.modelLength);
+                    if (name != model) model.assign(name.data(), name.size());
+                    placeVehicle(sh, r.kind, r.id, model, r.dailyRate, r.spec, r.chargeKwh, r.rented != 0);
+                }
+                sh.totals.publish();
+            }
+        };
+        std::size_t workers = 1;
+        if (opts.concurrent) {
+            workers = std::min<std::size_t>(shardCount, std::max(1u, std::thread::hardware_concurrency()));
+            workers = std::min<std::size_t>(workers, 1 + vehicleCount / 65536);
+        }
+        std::vector<std::thread> pool;
+        for (std::size_t w = 1; w < workers; ++w) pool.emplace_back(restore);
+        restore();
+        for (std::thread &t : pool) t.join();
+
+        for (std::size_t i = 0; i < rentalCount; ++i) {
+            const SnapshotRental &r = rentals[i];
+            Shard &sh = shardFor(r.vehicleId);
+            recordRental(sh, r.vehicleId, handles[r.member], fromEpochNs(r.dueDateNs), r.expectedLoadKg, 0.0);
+        }
+
+        SnapshotStats stats;
+        stats.vehicles = vehicleCount;
+        stats.rentals = rentalCount;
+        stats.sequence = h.sequence;
+        return stats;
+    }
+
+    // Bulk onboarding from a CSV or columnar fleet file (see FleetFileFormat).
+    // The file is mapped and parsed in chunks on several threads, then each
+    // shard builds its vehicles in place in its pools, with their column and
+    // index entries, in one pass and without a Vehicle copy per row. Rows that
+    // do not parse, carry invalid values or repeat an id are skipped and
+    // listed in the stats; the rest load, free, and journaled like
+    // addVehicle. Throws std::runtime_error only for an unreadable file or a
+    // columnar header that does not check out, before touching any state.
+    FleetImportStats importFleet(const std::string &path, FleetFileFormat format = FleetFileFormat::Auto) {
+        MethodTimer timer(recorder, MetricsMethod::ImportFleet);
+        MappedFile file(path, "fleet file");
+        const char *base = file.data();
+        if (format == FleetFileFormat::Auto) {
+            const bool columns = file.size() >= 8 && std::memcmp(base, "RNTLFCOL", 8) == 0;
+            format = columns ? FleetFileFormat::Columns : FleetFileFormat::Csv;
+        }
+        const std::size_t chunks = importWorkers(file.size());
+        const std::vector<ImportRow> rows = format == FleetFileFormat::Csv
+                                                ? readFleetCsv(base, file.size(), chunks)
+                                                : readFleetColumns(path, base, file.size(), chunks);
+        FleetImportStats stats;
+        stats.rows = rows.size();
+
+        // rows that parsed, grouped by shard in file order (counting sort)
+        std::vector<std::size_t> shardStart(shardCount + 1, 0);
+        for (const ImportRow &r : rows) {
+            if (r.problem == ImportProblem::Ok) ++shardStart[shardOf(r.id) + 1];
+        }
+        for (std::size_t s = 0; s < shardCount; ++s) shardStart[s + 1] += shardStart[s];
+        std::vector<std::uint32_t> byShard(shardStart.back());
+        {
+            std::vector<std::size_t> fill(shardStart.begin(), shardStart.end() - 1);
+            for (std::size_t i = 0; i < rows.size(); ++i) {
+                if (rows[i].problem == ImportProblem::Ok) byShard[fill[shardOf(rows[i].id)]++] = static_cast<std::uint32_t>(i);
+            }
+        }
+
+        std::vector<std::uint32_t> slotOf(rows.size(), VehicleIndex::npos);
+        std::vector<std::vector<ImportError>> rejected(shardCount);
+        std::uint64_t seq = 0;
+        {
+            auto locks = lockAllShards();
+            ShardGuard orderLock(orderMutex, opts.concurrent);
+            forEachShardParallel([&](std::size_t s) {
+                Shard &sh = shards[s];
+                sh.vehicles.reserve(sh.vehicles.size() + shardStart[s + 1] - shardStart[s]);
+                sh.columns.reserve(sh.columns.size() + shardStart[s + 1] - shardStart[s]);
+                std::string model; // reused while consecutive rows share a model
+                for (std::size_t k = shardStart[s]; k < shardStart[s + 1]; ++k) {
+                    const ImportRow &r = rows[byShard[k]];
+                    ImportProblem problem = checkImportRow(r);
+                    if (problem == ImportProblem::Ok && findSlot(sh, r.id) != VehicleIndex::npos) problem = ImportProblem::DuplicateId;
+                    if (problem != ImportProblem::Ok) {
+                        rejected[s].push_back(ImportError{r.row, r.id, problem});
+                        continue;
+                    }
+                    const std::string_view name(r.model, r.modelLength);
+                    if (name != model) model.assign(name.data(), name.size());
+                    slotOf[byShard[k]] = placeVehicle(sh, r.kind, r.id, model, r.dailyRate, r.spec, r.chargeKwh, false);
+                }
+                sh.totals.publish();
+            });
+            // listFleet order and journal frames follow the file, so a replay rebuilds the same order
+            fleetOrder.reserve(fleetOrder.size() + byShard.size());
+            for (std::size_t i = 0; i < rows.size(); ++i) {
+                if (slotOf[i] == VehicleIndex::npos) continue;
+                const std::size_t s = shardOf(rows[i].id);
+                fleetOrder.push_back(FleetRef{static_cast<std::uint32_t>(s), slotOf[i]});
+                ++stats.imported;
+                if (opts.journal) {
+                    const Shard &sh = shards[s];
+                    SnapshotVehicle j = snapshotRecord(sh.columns, slotOf[i], *sh.vehicles[slotOf[i]]);
+                    j.modelOffset = 0;
+                    seq = opts.journal->append(JournalOp::AddVehicle, rows[i].id, &j, sizeof(j), sh.columns.model(slotOf[i]));
+                }
+            }
+        }
+        commitJournal(seq);
+
+        for (const ImportRow &r : rows) {
+            if (r.problem != ImportProblem::Ok) stats.errors.push_back(ImportError{r.row, r.id, r.problem});
+        }
+        for (const auto &list : rejected) stats.errors.insert(stats.errors.end(), list.begin(), list.end());
+        std::sort(stats.errors.begin(), stats.errors.end(),
+                  [](const ImportError &a, const ImportError &b) { return a.row < b.row; });
+        return stats;
+    }
+
+    // Applies the journal frames with a sequence after afterSequence (normally
+    // the one loadSnapshot returned). Frames carry resulting state, not
+    // requests, so replay repeats no business checks and writes no log lines
+    // or journal frames. Stops quietly at a torn tail.
+    JournalReplayStats replayJournal(const std::string &path, std::uint64_t afterSequence = 0) {
+        MethodTimer timer(recorder, MetricsMethod::ReplayJournal);
+        JournalReplayStats stats;
+        JournalReader reader(path);
+        JournalReader::Entry e;
+        std::string text;
+        while (reader.next(e)) {
+            const JournalFrame &f = e.frame;
+            stats.lastSequence = f.sequence;
+            if (f.sequence <= afterSequence) {
+                ++stats.skipped;
+                continue;
+            }
+            bool applied = false;
+            switch (f.op) {
+            case JournalOp::AddVehicle: {
+                SnapshotVehicle r;
+                if (f.payloadBytes < sizeof(r)) break;
+                std::memcpy(&r, e.payload, sizeof(r));
+                if (r.modelLength != f.payloadBytes - sizeof(r)) break;
+                text.assign(e.payload + sizeof(r), r.modelLength);
+                std::unique_ptr<Vehicle> v = vehicleFromRecord(r, text);
+                if (!v) break;
+                insertVehicle(*v, false);
+                applied = true;
+                break;
+            }
+            case JournalOp::Rent: {
+                JournalRent r;
+                if (f.payloadBytes < sizeof(r)) break;
+                std::memcpy(&r, e.payload, sizeof(r));
+                MemberHandle member = members.intern(std::string_view(e.payload + sizeof(r), f.payloadBytes - sizeof(r)));
+                Shard &sh = shardFor(f.vehicleId);
+                ShardGuard lk(sh.mutex, opts.concurrent);
+                std::uint32_t slot = findSlot(sh, f.vehicleId);
+                if (slot == VehicleIndex::npos) break;
+                markRented(sh, slot, true);
+                recordRental(sh, f.vehicleId, member, fromEpochNs(r.dueDateNs), r.loadKg, 0.0);
+                sh.totals.publish();
+                applied = true;
+                break;
+            }
+            case JournalOp::Return: {
+                Shard &sh = shardFor(f.vehicleId);
+                ShardGuard lk(sh.mutex, opts.concurrent);
+                std::uint32_t slot = findSlot(sh, f.vehicleId);
+                if (slot == VehicleIndex::npos || !sh.activeRentals.erase(f.vehicleId)) break;
+                markRented(sh, slot, false);
+                sh.totals.publish();
+                applied = true;
+                break;
+            }
+            case JournalOp::Charge: {
+                double kwh;
+                if (f.payloadBytes != sizeof(kwh)) break;
+                std::memcpy(&kwh, e.payload, sizeof(kwh));
+                Shard &sh = shardFor(f.vehicleId);
+                ShardGuard lk(sh.mutex, opts.concurrent);
+                applied = chargeLocked(sh, f.vehicleId, kwh).ok();
+                break;
+            }
+            }
+            if (applied) ++stats.applied;
+            else ++stats.inconsistent;
+        }
+        stats.tornTail = reader.tornTail();
+        return stats;
+    }
+
+    struct RecoveryStats {
+        SnapshotStats snapshot;
+        JournalReplayStats journal;
+    };
+
+    // Restart path: load the snapshot (if the file exists) into this empty
+    // manager, then replay the journal tail written after it (if that exists).
+    // Open the Journal for new writes before calling this; reopening trims a
+    // torn tail and continues the sequence.
+    RecoveryStats recover(const std::string &snapshotPath, const std::string &journalPath) {
+        RecoveryStats stats;
+        std::error_code ec;
+        if (std::filesystem::exists(snapshotPath, ec)) stats.snapshot = loadSnapshot(snapshotPath);
+        if (std::filesystem::file_size(journalPath, ec) > 0 && !ec) {
+            stats.journal = replayJournal(journalPath, stats.snapshot.sequence);
+        }
+        return stats;
+    }
+
+    // Writes "Fleet:" and one line per vehicle (insertion order) matching
+    // the filter. Lines are formatted with appendInfo into one reusable buffer
+    // that is written to `out` every kListChunkBytes, so a large fleet costs
+    // a handful of writes instead of a stream per line. All shard locks are
+    // held for the whole listing, which therefore is one consistent view.
+    void listFleet(FleetFilter filter = FleetFilter::All, std::ostream &out = std::cout) {
+        MethodTimer timer(recorder, MetricsMethod::ListFleet);
+        static constexpr std::size_t kListChunkBytes = 64 * 1024;
+        std::string buf;
+        buf.reserve(kListChunkBytes + 256);
+        buf += "Fleet:\n";
+        {
+            auto locks = lockAllShards();
+            ShardGuard orderLock(orderMutex, opts.concurrent);
+            for (const FleetRef &ref : fleetOrder) {
+                const Shard &sh = shards[ref.shard];
+                const bool rented = sh.columns.rented[ref.slot] != 0;
+                if ((filter == FleetFilter::Available && rented) || (filter == FleetFilter::Rented && !rented)) continue;
+                const Vehicle &v = *sh.vehicles[ref.slot];
+                buf += "  ";
+                // extension types may only override info()
+                if (v.getKind() == VehicleKind::Other) buf += v.info();
+                else v.appendInfo(buf);
+                if (rented) buf += " [RENTED]";
+                buf += '\n';
+                if (buf.size() >= kListChunkBytes) {
+                    out.write(buf.data(), static_cast<std::streamsize>(buf.size()));
+                    buf.clear();
+                }
+            }
+        }
+        out.write(buf.data(), static_cast<std::streamsize>(buf.size()));
+        out.flush();
+    }
+};
+
+using RentalManager = BasicRentalManager<StandardTariff>;
+
+// Calls pollOverdue on a background thread every `interval`, so the overdue
+// callback fires without the caller driving it. Stops and joins on destruction.
+// Like the front ends below it takes any BasicRentalManager<Tariff>; the
+// plain name is the RentalManager instantiation.
+template <class Manager>
+class BasicOverdueMonitor {
+    Manager &manager;
+    std::chrono::milliseconds interval;
+    std::mutex mutex;
+    std::condition_variable wake;
+    bool stopping = false;
+    std::thread worker;
+
+    void loop() {
+        std::unique_lock<std::mutex> lk(mutex);
+        while (!wake.wait_for(lk, interval, [&] { return stopping; })) {
+            lk.unlock();
+            manager.pollOverdue();
+            lk.lock();
+        }
+    }
+
+public:
+    explicit BasicOverdueMonitor(Manager &mgr, std::chrono::milliseconds every = std::chrono::seconds(1))
+        : manager(mgr), interval(every), worker(&BasicOverdueMonitor::loop, this) {}
+
+    ~BasicOverdueMonitor() {
+        {
+            std::lock_guard<std::mutex> lk(mutex);
+            stopping = true;
+        }
+        wake.notify_one();
+        worker.join();
+    }
+
+    BasicOverdueMonitor(const BasicOverdueMonitor&) = delete;
+    BasicOverdueMonitor& operator=(const BasicOverdueMonitor&) = delete;
+};
+
+using OverdueMonitor = BasicOverdueMonitor<RentalManager>;
+
+struct ActorOptions {
+    int cpu = -1;                 // core the worker is pinned to; -1 = not pinned
+    std::size_t batchSize = 256;  // commands applied per drain before checking for stop/idle
+    unsigned spinRounds = 64;     // empty polls (yielding) before the worker sleeps
+};
+
+// Single-owner front end: producers on any thread push rent/return/charge
+// commands into a lock-free MPSC queue and one worker thread applies them to
+// the manager in arrival order, completing a future or calling a callback on
+// the worker. Give it a manager built without concurrentMode that nothing
+// else touches while the actor runs; then no shard lock is ever taken.
+// Commands from one producer are applied in the order it pushed them.
+// Destruction applies everything already queued, then joins the worker.
+template <class Manager>
+class BasicRentalActor {
+public:
+    using Completion = std::function<void(const RentalOutcome&)>; // runs on the worker, must not throw
+
+private:
+    struct Command : MpscNode {
+        RentalOp op = RentalOp::Rent;
+        std::string memberId;
+        int vehicleId = 0;
+        int days = 0;        // rent: booked days, return: actual days
+        double amount = 0.0; // rent: loadKg, charge: kWh
+        bool damaged = false;
+        std::optional<std::promise<RentalOutcome>> promise;
+        Completion done;
+    };
+
+    Manager &manager;
+    ActorOptions opts;
+    MpscQueue<Command> queue;
+    std::atomic<bool> stopping{false};
+    std::atomic<bool> workerIdle{false};
+    std::mutex wakeMutex;
+    std::condition_variable wake;
+    std::thread worker;
+
+    static void pinCurrentThread(int cpu) {
+#ifdef __linux__
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        pthread_setaffinity_np(pthread_self(), sizeof(set), &set); // best effort
+#else
+        (void)cpu;
+#endif
+    }
+
+    RentalOutcome apply(const Command &c) {
+        switch (c.op) {
+        case RentalOp::Rent: return manager.tryRentVehicle(c.memberId, c.vehicleId, c.days, c.amount);
+        case RentalOp::Return: return manager.tryReturnVehicle(c.memberId, c.vehicleId, c.days, c.damaged);
+        case RentalOp::Charge: return manager.tryChargeBattery(c.vehicleId, c.amount);
+        }
+        return RentalOutcome();
+    }
+
+    // Applies one command and hands its outcome over. Whatever the manager
+    // throws (a journal write failing, bad_alloc, an extension's start())
+    // goes to the caller: the future rethrows it, a Completion sees
+    // StartFailed. The worker itself keeps running.
+    void complete(Command &c) {
+        RentalOutcome o;
+        try {
+            o = apply(c);
+        } catch (...) {
+            if (c.promise) {
+                c.promise->set_exception(std::current_exception());
+                return;
+            }
+            o = RentalOutcome();
+            o.vehicleId = c.vehicleId;
+            o.status = RentalStatus::StartFailed;
+        }
+        if (c.promise) c.promise->set_value(o);
+        else if (c.done) c.done(o);
+    }
+
+    void loop() {
+        if (opts.cpu >= 0) pinCurrentThread(opts.cpu);
+        unsigned idlePolls = 0;
+        for (;;) {
+            std::size_t n = 0;
+            while (n < opts.batchSize) {
+                std::unique_ptr<Command> c(queue.pop());
+                if (!c) break;
+                complete(*c);
+                ++n;
+            }
+            if (n > 0) {
+                idlePolls = 0;
+                continue;
+            }
+            if (queue.empty()) {
+                if (stopping.load(std::memory_order_acquire)) break;
+                if (++idlePolls < opts.spinRounds) {
+                    std::this_thread::yield();
+                    continue;
+                }
+                std::unique_lock<std::mutex> lk(wakeMutex);
+                workerIdle.store(true, std::memory_order_seq_cst);
+                if (queue.empty() && !stopping.load(std::memory_order_acquire)) {
+                    wake.wait_for(lk, std::chrono::milliseconds(50));
+                }
+                workerIdle.store(false, std::memory_order_relaxed);
+                idlePolls = 0;
+            } else {
+                std::this_thread::yield(); // a producer is mid-push
+            }
+        }
+    }
+
+    void wakeWorker() {
+        if (workerIdle.load(std::memory_order_seq_cst)) {
+            std::lock_guard<std::mutex> lk(wakeMutex);
+            wake.notify_one();
+        }
+    }
+
+    void submit(std::unique_ptr<Command> c) {
+        queue.push(c.release());
+        wakeWorker();
+    }
+
+    std::future<RentalOutcome> submitForFuture(std::unique_ptr<Command> c) {
+        c->promise.emplace();
+        std::future<RentalOutcome> f = c->promise->get_future();
+        submit(std::move(c));
+        return f;
+    }
+
+    static std::unique_ptr<Command> makeCommand(RentalOp op, const std::string &memberId, int vehicleId,
+                                                int days, double amount, bool damaged) {
+        auto c = std::make_unique<Command>();
+        c->op = op;
+        c->memberId = memberId;
+        c->vehicleId = vehicleId;
+        c->days = days;
+        c->amount = amount;
+        c->damaged = damaged;
+        return c;
+    }
+
+public:
+    explicit BasicRentalActor(Manager &mgr, const ActorOptions &options = ActorOptions())
+        : manager(mgr), opts(options), worker(&BasicRentalActor::loop, this) {}
+
+    ~BasicRentalActor() {
+        {
+            std::lock_guard<std::mutex> lk(wakeMutex);
+            stopping.store(true, std::memory_order_release);
+        }
+        wake.notify_one();
+        worker.join();
+    }
+
+    BasicRentalActor(const BasicRentalActor&) = delete;
+    BasicRentalActor& operator=(const BasicRentalActor&) = delete;
+
+    std::future<RentalOutcome> rentVehicle(const std::string &memberId, int vehicleId, int days, double loadKg = 0.0) {
+        return submitForFuture(makeCommand(RentalOp::Rent, memberId, vehicleId, days, loadKg, false));
+    }
+
+    // an empty Completion queues the command without any notification
+    void rentVehicle(const std::string &memberId, int vehicleId, int days, double loadKg, Completion done) {
+        auto c = makeCommand(RentalOp::Rent, memberId, vehicleId, days, loadKg, false);
+        c->done = std::move(done);
+        submit(std::move(c));
+    }
+
+    std::future<RentalOutcome> returnVehicle(const std::string &memberId, int vehicleId, int actualDays, bool damageFlag) {
+        return submitForFuture(makeCommand(RentalOp::Return, memberId, vehicleId, actualDays, 0.0, damageFlag));
+    }
+
+    void returnVehicle(const std::string &memberId, int vehicleId, int actualDays, bool damageFlag, Completion done) {
+        auto c = makeCommand(RentalOp::Return, memberId, vehicleId, actualDays, 0.0, damageFlag);
+        c->done = std::move(done);
+        submit(std::move(c));
+    }
+
+    std::future<RentalOutcome> chargeBattery(int vehicleId, double kwh) {
+        return submitForFuture(makeCommand(RentalOp::Charge, std::string(), vehicleId, 0, kwh, false));
+    }
+
+    void chargeBattery(int vehicleId, double kwh, Completion done) {
+        auto c = makeCommand(RentalOp::Charge, std::string(), vehicleId, 0, kwh, false);
+        c->done = std::move(done);
+        submit(std::move(c));
+    }
+};
+
+using RentalActor = BasicRentalActor<RentalManager>;
+
+// ---------------------------------------------------------------------------
+// Partitioned fleet
+// ---------------------------------------------------------------------------
+//
+// The fleet is split by vehicle-id range over several RentalManager instances
+// (partitions, usually one per process or host), each served by a
+// PartitionServer. A PartitionRouter holds one PartitionLink per range and
+// forwards rent/return/charge to the owning partition; fleet-wide calls
+// (listFleet, utilization) go to every partition at once and are merged.
+// Regions map onto this by giving each region its own id range.
+//
+// Wire protocol, native byte order (checked by the Hello that opens every
+// connection), one reply per request:
+//   request: PartitionRequest (24 bytes) + payload (Rent/Return: member id bytes)
+//   reply:   PartitionReply (64 bytes) + payload
+//     Rent/Return/Charge/Hello: nothing, the outcome is in the header
+//     ListFleet:                listFleet text of the partition
+//     Stats:                    PartitionStats
+
+constexpr std::uint32_t kPartitionProtocolVersion = 2; // 2: RentalStatus::Reserved
+constexpr std::uint32_t kMaxPartitionPayload = 1u << 30;        // replies: ListFleet text of a whole partition
+constexpr std::uint32_t kMaxPartitionRequestPayload = 1u << 16; // requests carry at most a member id
+
+enum class PartitionCall : std::uint8_t { Hello, Rent, Return, Charge, ListFleet, Stats };
+
+struct PartitionRequest {
+    std::uint32_t payloadBytes;
+    PartitionCall call;
+    std::uint8_t flags;     // Return: 1 = damaged; ListFleet: FleetFilter
+    std::uint8_t reserved[2];
+    std::int32_t vehicleId; // Hello: protocol version
+    std::int32_t days;      // Rent: booked days, Return: actual days; Hello: byte order mark
+    double amount;          // Rent: loadKg, Charge: kWh
+};
+
+struct PartitionReply {
+    std::uint32_t payloadBytes;
+    RentalStatus status;
+    std::uint8_t minorDamage;
+    std::uint8_t reserved[2];
+    std::int32_t vehicleId;
+    std::int32_t reserved2;
+    double cost;
+    double baseCost;
+    double penalty;
+    double loadKg;
+    double maxLoadKg;
+    double chargeKwh;
+};
+
+// vehicle counts of one partition, [VehicleKind]
+struct PartitionStats {
+    std::uint64_t vehicles[4];
+    std::uint64_t rented[4];
+};
+
+static_assert(sizeof(PartitionRequest) == 24 && sizeof(PartitionReply) == 64 && sizeof(PartitionStats) == 64,
+              "partition wire layout");
+
+inline std::string encodePartitionRequest(PartitionCall call, int vehicleId, int days, double amount,
+                                          std::uint8_t flags = 0, std::string_view payload = std::string_view()) {
+    PartitionRequest h{};
+    h.payloadBytes = static_cast<std::uint32_t>(payload.size());
+    h.call = call;
+    h.flags = flags;
+    h.vehicleId = vehicleId;
+    h.days = days;
+    h.amount = amount;
+    std::string out(reinterpret_cast<const char*>(&h), sizeof(h));
+    out.append(payload.data(), payload.size());
+    return out;
+}
+
+inline void appendPartitionReply(std::string &out, const RentalOutcome &o, std::string_view payload = std::string_view()) {
+    PartitionReply h{};
+    h.payloadBytes = static_cast<std::uint32_t>(payload.size());
+    h.status = o.status;
+    h.minorDamage = o.minorDamage ? 1 : 0;
+    h.vehicleId = o.vehicleId;
+    h.cost = o.cost;
+    h.baseCost = o.baseCost;
+    h.penalty = o.penalty;
+    h.loadKg = o.loadKg;
+    h.maxLoadKg = o.maxLoadKg;
+    h.chargeKwh = o.chargeKwh;
+    out.append(reinterpret_cast<const char*>(&h), sizeof(h));
+    out.append(payload.data(), payload.size());
+}
+
+// header of a complete reply frame; false if `reply` is not one
+inline bool decodePartitionReply(const std::string &reply, PartitionReply &h) {
+    if (reply.size() < sizeof(h)) return false;
+    std::memcpy(&h, reply.data(), sizeof(h));
+    return h.payloadBytes == reply.size() - sizeof(h) &&
+           static_cast<std::size_t>(h.status) < kRentalStatusCount;
+}
+
+inline RentalOutcome partitionOutcome(const PartitionReply &h) {
+    RentalOutcome o;
+    o.status = h.status;
+    o.vehicleId = h.vehicleId;
+    o.cost = h.cost;
+    o.baseCost = h.baseCost;
+    o.penalty = h.penalty;
+    o.minorDamage = h.minorDamage != 0;
+    o.loadKg = h.loadKg;
+    o.maxLoadKg = h.maxLoadKg;
+    o.chargeKwh = h.chargeKwh;
+    return o;
+}
+
+#ifndef _WIN32
+// blocking exact-length socket I/O; false on EOF, error or timeout
+inline bool socketReadFull(int fd, void *buf, std::size_t n) {
+    char *p = static_cast<char*>(buf);
+    while (n > 0) {
+        ssize_t r = ::recv(fd, p, n, 0);
+        if (r < 0 && errno == EINTR) continue;
+        if (r <= 0) return false;
+        p += r;
+        n -= static_cast<std::size_t>(r);
+    }
+    return true;
+}
+
+inline bool socketWriteFull(int fd, const void *buf, std::size_t n) {
+    const char *p = static_cast<const char*>(buf);
+    while (n > 0) {
+        ssize_t r = ::send(fd, p, n, MSG_NOSIGNAL);
+        if (r < 0 && errno == EINTR) continue;
+        if (r <= 0) return false;
+        p += r;
+        n -= static_cast<std::size_t>(r);
+    }
+    return true;
+}
+
+// reads one frame (header type H + payload of at most maxPayload bytes) into `frame`
+template <class H>
+bool socketReadFrame(int fd, std::string &frame, std::uint32_t maxPayload) {
+    H h;
+    if (!socketReadFull(fd, &h, sizeof(h)) || h.payloadBytes > maxPayload) return false;
+    frame.assign(reinterpret_cast<const char*>(&h), sizeof(h));
+    frame.resize(sizeof(h) + h.payloadBytes);
+    return socketReadFull(fd, &frame[sizeof(h)], h.payloadBytes);
+}
+#endif
+
+// Serves one partition: answers protocol requests against a manager, either
+// called in-process (handle) or on TCP connections (listen), one thread per
+// connection. With more than one connection the manager must be in
+// concurrentMode.
+template <class Manager>
+class BasicPartitionServer {
+    Manager &manager;
+#ifndef _WIN32
+    std::mutex mutex;
+    std::condition_variable stopped; // wait(): stopping became true
+    std::mutex stopMutex;            // one stop() at a time; only stop() joins
+    bool stopping = false;
+    int listenFd = -1;
+    std::thread acceptor;
+
+    struct Session {
+        int fd = -1;       // -1 once the session closed its socket
+        bool done = false; // thread is about to return; the accept loop joins it
+        std::thread thread;
+    };
+    std::list<Session> sessions; // stable addresses: a session thread keeps a pointer to its entry
+
+    // Serves one connection. What the manager throws (a journal write
+    // failing, bad_alloc) ends only this connection, which the peer reports
+    // as PartitionUnavailable; letting it leave the thread would terminate
+    // the whole partition.
+    void session(Session *self, int fd) {
+        std::string request, reply;
+        try {
+            while (socketReadFrame<PartitionRequest>(fd, request, kMaxPartitionRequestPayload)) {
+                reply.clear();
+                if (!handle(request, reply) || !socketWriteFull(fd, reply.data(), reply.size())) break;
+            }
+        } catch (...) {
+            // close below like any other end of the connection
+        }
+        std::lock_guard<std::mutex> lk(mutex); // stop() shuts sockets down under the same lock
+        ::close(fd);
+        self->fd = -1;
+        self->done = true;
+    }
+
+    // Takes the threads of finished sessions out of the list, so connection
+    // churn does not grow it; caller holds mutex and joins them after
+    // releasing it. A done session has already left the lock, so its join
+    // only waits for the thread to return.
+    void reapSessions(std::vector<std::thread> &finished) {
+        for (auto it = sessions.begin(); it != sessions.end();) {
+            if (!it->done) {
+                ++it;
+                continue;
+            }
+            finished.push_back(std::move(it->thread));
+            it = sessions.erase(it);
+        }
+    }
+
+    void acceptLoop() {
+        for (;;) {
+            int fd = ::accept(listenFd, nullptr, nullptr);
+            if (fd < 0) {
+                if (errno == EINTR || errno == ECONNABORTED) continue;
+                return; // listening socket shut down by stop()
+            }
+            int one = 1;
+            ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+            std::vector<std::thread> finished;
+            {
+                std::lock_guard<std::mutex> lk(mutex);
+                if (stopping) {
+                    ::close(fd);
+                    return;
+                }
+                reapSessions(finished);
+                Session &s = sessions.emplace_back();
+                s.fd = fd;
+                s.thread = std::thread(&BasicPartitionServer::session, this, &s, fd);
+            }
+            for (std::thread &t : finished) t.join();
+        }
+    }
+#endif
+
+    PartitionStats stats() {
+        PartitionStats st{};
+        const FleetTotals t = manager.fleetTotals();
+        for (std::size_t k = 0; k < metrics::kKinds; ++k) {
+            st.vehicles[k] = t.vehicles[k];
+            st.rented[k] = t.rented[k];
+        }
+        return st;
+    }
+
+public:
+    explicit BasicPartitionServer(Manager &mgr) : manager(mgr) {}
+    ~BasicPartitionServer() { stop(); }
+
+    BasicPartitionServer(const BasicPartitionServer&) = delete;
+    BasicPartitionServer& operator=(const BasicPartitionServer&) = delete;
+
+    // Answers one request frame (header + payload) by appending the reply
+    // frame; false for a malformed request, which ends a connection.
+    bool handle(std::string_view request, std::string &reply) {
+        PartitionRequest h;
+        if (request.size() < sizeof(h)) return false;
+        std::memcpy(&h, request.data(), sizeof(h));
+        if (h.payloadBytes != request.size() - sizeof(h) || h.payloadBytes > kMaxPartitionRequestPayload) return false;
+        const std::string_view payload = request.substr(sizeof(h));
+        RentalOutcome o;
+        switch (h.call) {
+        case PartitionCall::Hello:
+            if (h.vehicleId != static_cast<std::int32_t>(kPartitionProtocolVersion) ||
+                static_cast<std::uint32_t>(h.days) != kSnapshotByteOrder) {
+                o.status = RentalStatus::PartitionUnavailable; // incompatible peer
+            }
+            break;
+        case PartitionCall::Rent:
+            o = manager.tryRentVehicle(std::string(payload), h.vehicleId, h.days, h.amount);
+            break;
+        case PartitionCall::Return:
+            o = manager.tryReturnVehicle(std::string(payload), h.vehicleId, h.days, (h.flags & 1) != 0);
+            break;
+        case PartitionCall::Charge:
+            o = manager.tryChargeBattery(h.vehicleId, h.amount);
+            break;
+        case PartitionCall::ListFleet: {
+            if (h.flags > static_cast<std::uint8_t>(FleetFilter::Rented)) return false;
+            std::ostringstream text;
+            manager.listFleet(static_cast<FleetFilter>(h.flags), text);
+            appendPartitionReply(reply, o, text.str());
+            return true;
+        }
+        case PartitionCall::Stats: {
+            const PartitionStats st = stats();
+            appendPartitionReply(reply, o, std::string_view(reinterpret_cast<const char*>(&st), sizeof(st)));
+            return true;
+        }
+        default:
+            return false;
+        }
+        appendPartitionReply(reply, o);
+        return true;
+    }
+
+#ifndef _WIN32
+    // Starts accepting TCP connections on `port` (0 = any free port) of the
+    // IPv4 `address` and returns the port bound. The protocol has no
+    // authentication, so the default is loopback only; pass "0.0.0.0" or a
+    // host address to serve other machines. Throws std::runtime_error for a
+    // bad address or if it cannot listen.
+    std::uint16_t listen(std::uint16_t port, const std::string &address = "127.0.0.1") {
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(port);
+        if (::inet_pton(AF_INET, address.c_str(), &addr.sin_addr) != 1) {
+            throw std::runtime_error("Bad partition bind address " + address);
+        }
+        int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+        if (fd < 0) throw std::runtime_error("Cannot create partition socket");
+        int one = 1;
+        ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        socklen_t len = sizeof(addr);
+        if (::bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 || ::listen(fd, 64) < 0 ||
+            ::getsockname(fd, reinterpret_cast<sockaddr*>(&addr), &len) < 0) {
+            ::close(fd);
+            throw std::runtime_error("Cannot listen on partition port " + address + ":" + std::to_string(port));
+        }
+        listenFd = fd;
+        acceptor = std::thread(&BasicPartitionServer::acceptLoop, this);
+        return ntohs(addr.sin_port);
+    }
+
+    // blocks until stop() is called from another thread
+    void wait() {
+        std::unique_lock<std::mutex> lk(mutex);
+        stopped.wait(lk, [&] { return stopping; });
+    }
+#endif
+
+    // closes the listening socket and every connection, then joins their
+    // threads; safe to call from several threads and again later
+    void stop() {
+#ifndef _WIN32
+        std::lock_guard<std::mutex> once(stopMutex);
+        {
+            std::lock_guard<std::mutex> lk(mutex);
+            stopping = true;
+            stopped.notify_all();
+            if (listenFd >= 0) ::shutdown(listenFd, SHUT_RDWR);
+            for (const Session &sn : sessions) {
+                if (sn.fd >= 0) ::shutdown(sn.fd, SHUT_RDWR);
+            }
+        }
+        if (acceptor.joinable()) acceptor.join();
+        // the acceptor is gone, so nothing adds to or reaps the list any more
+        for (Session &sn : sessions) {
+            if (sn.thread.joinable()) sn.thread.join();
+        }
+        sessions.clear();
+        if (listenFd >= 0) {
+            ::close(listenFd);
+            listenFd = -1;
+        }
+#endif
+    }
+};
+
+using PartitionServer = BasicPartitionServer<RentalManager>;
+
+// One request/reply channel to a partition. exchange() returns false when the
+// partition cannot be reached; a call that fails after its request went out
+// may or may not have been applied.
+class PartitionLink {
+public:
+    virtual ~PartitionLink() = default;
+    virtual bool exchange(const std::string &request, std::string &reply) = 0;
+};
+
+// partition in the same process; still goes through the wire encoding
+template <class Manager>
+class BasicLocalPartitionLink : public PartitionLink {
+    BasicPartitionServer<Manager> &server;
+
+public:
+    explicit BasicLocalPartitionLink(BasicPartitionServer<Manager> &s) : server(s) {}
+
+    bool exchange(const std::string &request, std::string &reply) override {
+        reply.clear();
+        return server.handle(request, reply);
+    }
+};
+
+using LocalPartitionLink = BasicLocalPartitionLink<RentalManager>;
+
+#ifndef _WIN32
+// TCP connection to a PartitionServer. Connects (and says Hello) on first use
+// and again after any failure; connect, send and receive are each bounded by
+// `timeout`, so a dead host surfaces as unavailable instead of a hang.
+class SocketPartitionLink : public PartitionLink {
+    std::string host;
+    std::uint16_t port;
+    std::chrono::milliseconds timeout;
+    int fd = -1;
+
+    void drop() {
+        if (fd >= 0) ::close(fd);
+        fd = -1;
+    }
+
+    bool connectTo(const addrinfo &ai) {
+        fd = ::socket(ai.ai_family, ai.ai_socktype, ai.ai_protocol);
+        if (fd < 0) return false;
+        const int flags = ::fcntl(fd, F_GETFL, 0);
+        ::fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+        int rc = ::connect(fd, ai.ai_addr, ai.ai_addrlen);
+        if (rc < 0 && errno == EINPROGRESS) {
+            pollfd p{fd, POLLOUT, 0};
+            int err = 0;
+            socklen_t len = sizeof(err);
+            rc = ::poll(&p, 1, static_cast<int>(timeout.count())) == 1 &&
+                         ::getsockopt(fd, SOL_SOCKET, SO_ERROR, &err, &len) == 0 && err == 0 ? 0 : -1;
+        }
+        if (rc < 0) {
+            drop();
+            return false;
+        }
+        ::fcntl(fd, F_SETFL, flags);
+        timeval tv{static_cast<time_t>(timeout.count() / 1000), static_cast<suseconds_t>(timeout.count() % 1000 * 1000)};
+        ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+        ::setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+        int one = 1;
+        ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        return true;
+    }
+
+    bool roundTrip(const std::string &request, std::string &reply) {
+        return socketWriteFull(fd, request.data(), request.size()) && socketReadFrame<PartitionReply>(fd, reply, kMaxPartitionPayload);
+    }
+
+    bool connectNow() {
+        addrinfo hints{};
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+        addrinfo *found = nullptr;
+        if (::getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &found) != 0) return false;
+        for (addrinfo *ai = found; ai && fd < 0; ai = ai->ai_next) connectTo(*ai);
+        ::freeaddrinfo(found);
+        if (fd < 0) return false;
+        std::string reply;
+        PartitionReply h;
+        const std::string hello = encodePartitionRequest(PartitionCall::Hello, static_cast<int>(kPartitionProtocolVersion),
+                                                         static_cast<int>(kSnapshotByteOrder), 0.0);
+        if (!roundTrip(hello, reply) || !decodePartitionReply(reply, h) || h.status != RentalStatus::Ok) {
+            drop();
+            return false;
+        }
+        return true;
+    }
+
+public:
+    SocketPartitionLink(std::string hostName, std::uint16_t portNumber,
+                        std::chrono::milliseconds ioTimeout = std::chrono::seconds(2))
+        : host(std::move(hostName)), port(portNumber), timeout(ioTimeout) {}
+    ~SocketPartitionLink() override { drop(); }
+
+    SocketPartitionLink(const SocketPartitionLink&) = delete;
+    SocketPartitionLink& operator=(const SocketPartitionLink&) = delete;
+
+    bool exchange(const std::string &request, std::string &reply) override {
+        if (fd < 0 && !connectNow()) return false;
+        if (roundTrip(request, reply)) return true;
+        drop();
+        return false;
+    }
+};
+#endif
+
+// vehicle counts merged over the partitions that answered
+struct FleetUtilization {
+    std::uint64_t vehicles[4] = {}; // [VehicleKind]
+    std::uint64_t rented[4] = {};
+    std::vector<std::size_t> unavailable; // partitions (in range order) that did not answer
+
+    std::uint64_t activeRentals() const { return rented[0] + rented[1] + rented[2] + rented[3]; }
+
+    // rented share of the fleet of one kind, 0 for an empty kind
+    double utilization(VehicleKind k) const {
+        std::size_t i = static_cast<std::size_t>(k);
+        return vehicles[i] ? static_cast<double>(rented[i]) / static_cast<double>(vehicles[i]) : 0.0;
+    }
+};
+
+// Front end of a partitioned fleet, with the calling conventions of
+// RentalManager: try* return RentalOutcome, the others throw. Ids outside
+// every range are NotFound; a partition that does not answer gives
+// RentalStatus::PartitionUnavailable / PartitionUnavailableException. Each
+// link carries one exchange at a time, so concurrent callers of the same
+// partition queue on it. Add all partitions before routing.
+class PartitionRouter {
+    struct Partition {
+        int firstId;
+        int lastId;
+        std::unique_ptr<PartitionLink> link;
+        std::unique_ptr<std::mutex> mutex;
+    };
+    std::vector<Partition> partitions; // sorted by firstId, ranges disjoint
+
+    Partition* owner(int vehicleId) {
+        auto it = std::upper_bound(partitions.begin(), partitions.end(), vehicleId,
+                                   [](int id, const Partition &p) { return id < p.firstId; });
+        if (it == partitions.begin()) return nullptr;
+        --it;
+        return vehicleId <= it->lastId ? &*it : nullptr;
+    }
+
+    static bool exchange(Partition &p, const std::string &request, std::string &reply) {
+        std::lock_guard<std::mutex> lk(*p.mutex);
+        return p.link->exchange(request, reply);
+    }
+
+    RentalOutcome call(PartitionCall call, const std::string &memberId, int vehicleId, int days, double amount,
+                       bool damaged = false) {
+        RentalOutcome o;
+        o.vehicleId = vehicleId;
+        Partition *p = owner(vehicleId);
+        if (!p) {
+            o.status = RentalStatus::NotFound;
+            return o;
+        }
+        std::string reply;
+        PartitionReply h;
+        if (!exchange(*p, encodePartitionRequest(call, vehicleId, days, amount, damaged ? 1 : 0, memberId), reply) ||
+            !decodePartitionReply(reply, h)) {
+            o.status = RentalStatus::PartitionUnavailable;
+            return o;
+        }
+        return partitionOutcome(h);
+    }
+
+    // sends the same request to every partition concurrently; the reply
+    // payloads come back in range order, nullopt where there was no answer
+    std::vector<std::optional<std::string>> gather(PartitionCall call, std::uint8_t flags) {
+        const std::string request = encodePartitionRequest(call, 0, 0, 0.0, flags);
+        std::vector<std::optional<std::string>> payloads(partitions.size());
+        auto one = [&](std::size_t i) {
+            std::string reply;
+            PartitionReply h;
+            if (exchange(partitions[i], request, reply) && decodePartitionReply(reply, h) && h.status == RentalStatus::Ok) {
+                payloads[i] = reply.substr(sizeof(h));
+            }
+        };
+        std::vector<std::thread> pool;
+        for (std::size_t i = 1; i < partitions.size(); ++i) pool.emplace_back(one, i);
+        if (!partitions.empty()) one(0);
+        for (std::thread &t : pool) t.join();
+        return payloads;
+    }
+
+public:
+    // Routes ids [firstId, lastId] to `link`. Throws std::invalid_argument for
+    // an empty range or one overlapping an earlier partition.
+    void addPartition(int firstId, int lastId, std::unique_ptr<PartitionLink> link) {
+        if (firstId > lastId || !link) throw std::invalid_argument("Invalid partition range");
+        auto it = std::upper_bound(partitions.begin(), partitions.end(), firstId,
+                                   [](int id, const Partition &p) { return id < p.firstId; });
+        if ((it != partitions.end() && it->firstId <= lastId) || (it != partitions.begin() && std::prev(it)->lastId >= firstId)) {
+            throw std::invalid_argument("Partition range " + std::to_string(firstId) + ".." + std::to_string(lastId) +
+                                        " overlaps an existing partition");
+        }
+        partitions.insert(it, Partition{firstId, lastId, std::move(link), std::make_unique<std::mutex>()});
+    }
+
+    std::size_t partitionCount() const { return partitions.size(); }
+
+    RentalOutcome tryRentVehicle(const std::string &memberId, int vehicleId, int days, double loadKg = 0.0) {
+        return call(PartitionCall::Rent, memberId, vehicleId, days, loadKg);
+    }
+
+    RentalOutcome tryReturnVehicle(const std::string &memberId, int vehicleId, int actualDays, bool damageFlag) {
+        return call(PartitionCall::Return, memberId, vehicleId, actualDays, 0.0, damageFlag);
+    }
+
+    RentalOutcome tryChargeBattery(int vehicleId, double kwh) {
+        return call(PartitionCall::Charge, std::string(), vehicleId, 0, kwh);
+    }
+
+    void rentVehicle(const std::string &memberId, int vehicleId, int days, double loadKg = 0.0) noexcept(false) {
+        RentalOutcome o = tryRentVehicle(memberId, vehicleId, days, loadKg);
+        if (!o.ok()) RentalManager::raiseFailure(RentalOp::Rent, o);
+    }
+
+    void returnVehicle(const std::string &memberId, int vehicleId, int actualDays, bool damageFlag) noexcept(false) {
+        RentalOutcome o = tryReturnVehicle(memberId, vehicleId, actualDays, damageFlag);
+        if (!o.ok()) RentalManager::raiseFailure(RentalOp::Return, o);
+    }
+
+    void chargeBattery(int vehicleId, double kwh) noexcept(false) {
+        RentalOutcome o = tryChargeBattery(vehicleId, kwh);
+        if (!o.ok()) RentalManager::raiseFailure(RentalOp::Charge, o);
+    }
+
+    // One "Fleet:" listing of every partition's vehicles, in id-range order.
+    // Returns how many partitions did not answer; their vehicles are missing.
+    std::size_t listFleet(FleetFilter filter = FleetFilter::All, std::ostream &out = std::cout) {
+        static constexpr std::string_view kHeader = "Fleet:\n";
+        std::size_t missing = 0;
+        out << kHeader;
+        for (const auto &text : gather(PartitionCall::ListFleet, static_cast<std::uint8_t>(filter))) {
+            if (!text) {
+                ++missing;
+                continue;
+            }
+            std::string_view body(*text);
+            if (body.substr(0, kHeader.size()) == kHeader) body.remove_prefix(kHeader.size());
+            out.write(body.data(), static_cast<std::streamsize>(body.size()));
+        }
+        out.flush();
+        return missing;
+    }
+
+    FleetUtilization utilization() {
+        FleetUtilization u;
+        std::vector<std::optional<std::string>> replies = gather(PartitionCall::Stats, 0);
+        for (std::size_t i = 0; i < replies.size(); ++i) {
+            PartitionStats st;
+            if (!replies[i] || replies[i]->size() != sizeof(st)) {
+                u.unavailable.push_back(i);
+                continue;
+            }
+            std::memcpy(&st, replies[i]->data(), sizeof(st));
+            for (std::size_t k = 0; k < 4; ++k) {
+                u.vehicles[k] += st.vehicles[k];
+                u.rented[k] += st.rented[k];
+            }
+        }
+        return u;
+    }
+};
+
+// ---------------------------------------------------------------------------
+// Discrete-event fleet simulation: `./rental simulate [key=value ...]`
+// ---------------------------------------------------------------------------
+
+struct SimulationConfig {
+    int cars = 2000;
+    int trucks = 500;
+    int evs = 1500;
+    int members = 10000;
+    double days = 90.0;                 // simulated horizon
+    double rentsPerHour = 60.0;         // Poisson arrival rate of rent requests
+    double chargesPerHour = 20.0;       // Poisson arrival rate of EV charge requests
+    double meanRentalDays = 3.0;        // booked length (geometric, at least 1)
+    double lateReturnProbability = 0.1; // returns 1-3 days after the due date
+    double damageProbability = 0.02;    // return reports damage
+    double truckShare = 0.15;           // share of requests asking for a truck
+    double evShare = 0.35;              // share asking for an EV, rest ask for a car
+    double maxTruckLoadKg = 1200.0;     // requested loads are uniform in [0, max]
+    double chargeKwh = 30.0;
+    std::uint64_t seed = 1;
+};
+
+struct SimulationReport {
+    std::uint64_t events = 0;
+    std::uint64_t rentAttempts = 0;
+    std::uint64_t rents = 0;
+    std::uint64_t returns = 0;
+    std::uint64_t charges = 0;
+    std::uint64_t failures[kRentalStatusCount] = {};
+    double revenue = 0.0;   // base + penalty collected on returns
+    double penalties = 0.0; // late and minor damage fees
+    double utilization[3] = {}; // time-averaged share rented: Car, Truck, Electric
+    double wallSeconds = 0.0;
+
+    void print(std::ostream &os) const {
+        os << "events=" << events << " wall_s=" << wallSeconds
+           << " events_per_s=" << (wallSeconds > 0 ? events / wallSeconds : 0.0) << "\n";
+        os << "rent_attempts=" << rentAttempts << " rents=" << rents << " returns=" << returns
+           << " charges=" << charges << "\n";
+        os << "revenue=" << revenue << " penalties=" << penalties << "\n";
+        os << "utilization car=" << utilization[0] << " truck=" << utilization[1]
+           << " ev=" << utilization[2] << "\n";
+        os << "failures:";
+        for (std::size_t s = 1; s < kRentalStatusCount; ++s) {
+            if (failures[s]) os << " " << toString(static_cast<RentalStatus>(s)) << "=" << failures[s];
+        }
+        os << "\n";
+    }
+};
+
+// Generates rent/return/charge/damage events from the configured arrival
+// processes into a time-ordered queue and runs them through the manager's
+// non-throwing API on a SimulatedClock. Nothing is printed or logged while
+// running; give the manager a disabled Logger and echoToStdout=false.
+template <class Manager>
+class BasicFleetSimulation {
+    enum class EventType : std::uint8_t { RentArrival, Return, ChargeArrival };
+
+    struct Event {
+        std::int64_t at; // simulated seconds since start
+        EventType type;
+        int vehicleId;   // Return only
+        int member;      // Return only
+        int actualDays;  // Return only
+        bool damaged;    // Return only
+    };
+
+    struct Later {
+        bool operator()(const Event &a, const Event &b) const { return a.at > b.at; }
+    };
+
+    Manager &manager;
+    SimulatedClock &clock;
+    SimulationConfig cfg;
+    std::mt19937_64 rng;
+    std::priority_queue<Event, std::vector<Event>, Later> queue;
+    std::vector<std::string> memberIds;
+    Clock::time_point epoch;
+
+    // fleet layout: cars [1, cars], trucks next, EVs last
+    int firstTruck() const { return cfg.cars + 1; }
+    int firstEv() const { return cfg.cars + cfg.trucks + 1; }
+    int kindIndex(int id) const { return id < firstTruck() ? 0 : (id < firstEv() ? 1 : 2); }
+
+    std::int64_t nextArrival(double perHour) {
+        std::exponential_distribution<double> gap(perHour / 3600.0);
+        return static_cast<std::int64_t>(gap(rng)) + 1;
+    }
+
+    int pick(int first, int count) {
+        return first + static_cast<int>(rng() % static_cast<std::uint64_t>(count));
+    }
+
+public:
+    BasicFleetSimulation(Manager &m, SimulatedClock &c, const SimulationConfig &config)
+        : manager(m), clock(c), cfg(config), rng(config.seed), epoch(c.now()) {}
+
+    // adds the configured fleet to the manager
+    void populate() {
+        int id = 1;
+        for (int i = 0; i < cfg.cars; ++i, ++id) manager.addVehicle(Car(id, "Sim Car", 200.0, 4 + i % 4));
+        for (int i = 0; i < cfg.trucks; ++i, ++id) manager.addVehicle(Truck(id, "Sim Truck", 400.0, 500.0 + 250.0 * (i % 4)));
+        std::uniform_real_distribution<double> charge(0.0, 75.0);
+        for (int i = 0; i < cfg.evs; ++i, ++id) manager.addVehicle(ElectricCar(id, "Sim EV", 350.0, 75.0, charge(rng)));
+    }
+
+    SimulationReport run() {
+        SimulationReport rep;
+        memberIds.clear();
+        for (int i = 0; i < cfg.members; ++i) memberIds.push_back("M" + std::to_string(i));
+
+        const std::int64_t horizon = static_cast<std::int64_t>(cfg.days * 86400.0);
+        const int fleetByKind[3] = {cfg.cars, cfg.trucks, cfg.evs};
+        int rentedByKind[3] = {0, 0, 0};
+        double rentedSeconds[3] = {0.0, 0.0, 0.0};
+        std::int64_t lastAt = 0;
+
+        std::geometric_distribution<int> bookedDays(1.0 / std::max(1.0, cfg.meanRentalDays));
+        std::uniform_real_distribution<double> unit(0.0, 1.0);
+
+        if (cfg.rentsPerHour > 0) queue.push(Event{nextArrival(cfg.rentsPerHour), EventType::RentArrival, 0, 0, 0, false});
+        if (cfg.chargesPerHour > 0 && cfg.evs > 0) {
+            queue.push(Event{nextArrival(cfg.chargesPerHour), EventType::ChargeArrival, 0, 0, 0, false});
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        while (!queue.empty() && queue.top().at <= horizon) {
+            Event e = queue.top();
+            queue.pop();
+            for (int k = 0; k < 3; ++k) rentedSeconds[k] += static_cast<double>(rentedByKind[k]) * (e.at - lastAt);
+            lastAt = e.at;
+            clock.set(epoch + std::chrono::seconds(e.at));
+            ++rep.events;
+
+            switch (e.type) {
+            case EventType::RentArrival: {
+                queue.push(Event{e.at + nextArrival(cfg.rentsPerHour), EventType::RentArrival, 0, 0, 0, false});
+                double r = unit(rng);
+                int id;
+                double load = 0.0;
+                if (r < cfg.truckShare && cfg.trucks > 0) {
+                    id = pick(firstTruck(), cfg.trucks);
+                    load = unit(rng) * cfg.maxTruckLoadKg;
+                } else if (r < cfg.truckShare + cfg.evShare && cfg.evs > 0) {
+                    id = pick(firstEv(), cfg.evs);
+                } else if (cfg.cars > 0) {
+                    id = pick(1, cfg.cars);
+                } else {
+                    break;
+                }
+                int member = static_cast<int>(rng() % memberIds.size());
+                int days = bookedDays(rng) + 1;
+                ++rep.rentAttempts;
+                RentalOutcome o = manager.tryRentVehicle(memberIds[member], id, days, load);
+                if (!o.ok()) {
+                    ++rep.failures[static_cast<int>(o.status)];
+                    break;
+                }
+                ++rep.rents;
+                ++rentedByKind[kindIndex(id)];
+                int actual = days;
+                if (unit(rng) < cfg.lateReturnProbability) actual += 1 + static_cast<int>(rng() % 3);
+                bool damaged = unit(rng) < cfg.damageProbability;
+                queue.push(Event{e.at + 86400LL * actual, EventType::Return, id, member, actual, damaged});
+                break;
+            }
+            case EventType::Return: {
+                RentalOutcome o = manager.tryReturnVehicle(memberIds[e.member], e.vehicleId, e.actualDays, e.damaged);
+                --rentedByKind[kindIndex(e.vehicleId)];
+                if (!o.ok()) {
+                    ++rep.failures[static_cast<int>(o.status)];
+                    break;
+                }
+                ++rep.returns;
+                rep.revenue += o.cost;
+                rep.penalties += o.penalty;
+                break;
+            }
+            case EventType::ChargeArrival: {
+                queue.push(Event{e.at + nextArrival(cfg.chargesPerHour), EventType::ChargeArrival, 0, 0, 0, false});
+                RentalOutcome o = manager.tryChargeBattery(pick(firstEv(), cfg.evs), cfg.chargeKwh);
+                if (o.ok()) ++rep.charges;
+                else ++rep.failures[static_cast<int>(o.status)];
+                break;
+            }
+            }
+        }
+        for (int k = 0; k < 3; ++k) rentedSeconds[k] += static_cast<double>(rentedByKind[k]) * (horizon - lastAt);
+        rep.wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        for (int k = 0; k < 3; ++k) {
+            if (fleetByKind[k] > 0 && horizon > 0) {
+                rep.utilization[k] = rentedSeconds[k] / (static_cast<double>(fleetByKind[k]) * horizon);
+            }
+        }
+        return rep;
+    }
+};
+
+using FleetSimulation = BasicFleetSimulation<RentalManager>;
+
+// `./rental simulate cars=2000 trucks=500 evs=1500 days=90 rents_per_hour=60 seed=1`
+int runSimulation(const std::vector<std::string> &args) {
+    SimulationConfig cfg;
+    for (const std::string &arg : args) {
+        std::size_t eq = arg.find('=');
+        if (eq == std::string::npos) {
+            std::cerr << "Expected key=value, got: " << arg << std::endl;
+            return 1;
+        }
+        std::string key = arg.substr(0, eq);
+        double value = std::atof(arg.c_str() + eq + 1);
+        if (key == "cars") cfg.cars = static_cast<int>(value);
+        else if (key == "trucks") cfg.trucks = static_cast<int>(value);
+        else if (key == "evs") cfg.evs = static_cast<int>(value);
+        else if (key == "members") cfg.members = std::max(1, static_cast<int>(value));
+        else if (key == "days") cfg.days = value;
+        else if (key == "rents_per_hour") cfg.rentsPerHour = value;
+        else if (key == "charges_per_hour") cfg.chargesPerHour = value;
+        else if (key == "mean_rental_days") cfg.meanRentalDays = value;
+        else if (key == "late_probability") cfg.lateReturnProbability = value;
+        else if (key == "damage_probability") cfg.damageProbability = value;
+        else if (key == "truck_share") cfg.truckShare = value;
+        else if (key == "ev_share") cfg.evShare = value;
+        else if (key == "seed") cfg.seed = static_cast<std::uint64_t>(value);
+        else {
+            std::cerr << "Unknown simulation option: " << key << std::endl;
+            return 1;
+        }
+    }
+
+    SimulatedClock clock;
+    Logger logger("", LoggerOptions::disabled());
+    ManagerOptions mopts;
+    mopts.echoToStdout = false;
+    mopts.clock = &clock;
+    RentalManager manager(logger, mopts);
+    FleetSimulation sim(manager, clock, cfg);
+    sim.populate();
+    sim.run().print(std::cout);
+    return 0;
+}
+
+// ---------------------------------------------------------------------------
+// Scenario replay: `./rental replay FILE... [threads=N] [print=1]`
+// ---------------------------------------------------------------------------
+//
+// Runs SCENARIO-style scripts against a RentalManager on a SimulatedClock.
+// One command per line:
+//   AddVehicle: Car, id=1, name="Avanza", rate=200, capacity=7
+//   AddVehicle: Truck, id=2, name="Hino Dutro", rate=400, maxLoadKg=1000
+//   AddVehicle: ElectricCar, id=3, name="Tesla Model 3", rate=350, battery=5/75
+//   RentVehicle: id=1, member="Aldi", days=3, loadKg=500     (loadKg optional)
+//   ReturnVehicle: id=1, actualDays=3, damaged=false         (member= optional, defaults to the renter)
+//   ChargeVehicle: id=3, amount=30
+//   AdvanceClock: days=2                                     (or hours=)
+//   PrintFleetStatus()
+// Every command also takes expect=<RentalStatus or exception type> and, for
+// rent/return, cost=<amount>. "SCENARIO <name>" starts a named block;
+// "EXPECTED:" starts its expectations, of which "Exception: <type>" and
+// "Status: <RentalStatus>" are checked against the block's last command and
+// everything else is prose. Banners of '=', blank lines and '#' comments are
+// skipped.
+//
+// Scripts are parsed as a stream into a reused array of fixed-size commands
+// (kScenarioChunk at a time) and executed chunk by chunk, so a trace with
+// tens of millions of commands runs in bounded memory.
+
+enum class ScenarioOp : std::uint8_t { AddCar, AddTruck, AddEv, Rent, Return, Charge, Advance, PrintFleet };
+
+enum class ScenarioExpect : std::uint8_t { None, Status, Exception };
+
+// exception types a check can name; index 0 is success (exceptionName's "none")
+constexpr const char *kScenarioExceptions[] = {
+    "none", "VehicleNotAvailable", "OverloadException", "BatteryLowException", "InvalidReturnException",
+    "PartitionUnavailableException", "VehicleException"
+};
+
+struct ScenarioCommand {
+    ScenarioOp op;
+    ScenarioExpect expect = ScenarioExpect::None;
+    std::uint8_t expected = 0; // RentalStatus, or index into kScenarioExceptions
+    std::uint8_t flags = 0;    // kDamaged | kCheckCost | kHasMember
+    std::int32_t vehicleId = 0;
+    std::int32_t days = 0;     // Rent: days, Return: actualDays, AddCar: capacity
+    std::uint32_t text = 0;    // Rent/Return: member string, Add*: model string
+    std::uint32_t line = 0;
+    double x = 0.0;            // Rent: loadKg, Charge: kWh, Add*: rate, Advance: seconds
+    double y = 0.0;            // AddTruck: maxLoadKg, AddEv: charge
+    double z = 0.0;            // AddEv: capacity, Rent/Return: expected cost
+
+    static constexpr std::uint8_t kDamaged = 1;
+    static constexpr std::uint8_t kCheckCost = 2;
+    static constexpr std::uint8_t kHasMember = 4;
+};
+
+constexpr std::size_t kScenarioChunk = 1 << 16;
+
+struct ScenarioReport {
+    std::string path;
+    std::uint64_t commands = 0;
+    std::uint64_t scenarios = 0;
+    std::uint64_t checks = 0;
+    std::uint64_t failures = 0;    // failed checks
+    std::uint64_t parseErrors = 0;
+    std::vector<std::string> messages; // first kMaxMessages failures and parse errors
+    std::string output;                // PrintFleetStatus output when print=1
+    double wallSeconds = 0.0;
+
+    static constexpr std::size_t kMaxMessages = 20;
+
+    bool ok() const { return failures == 0 && parseErrors == 0; }
+
+    void note(std::string msg) {
+        if (messages.size() < kMaxMessages) messages.push_back(std::move(msg));
+    }
+
+    void print(std::ostream &os) const {
+        os << output;
+        os << path << ": " << (ok() ? "PASS" : "FAIL") << " commands=" << commands << " scenarios=" << scenarios
+           << " checks=" << checks << " failed=" << failures << " parse_errors=" << parseErrors
+           << " wall_s=" << wallSeconds << " commands_per_s=" << (wallSeconds > 0 ? commands / wallSeconds : 0.0) << "\n";
+        for (const std::string &m : messages) os << "  " << m << "\n";
+        const std::uint64_t noted = failures + parseErrors;
+        if (noted > messages.size()) os << "  ... " << noted - messages.size() << " more\n";
+    }
+};
+
+// Line-by-line compiler from script text to ScenarioCommands. Strings
+// (members, models) are interned once and referenced by index.
+class ScenarioParser {
+    struct Field {
+        std::string_view key;   // empty for a bare word such as "Car"
+        std::string_view value;
+    };
+
+    std::deque<std::string> stringStore;
+    std::unordered_map<std::string_view, std::uint32_t> stringIndex;
+    std::vector<Field> fields;
+    bool inScenario = false; // a block is open, so Exception:/Status: lines have a target
+    bool haveLast = false;   // the block has a command to attach them to
+    bool inExpected = false; // after EXPECTED:, where lines other than commands are prose
+
+    static std::string_view trim(std::string_view s) {
+        while (!s.empty() && (s.front() == ' ' || s.front() == '\t')) s.remove_prefix(1);
+        while (!s.empty() && (s.back() == ' ' || s.back() == '\t' || s.back() == '\r')) s.remove_suffix(1);
+        return s;
+    }
+
+    static bool startsWith(std::string_view s, std::string_view prefix) {
+        return s.substr(0, prefix.size()) == prefix;
+    }
+
+    // splits `a=1, name="x, y", Car` into fields; quotes are stripped
+    bool splitFields(std::string_view s) {
+        fields.clear();
+        while (true) {
+            s = trim(s);
+            if (s.empty()) return true;
+            Field f;
+            std::size_t i = 0;
+            while (i < s.size() && s[i] != '=' && s[i] != ',') ++i;
+            if (i < s.size() && s[i] == '=') {
+                f.key = trim(s.substr(0, i));
+                s = trim(s.substr(i + 1));
+                if (!s.empty() && s.front() == '"') {
+                    std::size_t close = s.find('"', 1);
+                    if (close == std::string_view::npos) return false;
+                    f.value = s.substr(1, close - 1);
+                    s = trim(s.substr(close + 1));
+                } else {
+                    std::size_t comma = s.find(',');
+                    f.value = trim(s.substr(0, comma));
+                    s = comma == std::string_view::npos ? std::string_view() : s.substr(comma);
+                }
+            } else {
+                f.value = trim(s.substr(0, i));
+                s = s.substr(i);
+            }
+            fields.push_back(f);
+            s = trim(s);
+            if (s.empty()) return true;
+            if (s.front() != ',') return false;
+            s.remove_prefix(1);
+        }
+    }
+
+    const Field* field(std::string_view key) const {
+        for (const Field &f : fields) {
+            if (f.key == key) return &f;
+        }
+        return nullptr;
+    }
+
+    template <class T>
+    static bool number(std::string_view s, T &out) {
+        auto r = std::from_chars(s.data(), s.data() + s.size(), out);
+        return r.ec == std::errc() && r.ptr == s.data() + s.size();
+    }
+
+    template <class T>
+    bool required(std::string_view key, T &out) const {
+        const Field *f = field(key);
+        return f && number(f->value, out);
+    }
+
+    template <class T>
+    bool optional(std::string_view key, T &out) const {
+        const Field *f = field(key);
+        return !f || number(f->value, out);
+    }
+
+    static bool boolean(std::string_view s, bool &out) {
+        if (s == "true" || s == "1") out = true;
+        else if (s == "false" || s == "0") out = false;
+        else return false;
+        return true;
+    }
+
+    // a RentalStatus name or one of kScenarioExceptions
+    static bool expectation(std::string_view name, ScenarioCommand &c) {
+        for (std::size_t s = 0; s < kRentalStatusCount; ++s) {
+            if (name == toString(static_cast<RentalStatus>(s))) {
+                c.expect = ScenarioExpect::Status;
+                c.expected = static_cast<std::uint8_t>(s);
+                return true;
+            }
+        }
+        for (std::uint8_t e = 0; e < std::size(kScenarioExceptions); ++e) {
+            if (name == kScenarioExceptions[e]) {
+                c.expect = ScenarioExpect::Exception;
+                c.expected = e;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    static bool isCommand(std::string_view s) {
+        return s == "AddVehicle" || s == "RentVehicle" || s == "ReturnVehicle" || s == "ChargeVehicle" ||
+               s == "AdvanceClock";
+    }
+
+    void error(ScenarioReport &report, std::uint32_t lineNo, const char *what, std::string_view line) {
+        ++report.parseErrors;
+        report.note("line " + std::to_string(lineNo) + ": " + what + " \"" + std::string(line) + "\"");
+    }
+
+    std::uint32_t intern(std::string_view s) {
+        auto it = stringIndex.find(s);
+        if (it != stringIndex.end()) return it->second;
+        std::uint32_t index = static_cast<std::uint32_t>(stringStore.size());
+        stringStore.emplace_back(s);
+        stringIndex.emplace(stringStore.back(), index);
+        return index;
+    }
+
+    // the fields after "Command:" into c; false on a malformed line
+    bool compile(std::string_view command, ScenarioCommand &c) {
+        if (command == "AddVehicle") {
+            if (fields.empty() || !fields[0].key.empty()) return false;
+            const Field *name = field("name");
+            if (!name || !required("id", c.vehicleId) || !required("rate", c.x)) return false;
+            c.text = intern(name->value);
+            std::string_view kind = fields[0].value;
+            if (kind == "Car") {
+                c.op = ScenarioOp::AddCar;
+                return required("capacity", c.days);
+            }
+            if (kind == "Truck") {
+                c.op = ScenarioOp::AddTruck;
+                return required("maxLoadKg", c.y);
+            }
+            if (kind == "ElectricCar") {
+                c.op = ScenarioOp::AddEv;
+                const Field *battery = field("battery"); // charge/capacity
+                if (!battery) return false;
+                std::size_t slash = battery->value.find('/');
+                return slash != std::string_view::npos && number(battery->value.substr(0, slash), c.y) &&
+                       number(battery->value.substr(slash + 1), c.z);
+            }
+            return false;
+        }
+
+        bool withCost = false;
+        if (command == "RentVehicle") {
+            c.op = ScenarioOp::Rent;
+            const Field *member = field("member");
+            if (!member || !required("id", c.vehicleId) || !required("days", c.days) || !optional("loadKg", c.x)) return false;
+            c.text = intern(member->value);
+            c.flags |= ScenarioCommand::kHasMember;
+            withCost = true;
+        } else if (command == "ReturnVehicle") {
+            c.op = ScenarioOp::Return;
+            if (!required("id", c.vehicleId) || !required("actualDays", c.days)) return false;
+            if (const Field *member = field("member")) {
+                c.text = intern(member->value);
+                c.flags |= ScenarioCommand::kHasMember;
+            }
+            if (const Field *damaged = field("damaged")) {
+                bool d;
+                if (!boolean(damaged->value, d)) return false;
+                if (d) c.flags |= ScenarioCommand::kDamaged;
+            }
+            withCost = true;
+        } else if (command == "ChargeVehicle") {
+            c.op = ScenarioOp::Charge;
+            if (!required("id", c.vehicleId) || !required("amount", c.x)) return false;
+        } else if (command == "AdvanceClock") {
+            c.op = ScenarioOp::Advance;
+            double days = 0.0, hours = 0.0;
+            if (!optional("days", days) || !optional("hours", hours) || (!field("days") && !field("hours"))) return false;
+            c.x = days * 86400.0 + hours * 3600.0;
+        } else {
+            return false;
+        }
+        if (const Field *cost = field("cost")) {
+            if (!withCost || !number(cost->value, c.z)) return false;
+            c.flags |= ScenarioCommand::kCheckCost;
+        }
+        return true;
+    }
+
+public:
+    // Compiles one line, appending a command to out or attaching an
+    // EXPECTED check to out.back(), so a caller draining out must keep its
+    // last command. Malformed lines are reported through report.
+    void parseLine(std::string_view raw, std::uint32_t lineNo, std::vector<ScenarioCommand> &out, ScenarioReport &report) {
+        std::string_view line = trim(raw);
+        if (line.empty() || line.front() == '#' || line.front() == '=') return;
+        if (startsWith(line, "SCENARIO")) {
+            ++report.scenarios;
+            inScenario = true;
+            haveLast = false;
+            inExpected = false;
+            return;
+        }
+        if (line == "EXPECTED:") {
+            inExpected = true;
+            return;
+        }
+        if (line == "PrintFleetStatus()" || line == "PrintFleetStatus") {
+            ScenarioCommand c{};
+            c.op = ScenarioOp::PrintFleet;
+            c.line = lineNo;
+            out.push_back(c);
+            return;
+        }
+
+        std::size_t colon = line.find(':');
+        std::string_view command = trim(line.substr(0, colon));
+        std::string_view rest = colon == std::string_view::npos ? std::string_view() : trim(line.substr(colon + 1));
+        if (inExpected && (command == "Exception" || command == "Status")) {
+            ScenarioCommand probe{};
+            if (!inScenario || !haveLast || out.empty() || !expectation(rest, probe) ||
+                (command == "Status") != (probe.expect == ScenarioExpect::Status)) {
+                error(report, lineNo, "cannot attach", line);
+                return;
+            }
+            out.back().expect = probe.expect;
+            out.back().expected = probe.expected;
+            return;
+        }
+        if (colon == std::string_view::npos || !isCommand(command)) {
+            if (!inExpected) error(report, lineNo, "unknown command", line);
+            return;
+        }
+
+        ScenarioCommand c{};
+        c.line = lineNo;
+        bool ok = splitFields(rest) && compile(command, c);
+        if (ok) {
+            if (const Field *expect = field("expect")) ok = expectation(expect->value, c);
+        }
+        if (!ok) {
+            error(report, lineNo, "cannot parse", line);
+            return;
+        }
+        out.push_back(c);
+        haveLast = true;
+    }
+
+    const std::string& string(std::uint32_t index) const { return stringStore[index]; }
+    std::size_t stringCount() const { return stringStore.size(); }
+};
+
+// Executes compiled commands against one manager and checks expectations.
+template <class Manager>
+class BasicScenarioRunner {
+    Manager &manager;
+    SimulatedClock &clock;
+    const ScenarioParser &parser;
+    ScenarioReport &report;
+    std::ostream *print; // PrintFleetStatus target, nullptr = skip
+    std::vector<MemberHandle> handles; // parser string index -> member handle, filled lazily
+
+    MemberHandle member(std::uint32_t text) {
+        if (text >= handles.size()) handles.resize(parser.stringCount(), kNoMember);
+        if (handles[text] == kNoMember) handles[text] = manager.internMember(parser.string(text));
+        return handles[text];
+    }
+
+    static const char* opName(ScenarioOp op) {
+        switch (op) {
+        case ScenarioOp::AddCar:
+        case ScenarioOp::AddTruck:
+        case ScenarioOp::AddEv: return "AddVehicle";
+        case ScenarioOp::Rent: return "RentVehicle";
+        case ScenarioOp::Return: return "ReturnVehicle";
+        case ScenarioOp::Charge: return "ChargeVehicle";
+        case ScenarioOp::Advance: return "AdvanceClock";
+        case ScenarioOp::PrintFleet: return "PrintFleetStatus";
+        }
+        return "?";
+    }
+
+    void fail(const ScenarioCommand &c, const std::string &what) {
+        ++report.failures;
+        report.note("line " + std::to_string(c.line) + ": " + opName(c.op) + " id=" + std::to_string(c.vehicleId) + ": " + what);
+    }
+
+    void check(const ScenarioCommand &c, const RentalOutcome &o) {
+        if (c.expect == ScenarioExpect::Status) {
+            ++report.checks;
+            if (o.status != static_cast<RentalStatus>(c.expected)) {
+                fail(c, std::string("expected ") + toString(static_cast<RentalStatus>(c.expected)) + ", got " + toString(o.status));
+            }
+        } else if (c.expect == ScenarioExpect::Exception) {
+            ++report.checks;
+            const char *got = exceptionName(o.status);
+            if (std::strcmp(got, kScenarioExceptions[c.expected]) != 0) {
+                fail(c, std::string("expected ") + kScenarioExceptions[c.expected] + ", got " + got + " (" + toString(o.status) + ")");
+            }
+        }
+        if (c.flags & ScenarioCommand::kCheckCost) {
+            ++report.checks;
+            if (std::fabs(o.cost - c.z) > 1e-9 * std::max(1.0, std::fabs(c.z))) {
+                std::ostringstream oss;
+                oss << "expected cost " << c.z << ", got " << o.cost << " (" << toString(o.status) << ")";
+                fail(c, oss.str());
+            }
+        }
+    }
+
+public:
+    BasicScenarioRunner(Manager &m, SimulatedClock &c, const ScenarioParser &p, ScenarioReport &r, std::ostream *printTo)
+        : manager(m), clock(c), parser(p), report(r), print(printTo) {}
+
+    void run(const ScenarioCommand *commands, std::size_t n) {
+        for (std::size_t i = 0; i < n; ++i) {
+            const ScenarioCommand &c = commands[i];
+            RentalOutcome o;
+            switch (c.op) {
+            case ScenarioOp::AddCar:
+                manager.addVehicle(Car(c.vehicleId, parser.string(c.text), c.x, c.days));
+                break;
+            case ScenarioOp::AddTruck:
+                manager.addVehicle(Truck(c.vehicleId, parser.string(c.text), c.x, c.y));
+                break;
+            case ScenarioOp::AddEv:
+                manager.addVehicle(ElectricCar(c.vehicleId, parser.string(c.text), c.x, c.z, c.y));
+                break;
+            case ScenarioOp::Rent:
+                o = manager.tryRentVehicle(member(c.text), c.vehicleId, c.days, c.x);
+                break;
+            case ScenarioOp::Return: {
+                MemberHandle who = (c.flags & ScenarioCommand::kHasMember) ? member(c.text) : manager.renterOf(c.vehicleId);
+                o = manager.tryReturnVehicle(who, c.vehicleId, c.days, (c.flags & ScenarioCommand::kDamaged) != 0);
+                break;
+            }
+            case ScenarioOp::Charge:
+                o = manager.tryChargeBattery(c.vehicleId, c.x);
+                break;
+            case ScenarioOp::Advance:
+                clock.advance(std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(c.x)));
+                break;
+            case ScenarioOp::PrintFleet:
+                if (print) manager.listFleet(FleetFilter::All, *print);
+                break;
+            }
+            check(c, o);
+        }
+        report.commands += n;
+    }
+};
+
+using ScenarioRunner = BasicScenarioRunner<RentalManager>;
+
+// Parses and runs one script from `in` on a fresh manager and simulated clock.
+inline ScenarioReport replayScenario(std::istream &in, const std::string &name, bool print = false) {
+    ScenarioReport report;
+    report.path = name;
+    auto start = std::chrono::steady_clock::now();
+    SimulatedClock clock;
+    Logger quiet("", LoggerOptions::disabled());
+    ManagerOptions mopts;
+    mopts.echoToStdout = false;
+    mopts.clock = &clock;
+    RentalManager manager(quiet, mopts);
+    std::ostringstream printed;
+    ScenarioParser parser;
+    ScenarioRunner runner(manager, clock, parser, report, print ? &printed : nullptr);
+
+    std::vector<ScenarioCommand> chunk;
+    chunk.reserve(kScenarioChunk);
+    std::string line;
+    std::uint32_t lineNo = 0;
+    while (std::getline(in, line)) {
+        ++lineNo;
+        parser.parseLine(line, lineNo, chunk, report);
+        if (chunk.size() == kScenarioChunk) {
+            // later EXPECTED lines may still target the last command, so it stays
+            runner.run(chunk.data(), chunk.size() - 1);
+            chunk.front() = chunk.back();
+            chunk.resize(1);
+        }
+    }
+    runner.run(chunk.data(), chunk.size());
+    report.output = printed.str();
+    report.wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return report;
+}
+
+// Replays independent script files on up to `threads` worker threads (0 =
+// one per core); each file gets its own manager, so they never interact.
+// Reports come back in the order of `paths`.
+inline std::vector<ScenarioReport> replayScenarioFiles(const std::vector<std::string> &paths, unsigned threads = 0,
+                                                       bool print = false) {
+    std::vector<ScenarioReport> reports(paths.size());
+    std::atomic<std::size_t> next{0};
+    auto worker = [&] {
+        for (std::size_t i; (i = next.fetch_add(1)) < paths.size();) {
+            std::ifstream in(paths[i], std::ios::binary);
+            if (!in) {
+                reports[i].path = paths[i];
+                ++reports[i].parseErrors;
+                reports[i].note("cannot open file");
+                continue;
+            }
+            reports[i] = replayScenario(in, paths[i], print);
+        }
+    };
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    threads = static_cast<unsigned>(std::min<std::size_t>(threads, paths.size()));
+    std::vector<std::thread> pool;
+    for (unsigned t = 1; t < threads; ++t) pool.emplace_back(worker);
+    worker();
+    for (std::thread &t : pool) t.join();
+    return reports;
+}
+
+int runReplay(const std::vector<std::string> &args) {
+    std::vector<std::string> paths;
+    unsigned threads = 0;
+    bool print = false;
+    for (const std::string &arg : args) {
+        std::size_t eq = arg.find('=');
+        if (eq == std::string::npos) {
+            paths.push_back(arg);
+            continue;
+        }
+        std::string key = arg.substr(0, eq);
+        double value = std::atof(arg.c_str() + eq + 1);
+        if (key == "threads") threads = static_cast<unsigned>(value);
+        else if (key == "print") print = value != 0;
+        else {
+            std::cerr << "Unknown replay option: " << key << std::endl;
+            return 1;
+        }
+    }
+    if (paths.empty()) {
+        std::cerr << "Usage: rental replay FILE... [threads=N] [print=1]" << std::endl;
+        return 1;
+    }
+    bool ok = true;
+    for (const ScenarioReport &r : replayScenarioFiles(paths, threads, print)) {
+        r.print(std::cout);
+        ok = ok && r.ok();
+    }
+    return ok ? 0 : 1;
+}
+
+// `./rental partition port=N [bind=ADDR] [snapshot=FILE] [shards=N]`: serves
+// one partition of a PartitionRouter deployment until the process is killed;
+// the fleet is loaded from a snapshot written by saveSnapshot. bind defaults
+// to 127.0.0.1.
+int runPartition(const std::vector<std::string> &args) {
+#ifdef _WIN32
+    (void)args;
+    std::cerr << "Partition serving needs POSIX sockets" << std::endl;
+    return 1;
+#else
+    std::string snapshot;
+    std::string bind = "127.0.0.1";
+    long port = 9100;
+    std::size_t shards = 64;
+    for (const std::string &arg : args) {
+        std::size_t eq = arg.find('=');
+        std::string key = arg.substr(0, eq);
+        std::string value = eq == std::string::npos ? std::string() : arg.substr(eq + 1);
+        if (key == "port") port = std::atol(value.c_str());
+        else if (key == "bind") bind = value;
+        else if (key == "snapshot") snapshot = value;
+        else if (key == "shards") shards = static_cast<std::size_t>(std::atol(value.c_str()));
+        else {
+            std::cerr << "Unknown partition option: " << key << std::endl;
+            return 1;
+        }
+    }
+    if (port < 0 || port > 65535) {
+        std::cerr << "Usage: rental partition port=N [bind=ADDR] [snapshot=FILE] [shards=N]" << std::endl;
+        return 1;
+    }
+    try {
+        Logger logger("partition_log.txt", LoggerOptions::asyncMode());
+        ManagerOptions opts = ManagerOptions::concurrentMode(shards);
+        opts.echoToStdout = false;
+        RentalManager manager(logger, opts);
+        SnapshotStats loaded;
+        if (!snapshot.empty()) loaded = manager.loadSnapshot(snapshot);
+        PartitionServer server(manager);
+        std::uint16_t bound = server.listen(static_cast<std::uint16_t>(port), bind);
+        std::cout << "Partition with " << loaded.vehicles << " vehicles listening on " << bind << ":" << bound << std::endl;
+        server.wait();
+    } catch (const std::exception &ex) {
+        std::cerr << ex.what() << std::endl;
+        return 1;
+    }
+    return 0;
+#endif
+}
+
+struct LogDecodeStats {
+    std::size_t records = 0; // records written out
+    bool tornTail = false;
+};
+
+// Writes the records of a binary log that pass filter as text log lines,
+// the same bytes a text Logger would have written for them.
+inline LogDecodeStats decodeBinaryLog(const std::string &path, std::ostream &out, const LogFilter &filter = LogFilter()) {
+    BinaryLogReader reader(path);
+    BinaryLogReader::Entry e;
+    LogStamp stamp;
+    LogDecodeStats stats;
+    std::string lines;
+    while (reader.next(e, filter)) {
+        appendLogLines(lines, stamp(fromEpochNs(e.record.whenNs)), RentalManager::logLine(e.record, e.text));
+        ++stats.records;
+        if (lines.size() >= (1u << 16)) {
+            out.write(lines.data(), static_cast<std::streamsize>(lines.size()));
+            lines.clear();
+        }
+    }
+    out.write(lines.data(), static_cast<std::streamsize>(lines.size()));
+    stats.tornTail = reader.tornTail();
+    return stats;
+}
+
+// ./rental decode-log FILE [event=rent,return,...] [vehicle=ID]
+int runDecodeLog(const std::vector<std::string> &args) {
+    std::string path;
+    LogFilter filter;
+    for (const std::string &arg : args) {
+        std::size_t eq = arg.find('=');
+        if (eq == std::string::npos) {
+            path = arg;
+            continue;
+        }
+        std::string key = arg.substr(0, eq);
+        std::string value = arg.substr(eq + 1);
+        if (key == "vehicle") {
+            filter.vehicle(std::atoi(value.c_str()));
+        } else if (key == "event") {
+            std::stringstream names(value);
+            for (std::string name; std::getline(names, name, ',');) {
+                std::size_t e = 0;
+                while (e < kLogEvents && name != toString(static_cast<LogEvent>(e))) ++e;
+                if (e == kLogEvents) {
+                    std::cerr << "Unknown log event: " << name << std::endl;
+                    return 1;
+                }
+                filter.event(static_cast<LogEvent>(e));
+            }
+        } else {
+            std::cerr << "Unknown decode-log option: " << key << std::endl;
+            return 1;
+        }
+    }
+    if (path.empty()) {
+        std::cerr << "Usage: rental decode-log FILE [event=NAME[,NAME...]] [vehicle=ID]" << std::endl;
+        return 1;
+    }
+    try {
+        LogDecodeStats stats = decodeBinaryLog(path, std::cout, filter);
+        std::cout << std::flush;
+        if (stats.tornTail) std::cerr << "Log ends in a partial record" << std::endl;
+    } catch (const std::exception &ex) {
+        std::cerr << ex.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+// ./rental import-fleet FILE [format=csv|columns] [shards=N]: loads a fleet
+// file into a concurrent manager and reports the rows it skipped
+int runImportFleet(const std::vector<std::string> &args) {
+    std::string path;
+    FleetFileFormat format = FleetFileFormat::Auto;
+    std::size_t shardCount = 64;
+    for (const std::string &arg : args) {
+        std::size_t eq = arg.find('=');
+        if (eq == std::string::npos) {
+            path = arg;
+            continue;
+        }
+        std::string key = arg.substr(0, eq);
+        std::string value = arg.substr(eq + 1);
+        if (key == "format" && (value == "csv" || value == "columns")) {
+            format = value == "csv" ? FleetFileFormat::Csv : FleetFileFormat::Columns;
+        } else if (key == "shards") {
+            shardCount = static_cast<std::size_t>(std::max(1, std::atoi(value.c_str())));
+        } else {
+            std::cerr << "Unknown import-fleet option: " << arg << std::endl;
+            return 1;
+        }
+    }
+    if (path.empty()) {
+        std::cerr << "Usage: rental import-fleet FILE [format=csv|columns] [shards=N]" << std::endl;
+        return 1;
+    }
+    try {
+        Logger quiet("", LoggerOptions::disabled());
+        ManagerOptions opts = ManagerOptions::concurrentMode(shardCount);
+        opts.echoToStdout = false;
+        RentalManager manager(quiet, opts);
+        auto start = std::chrono::steady_clock::now();
+        FleetImportStats stats = manager.importFleet(path, format);
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "Imported " << stats.imported << " of " << stats.rows << " rows in " << ms << " ms" << std::endl;
+        const std::size_t shown = std::min<std::size_t>(stats.errors.size(), 20);
+        for (std::size_t i = 0; i < shown; ++i) {
+            const ImportError &e = stats.errors[i];
+            std::cout << "  row " << e.row << " id=" << e.vehicleId << ": " << toString(e.problem) << std::endl;
+        }
+        if (stats.errors.size() > shown) std::cout << "  ... " << stats.errors.size() - shown << " more" << std::endl;
+    } catch (const std::exception &ex) {
+        std::cerr << ex.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+// ---------------------------------------------------------------------------
+// Benchmarks: run with `./rental bench [name]`
+// ---------------------------------------------------------------------------
+#ifdef RENTAL_ALLOC_COUNTER
+// Counts heap allocations per thread so benchmarks can report allocs/op.
+// Bench-only: it replaces the global operator new for the whole program, so
+// it is compiled in only with -DRENTAL_ALLOC_COUNTER.
+namespace allocstats {
+thread_local std::uint64_t count = 0;
+
+// out of line so inlined new/delete pairs are not flagged as malloc/delete mismatches
+#if defined(__GNUC__)
+__attribute__((noinline))
+#endif
+void release(void *p) noexcept { std::free(p); }
+}
+
+void* operator new(std::size_t n) {
+    ++allocstats::count;
+    if (void *p = std::malloc(n ? n : 1)) return p;
+    throw std::bad_alloc();
+}
+void operator delete(void *p) noexcept { allocstats::release(p); }
+void operator delete(void *p, std::size_t) noexcept { allocstats::release(p); }
+#endif
+
+namespace bench {
+
+// heap allocations made by the calling thread so far (0 when the counter is compiled out)
+inline std::uint64_t allocations() {
+#ifdef RENTAL_ALLOC_COUNTER
+    return allocstats::count;
+#else
+    return 0;
+#endif
+}
+
+using BenchClock = std::chrono::steady_clock;
+
+// keeps results observable so the optimizer cannot drop the measured loop
+volatile std::uint64_t sink = 0;
+
+// simple LCG so every run probes the same pseudo-random ids
+struct Lcg {
+    std::uint64_t state;
+    explicit Lcg(std::uint64_t seed) : state(seed) {}
+    std::uint32_t next() {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        return static_cast<std::uint32_t>(state >> 33);
+    }
+};
+
+// throughput plus per-op latency samples (ns) of one measurement
+struct Stats {
+    std::size_t ops = 0;
+    double seconds = 0.0;
+    std::uint64_t allocs = 0; // heap allocations on the measuring thread; stays 0 unless built
+                              // with RENTAL_ALLOC_COUNTER, which alone reports allocs_per_op
+    std::size_t batch = 1;    // ops per sample; above 1 the samples are batch means
+    std::vector<double> samples;
+
+    double opsPerSec() const { return seconds > 0 ? static_cast<double>(ops) / seconds : 0.0; }
+
+    double percentile(double q) {
+        if (samples.empty()) return 0.0;
+        std::size_t k = std::min(samples.size() - 1, static_cast<std::size_t>(q * samples.size()));
+        std::nth_element(samples.begin(), samples.begin() + static_cast<std::ptrdiff_t>(k), samples.end());
+        return samples[k];
+    }
+};
+
+// Runs body(i) for i in [0, ops), reading the clock once per `batch` ops.
+// Each batch adds one sample (batch time / batch), so nanosecond-scale micro
+// ops are not swamped by the clock read; macro ops use batch = 1. Batch means
+// hide single slow ops, so Report labels their percentiles batch_p*_ns.
+template <class F>
+Stats measure(std::size_t ops, std::size_t batch, F &&body) {
+    Stats st;
+    st.ops = ops;
+    batch = std::max<std::size_t>(1, batch);
+    st.batch = batch;
+    st.samples.reserve(ops / batch + 1);
+    std::uint64_t allocsBefore = allocations();
+    auto start = BenchClock::now();
+    auto last = start;
+    for (std::size_t i = 0; i < ops;) {
+        std::size_t end = std::min(ops, i + batch);
+        for (; i < end; ++i) body(i);
+        auto now = BenchClock::now();
+        st.samples.push_back(std::chrono::duration<double, std::nano>(now - last).count() / static_cast<double>(batch));
+        last = now;
+    }
+    st.seconds = std::chrono::duration<double>(last - start).count();
+    // the sample vector was reserved up front, so this counts only body(i)
+    st.allocs = allocations() - allocsBefore;
+    return st;
+}
+
+// One JSON object per line on stdout, so runs of two builds can be diffed or
+// loaded with any JSON-lines tool:
+// {"suite":"micro","name":"lookup","fleet":100000,"ops_per_sec":...,"p50_ns":...,"p99_ns":...,"p999_ns":...}
+// Runs measured in batches report "batch":N and batch_p50_ns.. instead.
+class Report {
+    std::ostringstream line;
+public:
+    Report(const char *suite, const std::string &name) {
+        line << "{\"suite\":\"" << suite << "\",\"name\":\"" << name << "\"";
+    }
+
+    template <class T, typename std::enable_if<std::is_arithmetic<T>::value, int>::type = 0>
+    Report& param(const char *key, T value) {
+        line << ",\"" << key << "\":" << value;
+        return *this;
+    }
+
+    Report& param(const char *key, const std::string &value) {
+        line << ",\"" << key << "\":\"" << value << "\"";
+        return *this;
+    }
+
+    // withLatency=false for runs that only measure throughput (e.g. multi-threaded)
+    void emit(Stats &st, bool withLatency = true) {
+        line << std::setprecision(6) << ",\"ops_per_sec\":" << st.opsPerSec();
+        if (withLatency && !st.samples.empty()) {
+            double p50 = st.percentile(0.50), p99 = st.percentile(0.99), p999 = st.percentile(0.999);
+            const char *prefix = st.batch > 1 ? "batch_" : "";
+            if (st.batch > 1) line << ",\"batch\":" << st.batch;
+            line << ",\"" << prefix << "p50_ns\":" << p50 << ",\"" << prefix << "p99_ns\":" << p99
+                 << ",\"" << prefix << "p999_ns\":" << p999;
+        }
+#ifdef RENTAL_ALLOC_COUNTER
+        if (withLatency && st.ops > 0) line << ",\"allocs_per_op\":" << static_cast<double>(st.allocs) / st.ops;
+#endif
+        line << "}";
+        std::cout << line.str() << std::endl;
+    }
+};
+
+struct Options {
+    std::size_t maxFleet = 10000000; // largest macro fleet size
+    std::size_t macroOps = 1000000;  // operations per macro run
+};
+
+ManagerOptions quietManager(Clock *clock = nullptr) {
+    ManagerOptions o;
+    o.echoToStdout = false;
+    o.clock = clock;
+    return o;
+}
+
+// mixed fleet used by micro and macro runs: ids ending 0-4 Car, 5-6 Truck, 7-9 EV
+void addMixed(RentalManager &manager, int id) {
+    int k = id % 10;
+    if (k < 5) manager.addVehicle(Car(id, "Toyota Avanza", 200.0, 7));
+    else if (k < 7) manager.addVehicle(Truck(id, "Hino Dutro", 400.0, 1000.0));
+    else manager.addVehicle(ElectricCar(id, "Tesla Model 3", 350.0, 75.0, 40.0));
+}
+
+// ----- micro: single hot-path operations -----------------------------------
+void micro() {
+    const std::size_t iters = 2000000;
+    const std::size_t batch = 256;
+    Logger quiet("", LoggerOptions::disabled());
+
+    {
+        const int fleetSize = 100000;
+        RentalManager manager(quiet, quietManager());
+        for (int id = 1; id <= fleetSize; ++id) addMixed(manager, id);
+        Lcg rng(42);
+        Stats st = measure(iters, batch, [&](std::size_t) {
+            int id = static_cast<int>(rng.next() % fleetSize) + 1;
+            sink = sink + (manager.getVehicle(id) != nullptr);
+        });
+        Report("micro", "lookup").param("fleet", fleetSize).emit(st);
+    }
+
+    // steady-state rent + return: pooled vehicles and the flat rental table
+    // should make this allocation-free once warmed up
+    {
+        const int fleetSize = 100000;
+        SimulatedClock clock;
+        RentalManager manager(quiet, quietManager(&clock));
+        for (int id = 1; id <= fleetSize; ++id) addMixed(manager, id);
+        const std::string member = "member42";
+        Lcg rng(9);
+        auto cycle = [&](std::size_t) {
+            int id = static_cast<int>(rng.next() % fleetSize) + 1;
+            if (id % 10 >= 5) id -= 5; // cars only, so every rent succeeds
+            if (id < 1) id = 1;
+            manager.tryRentVehicle(member, id, 2);
+            manager.tryReturnVehicle(member, id, 2, false);
+        };
+        measure(fleetSize, 256, cycle); // warm-up grows the rental table once
+        Stats st = measure(iters / 4, batch, cycle);
+        Report("micro", "rent_return_cycle").param("fleet", fleetSize).emit(st);
+    }
+
+    // overdue feed: a poll with nothing newly due, then polls that each find
+    // one hour's worth of due rentals
+    {
+        const int fleetSize = 100000;
+        SimulatedClock clock;
+        RentalManager manager(quiet, quietManager(&clock));
+        for (int id = 1; id <= fleetSize; ++id) manager.addVehicle(Car(id, "Bench Car", 100.0, 4));
+        Lcg rng(17);
+        for (int id = 1; id <= fleetSize; id += 3) manager.tryRentVehicle("member", id, 1 + static_cast<int>(rng.next() % 14));
+        Stats idle = measure(10000, 16, [&](std::size_t) { sink = sink + manager.pollOverdue().size(); });
+        Report("micro", "overdue_poll.idle").param("fleet", fleetSize).param("active", manager.activeRentalCount()).emit(idle);
+        clock.advanceDays(1);
+        std::size_t found = 0;
+        Stats hourly = measure(24 * 13, 1, [&](std::size_t) {
+            clock.advance(std::chrono::hours(1));
+            found += manager.pollOverdue().size();
+        });
+        Report("micro", "overdue_poll.hourly").param("fleet", fleetSize).param("found", found).emit(hourly);
+    }
+
+    // virtual rentCost through a base pointer, one run per override
+    std::unique_ptr<Vehicle> car = std::make_unique<Car>(1, "Toyota Avanza", 200.0, 7);
+    std::unique_ptr<Vehicle> truck = std::make_unique<Truck>(2, "Hino Dutro", 400.0, 1000.0);
+    std::unique_ptr<Vehicle> evLow = std::make_unique<ElectricCar>(3, "Tesla Model 3", 350.0, 75.0, 5.0);
+    std::unique_ptr<Vehicle> evFull = std::make_unique<ElectricCar>(4, "Tesla Model 3", 350.0, 75.0, 75.0);
+    struct { const char *name; Vehicle *v; } costs[] = {
+        {"rent_cost.car", car.get()}, {"rent_cost.truck", truck.get()},
+        {"rent_cost.ev_low_battery", evLow.get()}, {"rent_cost.ev_charged", evFull.get()}};
+    for (auto &c : costs) {
+        Vehicle *volatile v = c.v; // reload every call so the virtual call is not hoisted
+        double total = 0.0;
+        Stats st = measure(iters, batch, [&](std::size_t i) { total += v->rentCost(1 + static_cast<int>(i & 7)); });
+        sink = sink + static_cast<std::uint64_t>(total);
+        Report("micro", c.name).emit(st);
+    }
+    {
+        Truck *volatile t = static_cast<Truck*>(truck.get());
+        double total = 0.0;
+        Stats st = measure(iters, batch, [&](std::size_t i) {
+            total += t->rentCost(1 + static_cast<int>(i & 7), static_cast<double>(i & 1023));
+        });
+        sink = sink + static_cast<std::uint64_t>(total);
+        Report("micro", "rent_cost.truck_load").emit(st);
+    }
+    {
+        Vehicle *volatile ev = evFull.get();
+        Stats st = measure(iters, batch, [&](std::size_t) { ev->start(); });
+        Report("micro", "ev_start.ok").emit(st);
+        Vehicle *volatile low = evLow.get();
+        Stats thrown = measure(iters / 100, 16, [&](std::size_t) {
+            try {
+                low->start();
+            } catch (const BatteryLowException &) {
+                sink = sink + 1;
+            }
+        });
+        Report("micro", "ev_start.battery_low_throw").emit(thrown);
+    }
+
+    // log formatting and the caller-side cost of both Logger modes
+    {
+        double cost = 700.0;
+        Stats st = measure(iters / 10, 64, [&](std::size_t i) {
+            std::ostringstream oss;
+            oss << "Rented vehicle id=" << i << " to member=memberB for 2 days; cost=" << cost;
+            sink = sink + oss.str().size();
+        });
+        Report("micro", "log.format_rent_line").emit(st);
+    }
+    {
+        Logger sync("bench_log.txt");
+        Stats st = measure(iters / 10, 64, [&](std::size_t i) { sync.log("Rented vehicle id=" + std::to_string(i)); });
+        Report("micro", "log.sync").emit(st);
+    }
+    {
+        LoggerOptions lopts = LoggerOptions::asyncMode();
+        lopts.queueCapacity = 1 << 16;
+        Logger async("bench_log.txt", lopts);
+        Stats st = measure(iters / 10, 64, [&](std::size_t i) { async.log("Rented vehicle id=" + std::to_string(i)); });
+        Report("micro", "log.async_enqueue").emit(st);
+    }
+}
+
+// ----- macro: mixed rent/return/charge workload by fleet size ---------------
+void macro(const Options &opts) {
+    Logger quiet("", LoggerOptions::disabled());
+    std::vector<std::string> members;
+    for (int i = 0; i < 1000; ++i) members.push_back("member" + std::to_string(i));
+
+    for (std::size_t fleetSize = 1000; fleetSize <= opts.maxFleet; fleetSize *= 10) {
+        SimulatedClock clock;
+        RentalManager manager(quiet, quietManager(&clock));
+        const int n = static_cast<int>(fleetSize);
+        for (int id = 1; id <= n; ++id) addMixed(manager, id);
+
+        struct Out { int id; int member; };
+        std::vector<Out> out;
+        Lcg rng(5);
+        // 60% rent of a random vehicle, 30% return of a random active rental, 10% EV charge
+        Stats st = measure(opts.macroOps, 1, [&](std::size_t) {
+            std::uint32_t r = rng.next() % 10;
+            if (r < 6 || out.empty()) {
+                int id = static_cast<int>(rng.next() % fleetSize) + 1;
+                int member = static_cast<int>(rng.next() % members.size());
+                double load = id % 10 == 5 || id % 10 == 6 ? static_cast<double>(rng.next() % 1200) : 0.0;
+                if (manager.tryRentVehicle(members[member], id, 1 + static_cast<int>(rng.next() % 5), load)) {
+                    out.push_back(Out{id, member});
+                }
+            } else if (r < 9) {
+                std::size_t k = rng.next() % out.size();
+                manager.tryReturnVehicle(members[out[k].member], out[k].id, 3, false);
+                out[k] = out.back();
+                out.pop_back();
+            } else {
+                int id = static_cast<int>(rng.next() % fleetSize) + 1;
+                id = id - id % 10 + 7 + static_cast<int>(rng.next() % 3);
+                if (id > n) id = 7;
+                manager.tryChargeBattery(id, 5.0);
+            }
+        });
+        Report("macro", "mixed_rent_return_charge").param("fleet", fleetSize).emit(st);
+    }
+}
+
+// ----- compare: before/after pairs for individual optimizations --------------
+
+// findVehicle latency by fleet size: indexed lookup vs the old linear scan
+void lookup() {
+    Logger quiet("", LoggerOptions::disabled());
+    for (std::size_t fleetSize : {1000u, 10000u, 100000u, 400000u}) {
+        RentalManager manager(quiet, quietManager());
+        std::vector<std::unique_ptr<Vehicle>> linear;
+        for (std::size_t i = 0; i < fleetSize; ++i) {
+            Car c(static_cast<int>(i + 1), "Bench Car", 100.0, 4);
+            manager.addVehicle(c);
+            linear.push_back(c.clone());
+        }
+
+        Lcg rng(42);
+        Stats indexed = measure(1000000, 256, [&](std::size_t) {
+            int id = static_cast<int>(rng.next() % fleetSize) + 1;
+            sink = sink + (manager.getVehicle(id) != nullptr);
+        });
+        Report("compare", "lookup.index").param("fleet", fleetSize).emit(indexed);
+
+        // the linear scan is O(n), so probe fewer times at large sizes
+        std::size_t linearIters = std::max<std::size_t>(100, 20000000 / fleetSize);
+        rng = Lcg(42);
+        Stats scanned = measure(linearIters, 1, [&](std::size_t) {
+            int id = static_cast<int>(rng.next() % fleetSize) + 1;
+            auto it = std::find_if(linear.begin(), linear.end(),
+                                   [id](const std::unique_ptr<Vehicle> &p) { return p->getId() == id; });
+            sink = sink + (it != linear.end());
+        });
+        Report("compare", "lookup.linear_scan").param("fleet", fleetSize).emit(scanned);
+    }
+}
+
+// caller-side cost of Logger::log, one sample per call so the sync tail
+// (format + flush inline) is visible next to the async enqueue
+void logger() {
+    const std::size_t iters = 200000;
+    {
+        Logger sync("bench_log.txt");
+        Stats st = measure(iters, 1, [&](std::size_t i) { sync.log("Rented vehicle id=" + std::to_string(i)); });
+        Report("compare", "logger.sync").emit(st);
+    }
+    {
+        LoggerOptions opts = LoggerOptions::asyncMode();
+        opts.queueCapacity = 1 << 16;
+        Logger async("bench_log.txt", opts);
+        Stats st = measure(iters, 1, [&](std::size_t i) { async.log("Rented vehicle id=" + std::to_string(i)); });
+        Report("compare", "logger.async").emit(st);
+    }
+}
+
+// rent+return throughput as threads are added: one global mutex around a
+// single-threaded manager vs the sharded concurrent mode
+void concurrency() {
+    const int vehiclesPerThread = 1024;
+    const int opsPerThread = 100000;
+    unsigned hw = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<unsigned> threadCounts{1, 2, 4, 8};
+    if (hw > 8) threadCounts.push_back(hw);
+
+    LoggerOptions lopts = LoggerOptions::asyncMode();
+    lopts.queueCapacity = 1 << 16;
+    lopts.overflow = OverflowPolicy::Drop; // keep the writer thread out of the measurement
+    Logger logger("bench_log.txt", lopts);
+
+    for (unsigned threads : threadCounts) {
+        for (int sharded = 0; sharded < 2; ++sharded) {
+            ManagerOptions mopts = sharded ? ManagerOptions::concurrentMode(256) : ManagerOptions();
+            mopts.echoToStdout = false;
+            RentalManager manager(logger, mopts);
+            int fleetSize = vehiclesPerThread * static_cast<int>(threads);
+            for (int id = 1; id <= fleetSize; ++id) manager.addVehicle(Car(id, "Bench Car", 100.0, 4));
+
+            std::mutex global;
+            auto worker = [&](unsigned t) {
+                Lcg rng(t + 1);
+                const int base = static_cast<int>(t) * vehiclesPerThread + 1;
+                for (int i = 0; i < opsPerThread; i += 2) {
+                    // each thread works on its own vehicles so rents never collide
+                    int id = base + static_cast<int>(rng.next() % vehiclesPerThread);
+                    if (sharded) {
+                        manager.rentVehicle("bench", id, 1);
+                        manager.returnVehicle("bench", id, 1, false);
+                    } else {
+                        std::lock_guard<std::mutex> lk(global);
+                        manager.rentVehicle("bench", id, 1);
+                        manager.returnVehicle("bench", id, 1, false);
+                    }
+                }
+            };
+
+            auto start = BenchClock::now();
+            std::vector<std::thread> pool;
+            for (unsigned t = 0; t < threads; ++t) pool.emplace_back(worker, t);
+            for (auto &th : pool) th.join();
+            Stats st;
+            st.ops = static_cast<std::size_t>(opsPerThread) * threads;
+            st.seconds = std::chrono::duration<double>(BenchClock::now() - start).count();
+            Report("compare", sharded ? "concurrency.sharded" : "concurrency.global_mutex")
+                .param("threads", threads).emit(st, false);
+        }
+    }
+}
+
+// rent+return throughput with many producers: a global mutex, the sharded
+// concurrent mode, and the single-worker RentalActor fed by an MPSC queue.
+// Actor producers do not wait per command, only on every 256th return.
+void actor() {
+    const int vehiclesPerThread = 256;
+    const int opsPerThread = 20000;
+    const int window = 256; // rent/return pairs a producer has in flight at most
+    Logger quiet("", LoggerOptions::disabled());
+
+    for (unsigned threads : {8u, 32u, 64u}) {
+        for (int variant = 0; variant < 3; ++variant) {
+            RentalManager manager(quiet, variant == 1 ? [] {
+                ManagerOptions o = ManagerOptions::concurrentMode(256);
+                o.echoToStdout = false;
+                return o;
+            }() : quietManager());
+            const int fleetSize = vehiclesPerThread * static_cast<int>(threads);
+            for (int id = 1; id <= fleetSize; ++id) manager.addVehicle(Car(id, "Bench Car", 100.0, 4));
+            std::optional<RentalActor> front;
+            if (variant == 2) front.emplace(manager);
+
+            std::mutex global;
+            auto worker = [&](unsigned t) {
+                Lcg rng(t + 1);
+                const int base = static_cast<int>(t) * vehiclesPerThread + 1;
+                for (int i = 0; i < opsPerThread; i += 2) {
+                    int id = base + static_cast<int>(rng.next() % vehiclesPerThread);
+                    if (variant == 0) {
+                        std::lock_guard<std::mutex> lk(global);
+                        manager.tryRentVehicle("bench", id, 1);
+                        manager.tryReturnVehicle("bench", id, 1, false);
+                    } else if (variant == 1) {
+                        manager.tryRentVehicle("bench", id, 1);
+                        manager.tryReturnVehicle("bench", id, 1, false);
+                    } else {
+                        front->rentVehicle("bench", id, 1, 0.0, RentalActor::Completion());
+                        if ((i / 2) % window == window - 1) {
+                            front->returnVehicle("bench", id, 1, false).wait();
+                        } else {
+                            front->returnVehicle("bench", id, 1, false, RentalActor::Completion());
+                        }
+                    }
+                }
+            };
+
+            auto start = BenchClock::now();
+            std::vector<std::thread> pool;
+            for (unsigned t = 0; t < threads; ++t) pool.emplace_back(worker, t);
+            for (auto &th : pool) th.join();
+            front.reset(); // drains what is still queued
+            Stats st;
+            st.ops = static_cast<std::size_t>(opsPerThread) * threads;
+            st.seconds = std::chrono::duration<double>(BenchClock::now() - start).count();
+            static const char *names[] = {"actor.global_mutex", "actor.sharded", "actor.mpsc_worker"};
+            Report report("compare", names[variant]);
+            report.param("producers", threads);
+            if (variant == 2) report.param("window", window);
+            report.emit(st, false);
+        }
+    }
+}
+
+// pricing a mixed fleet: the old dynamic_cast probe vs kind-tag static dispatch
+void dispatch() {
+    std::vector<std::unique_ptr<Vehicle>> fleet;
+    for (int i = 0; i < 30000; ++i) {
+        switch (i % 3) {
+        case 0: fleet.push_back(std::make_unique<Car>(i, "Car", 200.0, 7)); break;
+        case 1: fleet.push_back(std::make_unique<Truck>(i, "Truck", 400.0, 1000.0)); break;
+        default: fleet.push_back(std::make_unique<ElectricCar>(i, "EV", 350.0, 75.0, 10.0)); break;
+        }
+    }
+    Lcg rng(7);
+    std::vector<std::uint32_t> order(1000000);
+    for (auto &o : order) o = rng.next() % fleet.size();
+
+    double total = 0.0;
+    Stats rtti = measure(order.size(), 256, [&](std::size_t i) {
+        Vehicle *v = fleet[order[i]].get();
+        if (Truck *t = dynamic_cast<Truck*>(v)) total += t->rentCost(3, 500.0);
+        else total += v->rentCost(3);
+    });
+    Stats tag = measure(order.size(), 256, [&](std::size_t i) {
+        total += rentalCost(*fleet[order[i]], 3, 500.0);
+    });
+    sink = sink + static_cast<std::uint64_t>(total);
+    Report("compare", "dispatch.dynamic_cast").emit(rtti);
+    Report("compare", "dispatch.kind_tag").emit(tag);
+}
+
+// "how many free EVs have >= 20% charge": per-object walk vs column scan
+void scan() {
+    const int fleetSize = 1000000;
+    Logger quiet("", LoggerOptions::disabled());
+    RentalManager manager(quiet, quietManager());
+    std::vector<std::unique_ptr<Vehicle>> objects;
+    Lcg rng(3);
+    for (int id = 1; id <= fleetSize; ++id) {
+        std::unique_ptr<Vehicle> v;
+        switch (id % 3) {
+        case 0: v = std::make_unique<Car>(id, "Toyota Avanza", 200.0, 7); break;
+        case 1: v = std::make_unique<Truck>(id, "Hino Dutro", 400.0, 1000.0); break;
+        default: v = std::make_unique<ElectricCar>(id, "Tesla Model 3", 350.0, 75.0, rng.next() % 76); break;
+        }
+        manager.addVehicle(*v);
+        objects.push_back(std::move(v));
+    }
+
+    const std::size_t reps = 20;
+    Stats walked = measure(reps, 1, [&](std::size_t) {
+        std::size_t n = 0;
+        for (const auto &v : objects) {
+            if (v->getKind() != VehicleKind::Electric || v->getIsRented()) continue;
+            const auto &ev = static_cast<const ElectricCar&>(*v);
+            n += ev.getCurrentCharge() >= 0.2 * ev.getBatteryCapacity();
+        }
+        sink = sink + n;
+    });
+    Stats columns = measure(reps, 1, [&](std::size_t) { sink = sink + manager.countFreeEvsWithCharge(0.2); });
+    Report("compare", "scan.objects").param("fleet", fleetSize).emit(walked);
+    Report("compare", "scan.columns").param("fleet", fleetSize).emit(columns);
+}
+
+// bursts of bookings: one rentVehicle/returnVehicle call per booking vs rentVehicles/returnVehicles
+void batch() {
+    const int fleetSize = 100000;
+    const std::size_t burst = 5000;
+    const int rounds = 10;
+    Logger logger("bench_log.txt");
+    for (int batched = 0; batched < 2; ++batched) {
+        RentalManager manager(logger, quietManager());
+        for (int id = 1; id <= fleetSize; ++id) manager.addVehicle(Car(id, "Bench Car", 100.0, 4));
+
+        std::vector<RentRequest> rents;
+        std::vector<ReturnRequest> returns;
+        for (std::size_t i = 0; i < burst; ++i) {
+            int id = static_cast<int>(i * 17 % fleetSize) + 1;
+            rents.push_back(RentRequest{"member" + std::to_string(i), id, 2});
+            returns.push_back(ReturnRequest{"member" + std::to_string(i), id, 2});
+        }
+
+        // one sample per round of burst rents + burst returns
+        Stats st = measure(rounds, 1, [&](std::size_t) {
+            if (batched) {
+                manager.rentVehicles(rents);
+                manager.returnVehicles(returns);
+            } else {
+                for (const auto &q : rents) manager.rentVehicle(q.memberId, q.vehicleId, q.days, q.loadKg);
+                for (const auto &q : returns) manager.returnVehicle(q.memberId, q.vehicleId, q.actualDays, q.damaged);
+            }
+        });
+        st.ops = 2 * burst * rounds;
+        for (double &s : st.samples) s /= 2.0 * burst;
+        Report("compare", batched ? "batch.batched" : "batch.per_call").param("burst", burst).emit(st);
+    }
+}
+
+// cost of a rejected rent ("already rented"): throw + catch vs tryRentVehicle status
+void rejects() {
+    const int fleetSize = 10000;
+    Logger logger("bench_log.txt");
+    RentalManager manager(logger, quietManager());
+    for (int id = 1; id <= fleetSize; ++id) manager.addVehicle(Car(id, "Bench Car", 100.0, 4));
+    // 30% of the fleet is out, every attempt below targets one of those
+    const int rentedCount = fleetSize * 3 / 10;
+    for (int id = 1; id <= rentedCount; ++id) manager.tryRentVehicle("holder", id, 5);
+
+    const std::size_t iters = 200000;
+    Lcg rng(11);
+    Stats thrown = measure(iters, 16, [&](std::size_t) {
+        int id = static_cast<int>(rng.next() % rentedCount) + 1;
+        try {
+            manager.rentVehicle("member", id, 1);
+        } catch (const VehicleNotAvailable &) {
+            sink = sink + 1;
+        }
+    });
+    rng = Lcg(11);
+    Stats tried = measure(iters, 256, [&](std::size_t) {
+        int id = static_cast<int>(rng.next() % rentedCount) + 1;
+        sink = sink + (manager.tryRentVehicle("member", id, 1).status == RentalStatus::NotAvailable);
+    });
+    Report("compare", "rejects.throwing").emit(thrown);
+    Report("compare", "rejects.try").emit(tried);
+}
+
+// restart cost: rebuilding through addVehicle vs loading a binary snapshot
+void snapshot(const Options &opts) {
+    Logger quiet("", LoggerOptions::disabled());
+    const std::size_t fleetSize = std::min<std::size_t>(opts.maxFleet, 5000000);
+    const int n = static_cast<int>(fleetSize);
+    const std::string path = "bench_snapshot.bin";
+    auto timed = [](auto &&body) {
+        Stats st;
+        auto start = BenchClock::now();
+        st.ops = body();
+        st.seconds = std::chrono::duration<double>(BenchClock::now() - start).count();
+        return st;
+    };
+
+    SimulatedClock clock;
+    {
+        RentalManager manager(quiet, quietManager(&clock));
+        Stats rebuild = timed([&] {
+            for (int id = 1; id <= n; ++id) addMixed(manager, id);
+            return fleetSize;
+        });
+        for (int id = 1; id <= n; id += 10) manager.tryRentVehicle("member" + std::to_string(id % 1000), id, 3);
+        Stats save = timed([&] { return manager.saveSnapshot(path).vehicles; });
+        Report("compare", "snapshot.rebuild_add_vehicle").param("fleet", fleetSize).param("seconds", rebuild.seconds).emit(rebuild, false);
+        Report("compare", "snapshot.save").param("fleet", fleetSize).param("seconds", save.seconds).emit(save, false);
+    }
+    for (bool concurrent : {false, true}) {
+        ManagerOptions mo = quietManager(&clock);
+        mo.concurrent = concurrent;
+        RentalManager restored(quiet, mo);
+        Stats load = timed([&] { return restored.loadSnapshot(path).vehicles; });
+        Report("compare", concurrent ? "snapshot.load_concurrent" : "snapshot.load")
+            .param("fleet", fleetSize).param("seconds", load.seconds).emit(load, false);
+    }
+    std::remove(path.c_str());
+}
+
+// onboarding a fleet file: reading the CSV line by line into vehicles handed
+// to addVehicle vs importFleet on the same CSV and on its columnar form
+void importFleet(const Options &opts) {
+    Logger quiet("", LoggerOptions::disabled());
+    const std::size_t fleetSize = std::min<std::size_t>(opts.maxFleet, 2000000);
+    const std::string csvPath = "bench_fleet.csv";
+    const std::string columnsPath = "bench_fleet.cols";
+    {
+        std::string csv = "kind,id,model,daily_rate,spec,charge_kwh\n";
+        FleetFileWriter columns;
+        for (std::size_t i = 1; i <= fleetSize; ++i) {
+            const std::string id = std::to_string(i);
+            const std::size_t k = i % 10;
+            if (k < 5) {
+                csv += "car," + id + ",Toyota Avanza,200,7,\n";
+                columns.add(VehicleKind::Car, static_cast<int>(i), "Toyota Avanza", 200.0, 7.0);
+            } else if (k < 7) {
+                csv += "truck," + id + ",Hino Dutro,400,1000,\n";
+                columns.add(VehicleKind::Truck, static_cast<int>(i), "Hino Dutro", 400.0, 1000.0);
+            } else {
+                csv += "electric," + id + ",Tesla Model 3,350,75,40\n";
+                columns.add(VehicleKind::Electric, static_cast<int>(i), "Tesla Model 3", 350.0, 75.0, 40.0);
+            }
+        }
+        std::ofstream(csvPath, std::ios::binary) << csv;
+        columns.save(columnsPath);
+    }
+    auto timed = [](auto &&body) {
+        Stats st;
+        auto start = BenchClock::now();
+        st.ops = body();
+        st.seconds = std::chrono::duration<double>(BenchClock::now() - start).count();
+        return st;
+    };
+
+    SimulatedClock clock;
+    {
+        RentalManager manager(quiet, quietManager(&clock));
+        Stats st = timed([&] {
+            std::ifstream in(csvPath);
+            std::string line, kind, id, model, rate, spec, charge;
+            std::getline(in, line); // header
+            std::size_t n = 0;
+            while (std::getline(in, line)) {
+                std::stringstream fields(line);
+                std::getline(fields, kind, ',');
+                std::getline(fields, id, ',');
+                std::getline(fields, model, ',');
+                std::getline(fields, rate, ',');
+                std::getline(fields, spec, ',');
+                std::getline(fields, charge, ',');
+                if (kind == "car") manager.addVehicle(Car(std::stoi(id), model, std::stod(rate), std::stoi(spec)));
+                else if (kind == "truck") manager.addVehicle(Truck(std::stoi(id), model, std::stod(rate), std::stod(spec)));
+                else manager.addVehicle(ElectricCar(std::stoi(id), model, std::stod(rate), std::stod(spec), std::stod(charge)));
+                ++n;
+            }
+            return n;
+        });
+        Report("compare", "import_fleet.getline_add_vehicle").param("fleet", fleetSize).param("seconds", st.seconds).emit(st, false);
+    }
+    for (bool concurrent : {false, true}) {
+        for (FleetFileFormat format : {FleetFileFormat::Csv, FleetFileFormat::Columns}) {
+            ManagerOptions mo = quietManager(&clock);
+            mo.concurrent = concurrent;
+            RentalManager manager(quiet, mo);
+            const std::string &path = format == FleetFileFormat::Csv ? csvPath : columnsPath;
+            Stats st = timed([&] { return manager.importFleet(path, format).imported; });
+            std::string name = format == FleetFileFormat::Csv ? "import_fleet.csv" : "import_fleet.columns";
+            Report("compare", concurrent ? name + "_concurrent" : name)
+                .param("fleet", fleetSize).param("seconds", st.seconds).emit(st, false);
+        }
+    }
+    std::remove(csvPath.c_str());
+    std::remove(columnsPath.c_str());
+}
+
+// durability cost of rent + return: no journal vs one fsync per op vs group commit
+void journal() {
+    Logger quiet("", LoggerOptions::disabled());
+    const int fleetSize = 10000;
+    const int cyclesPerThread = 300;
+    const std::string path = "bench_journal.wal";
+    for (int threads : {1, 8}) {
+        for (int mode = 0; mode < 3; ++mode) {
+            static const char *names[] = {"journal.none", "journal.sync_each", "journal.group_commit"};
+            std::remove(path.c_str());
+            std::unique_ptr<Journal> wal;
+            if (mode == 1) wal = std::make_unique<Journal>(path, JournalOptions::syncEach());
+            if (mode == 2) wal = std::make_unique<Journal>(path);
+            ManagerOptions mo = quietManager();
+            mo.concurrent = true;
+            mo.journal = wal.get();
+            RentalManager manager(quiet, mo);
+            for (int id = 1; id <= fleetSize; ++id) manager.addVehicle(Car(id, "Bench Car", 100.0, 4));
+
+            auto start = BenchClock::now();
+            std::vector<std::thread> pool;
+            for (int t = 0; t < threads; ++t) {
+                pool.emplace_back([&, t] {
+                    const std::string member = "member" + std::to_string(t);
+                    for (int i = 0; i < cyclesPerThread; ++i) {
+                        int id = 1 + (t * cyclesPerThread + i) % fleetSize;
+                        manager.tryRentVehicle(member, id, 1);
+                        manager.tryReturnVehicle(member, id, 1, false);
+                    }
+                });
+            }
+            for (std::thread &th : pool) th.join();
+            Stats st;
+            st.ops = static_cast<std::size_t>(threads) * cyclesPerThread * 2;
+            st.seconds = std::chrono::duration<double>(BenchClock::now() - start).count();
+            Report("compare", names[mode]).param("threads", threads).emit(st, false);
+        }
+    }
+    std::remove(path.c_str());
+}
+
+// "any truck for 800 kg": scanning the fleet with getIsRented vs tryRentAny
+void rentAny() {
+    Logger quiet("", LoggerOptions::disabled());
+    const int fleetSize = 100000;
+    SimulatedClock clock;
+    RentalManager manager(quiet, quietManager(&clock));
+    for (int id = 1; id <= fleetSize; ++id) {
+        if (id % 2) manager.addVehicle(Car(id, "Bench Car", 100.0, 2 + id % 7));
+        else manager.addVehicle(Truck(id, "Bench Truck", 300.0, 500.0 + 100.0 * (id % 10)));
+    }
+    // everything but the last few trucks that fit is out, so a scan has to walk far
+    for (int id = 2; id <= fleetSize - 1000; id += 2) manager.tryRentVehicle("holder", id, 30);
+    const double load = 800.0;
+    const std::size_t iters = 2000;
+
+    Stats scanned = measure(iters, 1, [&](std::size_t) {
+        for (int id = 1; id <= fleetSize; ++id) {
+            const Vehicle *v = manager.getVehicle(id);
+            if (v->getKind() == VehicleKind::Truck && !v->getIsRented() &&
+                static_cast<const Truck*>(v)->getMaxLoadKg() >= load) {
+                manager.tryRentVehicle("member", id, 1, load);
+                manager.tryReturnVehicle("member", id, 1, false);
+                break;
+            }
+        }
+    });
+    RentConstraints want;
+    want.loadKg = load;
+    Stats indexed = measure(iters, 1, [&](std::size_t) {
+        RentalOutcome o = manager.tryRentAny("member", VehicleKind::Truck, 1, want);
+        manager.tryReturnVehicle("member", o.vehicleId, 1, false);
+    });
+    Report("compare", "rent_any.scan").param("fleet", fleetSize).emit(scanned);
+    Report("compare", "rent_any.indexed").param("fleet", fleetSize).emit(indexed);
+}
+
+// quote pricing: rentalCost per Vehicle object vs priceBulk over columns,
+// checked bit for bit
+void bulkPricing() {
+    const std::size_t quotes = 65536;
+    std::vector<std::unique_ptr<Vehicle>> fleet;
+    Lcg rng(23);
+    for (int id = 0; id < 4096; ++id) {
+        double rate = 50.0 + rng.next() % 50000 / 100.0;
+        switch (id % 3) {
+        case 0: fleet.push_back(std::make_unique<Car>(id, "Quote Car", rate, 4)); break;
+        case 1: fleet.push_back(std::make_unique<Truck>(id, "Quote Truck", rate, 1000.0)); break;
+        default: fleet.push_back(std::make_unique<ElectricCar>(id, "Quote EV", rate, 75.0, rng.next() % 7500 / 100.0)); break;
+        }
+    }
+    std::vector<const Vehicle*> vehicle(quotes);
+    std::vector<VehicleKind> kind(quotes);
+    std::vector<double> rate(quotes), load(quotes), capacity(quotes, 0.0), charge(quotes, 0.0);
+    std::vector<std::int32_t> days(quotes);
+    for (std::size_t i = 0; i < quotes; ++i) {
+        const Vehicle *v = fleet[rng.next() % fleet.size()].get();
+        vehicle[i] = v;
+        kind[i] = v->getKind();
+        rate[i] = v->getDailyRate();
+        days[i] = 1 + static_cast<std::int32_t>(rng.next() % 30);
+        load[i] = rng.next() % 100000 / 100.0;
+        if (kind[i] == VehicleKind::Electric) {
+            capacity[i] = static_cast<const ElectricCar*>(v)->getBatteryCapacity();
+            charge[i] = static_cast<const ElectricCar*>(v)->getCurrentCharge();
+        }
+    }
+    PricingColumns in;
+    in.count = quotes;
+    in.kind = kind.data();
+    in.dailyRate = rate.data();
+    in.days = days.data();
+    in.loadKg = load.data();
+    in.batteryCapacityKwh = capacity.data();
+    in.chargeKwh = charge.data();
+
+    std::vector<double> scalarOut(quotes), bulkOut(quotes);
+    const std::size_t rounds = 100;
+    Stats scalar = measure(rounds, 1, [&](std::size_t) {
+        for (std::size_t i = 0; i < quotes; ++i) scalarOut[i] = rentalCost(*vehicle[i], days[i], load[i]);
+        sink = sink + static_cast<std::uint64_t>(scalarOut[quotes / 2]);
+    });
+    Stats bulk = measure(rounds, 1, [&](std::size_t) {
+        priceBulk(in, bulkOut.data());
+        sink = sink + static_cast<std::uint64_t>(bulkOut[quotes / 2]);
+    });
+    std::size_t mismatches = 0;
+    for (std::size_t i = 0; i < quotes; ++i) {
+        mismatches += std::memcmp(&scalarOut[i], &bulkOut[i], sizeof(double)) != 0;
+    }
+    // per-quote throughput: each op above priced the whole batch
+    scalar.ops *= quotes;
+    bulk.ops *= quotes;
+#if defined(__AVX2__)
+    const std::string kernel = "avx2";
+#elif defined(__SSE2__)
+    const std::string kernel = "sse2";
+#else
+    const std::string kernel = "scalar";
+#endif
+    Report("compare", "bulk_pricing.scalar").param("quotes", quotes).emit(scalar, false);
+    Report("compare", "bulk_pricing.simd").param("quotes", quotes).param("kernel", kernel)
+        .param("mismatches", mismatches).emit(bulk, false);
+}
+
+// fixed constexpr tariff vs one read from a TariffTable (same rates): object
+// pricing with rentalCost, and full rent+return cycles through the manager
+template <class Tariff>
+void tariffVariant(const char *name, Tariff pricing) {
+    const int fleetSize = 4096;
+    std::vector<std::unique_ptr<Vehicle>> fleet;
+    Lcg rng(29);
+    for (int id = 1; id <= fleetSize; ++id) {
+        switch (id % 3) {
+        case 0: fleet.push_back(std::make_unique<Car>(id, "Tariff Car", 120.0, 4)); break;
+        case 1: fleet.push_back(std::make_unique<Truck>(id, "Tariff Truck", 300.0, 1000.0)); break;
+        default: fleet.push_back(std::make_unique<ElectricCar>(id, "Tariff EV", 250.0, 75.0, 10.0 + rng.next() % 6500 / 100.0)); break;
+        }
+    }
+    std::vector<std::uint32_t> order(1 << 20);
+    for (auto &o : order) o = rng.next() % fleet.size();
+    double total = 0.0;
+    Stats price = measure(order.size(), 256, [&](std::size_t i) {
+        total += rentalCost(*fleet[order[i]], 3, 500.0, pricing.rates());
+    });
+    sink = sink + static_cast<std::uint64_t>(total);
+    Report("compare", std::string("tariff.") + name + ".price").emit(price);
+
+    Logger quiet("", LoggerOptions::disabled());
+    SimulatedClock clock(std::chrono::system_clock::now());
+    BasicRentalManager<Tariff> manager(quiet, quietManager(&clock), pricing);
+    for (const auto &v : fleet) manager.addVehicle(*v);
+    Stats cycle = measure(200000, 64, [&](std::size_t i) {
+        int id = 1 + static_cast<int>(order[i & (order.size() - 1)]);
+        manager.tryRentVehicle("bench", id, 2, 400.0);
+        total += manager.tryReturnVehicle("bench", id, 3, false).cost;
+    });
+    sink = sink + static_cast<std::uint64_t>(total);
+    Report("compare", std::string("tariff.") + name + ".rent_return").emit(cycle);
+}
+
+void tariff() {
+    tariffVariant("constexpr", StandardTariff());
+    TariffTable table;
+    tariffVariant("runtime", RuntimeTariff(table));
+}
+
+// polling fleet utilization and revenue: a scan over every shard's columns
+// (what a dashboard had to do before), metricsSnapshot (locks each shard) and
+// fleetTotals (the published per-shard copies, no locks)
+void totals() {
+    Logger quiet("", LoggerOptions::disabled());
+    const int fleetSize = 200000;
+    ManagerOptions opts = ManagerOptions::concurrentMode();
+    opts.echoToStdout = false;
+    RentalManager manager(quiet, opts);
+    Lcg rng(31);
+    for (int id = 1; id <= fleetSize; ++id) {
+        switch (id % 3) {
+        case 0: manager.addVehicle(Car(id, "Totals Car", 120.0, 4)); break;
+        case 1: manager.addVehicle(Truck(id, "Totals Truck", 300.0, 1000.0)); break;
+        default: manager.addVehicle(ElectricCar(id, "Totals EV", 250.0, 75.0, 60.0)); break;
+        }
+    }
+    for (int id = 1; id <= fleetSize; ++id) {
+        if (rng.next() % 2) continue;
+        manager.tryRentVehicle("bench", id, 3, 200.0);
+        if (rng.next() % 4 == 0) manager.tryReturnVehicle("bench", id, 4, rng.next() % 2 == 0);
+    }
+
+    Stats scan = measure(200, 1, [&](std::size_t) {
+        std::uint64_t rented = 0;
+        manager.scanColumns([&](const FleetColumns &c) {
+            for (std::uint8_t r : c.rented) rented += r;
+        });
+        sink = sink + rented;
+    });
+    Stats snapshot = measure(20000, 16, [&](std::size_t) {
+        sink = sink + manager.metricsSnapshot().rented[0];
+    });
+    Stats published = measure(200000, 64, [&](std::size_t) {
+        sink = sink + manager.fleetTotals().rentals;
+    });
+    const FleetTotals t = manager.fleetTotals();
+    Report("compare", "totals.fleet_scan").param("vehicles", fleetSize).emit(scan);
+    Report("compare", "totals.metrics_snapshot").param("vehicles", fleetSize).emit(snapshot);
+    Report("compare", "totals.fleet_totals").param("vehicles", fleetSize)
+        .param("rentals", t.rentals).param("revenue", t.revenue()).emit(published);
+}
+
+// stream sink that only counts bytes, so list_fleet times formatting, not a terminal
+class CountingBuf : public std::streambuf {
+public:
+    std::size_t bytes = 0;
+protected:
+    int_type overflow(int_type c) override {
+        if (!traits_type::eq_int_type(c, traits_type::eof())) ++bytes;
+        return traits_type::not_eof(c);
+    }
+    std::streamsize xsputn(const char *, std::streamsize n) override {
+        bytes += static_cast<std::size_t>(n);
+        return n;
+    }
+};
+
+// the ostream-based line format listFleet used before appendInfo: one stream
+// for Vehicle::info() and another for the derived part
+std::string streamInfo(const Vehicle &v) {
+    std::ostringstream base;
+    base << "[" << v.getId() << "] " << v.getModel() << " (rate " << v.getDailyRate() << ")";
+    std::ostringstream oss;
+    oss << base.str();
+    switch (v.getKind()) {
+    case VehicleKind::Car: oss << " Car cap=" << static_cast<const Car&>(v).getPassengerCapacity(); break;
+    case VehicleKind::Truck: oss << " Truck maxLoadKg=" << static_cast<const Truck&>(v).getMaxLoadKg(); break;
+    case VehicleKind::Electric: {
+        const auto &ev = static_cast<const ElectricCar&>(v);
+        oss << " Electric battery=" << ev.getCurrentCharge() << "/" << ev.getBatteryCapacity();
+        break;
+    }
+    default: break;
+    }
+    return oss.str();
+}
+
+// fleet dump: per-line ostringstreams vs listFleet's appendInfo chunks, with
+// the two outputs compared byte for byte
+void listFleet() {
+    Logger quiet("", LoggerOptions::disabled());
+    const int fleetSize = 200000;
+    RentalManager manager(quiet, quietManager());
+    std::vector<std::unique_ptr<Vehicle>> fleet;
+    Lcg rng(29);
+    // rates and loads span several magnitudes so %g switches between fixed and exponent forms
+    const double scale[] = {1e-5, 0.01, 1.0, 100.0, 1e6, 1e9};
+    for (int id = 1; id <= fleetSize; ++id) {
+        double rate = (rng.next() % 1000000) / 1000.0 * scale[rng.next() % 6];
+        switch (id % 3) {
+        case 0: fleet.push_back(std::make_unique<Car>(id, "List Car", rate, 2 + id % 7)); break;
+        case 1: fleet.push_back(std::make_unique<Truck>(id, "List Truck", rate, (rng.next() % 100000) / 7.0)); break;
+        default: fleet.push_back(std::make_unique<ElectricCar>(id, "List EV", rate, 75.0, (rng.next() % 7500) / 100.0)); break;
+        }
+        manager.addVehicle(*fleet.back());
+    }
+    for (int id = 1; id <= fleetSize; id += 4) {
+        if (manager.tryRentVehicle("holder", id, 30)) fleet[static_cast<std::size_t>(id - 1)]->setRented(true);
+    }
+
+    std::string legacy;
+    CountingBuf counter;
+    std::ostream nullOut(&counter);
+    const std::size_t rounds = 5;
+    Stats streamed = measure(rounds, 1, [&](std::size_t) {
+        std::ostringstream oss;
+        oss << "Fleet:\n";
+        for (const auto &v : fleet) oss << "  " << streamInfo(*v) << (v->getIsRented() ? " [RENTED]" : "") << "\n";
+        legacy = oss.str();
+        nullOut << legacy << std::flush;
+    });
+    Stats chunked = measure(rounds, 1, [&](std::size_t) { manager.listFleet(FleetFilter::All, nullOut); });
+    std::ostringstream current;
+    manager.listFleet(FleetFilter::All, current);
+    const bool identical = current.str() == legacy;
+    streamed.ops *= static_cast<std::size_t>(fleetSize);
+    chunked.ops *= static_cast<std::size_t>(fleetSize);
+    Report("compare", "list_fleet.ostream").param("fleet", fleetSize).emit(streamed, false);
+    Report("compare", "list_fleet.append_info").param("fleet", fleetSize)
+        .param("identical", identical ? "true" : "false").emit(chunked, false);
+}
+
+// conflict checks on vehicles with hundreds of bookings: a linear scan over
+// an unsorted booking list vs ReservationCalendar's binary search, then
+// tryReserve and "any truck >= X kg" through the manager
+void reservations() {
+    const int vehicles = 2000;
+    const int perVehicle = 300;
+    const std::int64_t hour = 3600LL * 1000000000LL;
+    Lcg rng(41);
+    std::vector<std::vector<std::pair<std::int64_t, std::int64_t>>> lists(vehicles);
+    std::vector<ReservationCalendar> calendars(vehicles);
+    for (int v = 0; v < vehicles; ++v) {
+        // back-to-back day bookings with random gaps, shuffled for the list
+        std::int64_t t = 0;
+        for (int i = 0; i < perVehicle; ++i) {
+            t += hour * (rng.next() % 24);
+            calendars[v].insert(ReservationCalendar::Entry{t, t + 24 * hour, 0.0, 0, static_cast<std::uint32_t>(i + 1)});
+            lists[v].emplace_back(t, t + 24 * hour);
+            t += 24 * hour;
+        }
+        std::shuffle(lists[v].begin(), lists[v].end(), std::mt19937(v));
+    }
+    const std::int64_t span = calendars[0].all().back().endNs;
+    std::vector<std::pair<int, std::int64_t>> probes(1 << 16);
+    for (auto &p : probes) p = {static_cast<int>(rng.next() % vehicles), static_cast<std::int64_t>(rng.next() % (span / hour)) * hour};
+    std::size_t free = 0;
+    Stats linear = measure(probes.size(), 256, [&](std::size_t i) {
+        const auto &[v, s] = probes[i];
+        bool ok = true;
+        for (const auto &b : lists[v]) ok &= !(b.first < s + 6 * hour && s < b.second);
+        free += ok;
+    });
+    Stats indexed = measure(probes.size(), 256, [&](std::size_t i) {
+        const auto &[v, s] = probes[i];
+        free += calendars[v].isFree(s, s + 6 * hour);
+    });
+    sink = sink + free;
+    Report("compare", "reservations.linear_scan").param("per_vehicle", perVehicle).emit(linear);
+    Report("compare", "reservations.calendar").param("per_vehicle", perVehicle).emit(indexed);
+
+    Logger quiet("", LoggerOptions::disabled());
+    SimulatedClock clock(std::chrono::system_clock::now());
+    RentalManager manager(quiet, quietManager(&clock));
+    for (int id = 1; id <= vehicles; ++id) manager.addVehicle(Truck(id, "Booked Truck", 300.0, 500.0 + id % 50 * 100.0));
+    const auto day0 = clock.now();
+    auto at = [&](std::int64_t ns) { return day0 + std::chrono::nanoseconds(ns); };
+    for (int id = 1; id <= vehicles; ++id) {
+        for (const auto &e : calendars[id - 1].all()) manager.tryReserve("bench", id, at(e.startNs + hour), at(e.endNs + hour));
+    }
+    Stats reserve = measure(probes.size(), 256, [&](std::size_t i) {
+        const auto &[v, s] = probes[i];
+        free += manager.tryReserve("bench", v + 1, at(s), at(s + hour)).ok();
+    });
+    Stats truck = measure(probes.size() / 16, 16, [&](std::size_t i) {
+        const std::int64_t s = probes[i].second;
+        free += manager.findFreeTruck(3000.0, at(s), at(s + 12 * hour)).has_value();
+    });
+    sink = sink + free;
+    Report("compare", "reservations.try_reserve").param("per_vehicle", perVehicle).emit(reserve);
+    Report("compare", "reservations.find_free_truck").param("trucks", vehicles).emit(truck);
+}
+
+// a queue of renters on a fully rented fleet, one return at a time: every
+// pending renter retrying tryRentVehicle after each return vs parked
+// rentWhenReady waiters handed the vehicle by the return itself
+void waitReady() {
+    const int vehicles = 256;
+    const int perVehicle = 8;
+    const std::size_t handoffs = static_cast<std::size_t>(vehicles) * perVehicle;
+    Logger quiet("", LoggerOptions::disabled());
+    for (bool parked : {false, true}) {
+        SimulatedClock clock(std::chrono::system_clock::now());
+        RentalManager manager(quiet, quietManager(&clock));
+        std::vector<std::string> holder(vehicles + 1, "owner");
+        for (int id = 1; id <= vehicles; ++id) {
+            manager.addVehicle(Car(id, "Queued Car", 100.0, 4));
+            manager.tryRentVehicle("owner", id, 1);
+        }
+        std::vector<std::pair<std::string, int>> pending;
+        for (int w = 0; w < perVehicle; ++w) {
+            for (int id = 1; id <= vehicles; ++id) pending.emplace_back("renter" + std::to_string(w) + "_" + std::to_string(id), id);
+        }
+        std::size_t attempts = 0;
+        if (parked) {
+            for (const auto &[member, id] : pending) {
+                manager.rentWhenReady(member, id, 1, 0.0, [&holder, member = member, id = id](const RentalOutcome &o) {
+                    if (o.ok()) holder[id] = member;
+                });
+                ++attempts;
+            }
+            pending.clear();
+        }
+        Stats st = measure(handoffs, 64, [&](std::size_t i) {
+            const int id = static_cast<int>(i % vehicles) + 1;
+            manager.tryReturnVehicle(holder[id], id, 1, false);
+            std::size_t kept = 0;
+            for (std::size_t k = 0; k < pending.size(); ++k) {
+                ++attempts;
+                if (manager.tryRentVehicle(pending[k].first, pending[k].second, 1).ok()) holder[pending[k].second] = pending[k].first;
+                else pending[kept++] = std::move(pending[k]);
+            }
+            pending.resize(kept);
+        });
+        sink = sink + attempts;
+        Report("compare", parked ? "wait_ready.parked" : "wait_ready.polling").param("waiting", handoffs)
+            .param("attempts_per_rent", static_cast<double>(attempts) / static_cast<double>(handoffs)).emit(st);
+    }
+}
+
+// caller-side cost of a logged rent+return cycle with formatted text lines vs
+// typed binary records (both through the async writer), then decoding the
+// binary log in full and filtered to one vehicle
+void binaryLog() {
+    const int fleetSize = 4096;
+    const std::size_t cycles = 200000;
+    const std::string textPath = "bench_log.txt";
+    const std::string binaryPath = "bench_log.bin";
+    for (LogFormat format : {LogFormat::Text, LogFormat::Binary}) {
+        const bool binary = format == LogFormat::Binary;
+        const std::string &path = binary ? binaryPath : textPath;
+        std::remove(path.c_str());
+        SimulatedClock clock(std::chrono::system_clock::now());
+        LoggerOptions lopts = LoggerOptions::asyncMode();
+        lopts.queueCapacity = 1 << 16;
+        lopts.format = format;
+        lopts.clock = &clock;
+        Logger logger(path, lopts);
+        RentalManager manager(logger, quietManager(&clock));
+        for (int id = 1; id <= fleetSize; ++id) manager.addVehicle(Car(id, "Log Car", 100.0, 4));
+        Stats st = measure(cycles, 64, [&](std::size_t i) {
+            int id = 1 + static_cast<int>(i % fleetSize);
+            manager.tryRentVehicle("member42", id, 2);
+            manager.tryReturnVehicle("member42", id, 3, false);
+        });
+        Report("compare", binary ? "binary_log.binary_rent_return" : "binary_log.text_rent_return").emit(st);
+    }
+
+    CountingBuf counter;
+    std::ostream nullOut(&counter);
+    LogDecodeStats decoded;
+    Stats full = measure(3, 1, [&](std::size_t) { decoded = decodeBinaryLog(binaryPath, nullOut); });
+    full.ops *= decoded.records;
+    Report("compare", "binary_log.decode_all").param("records", decoded.records).emit(full, false);
+    Stats filtered = measure(3, 1, [&](std::size_t) {
+        decoded = decodeBinaryLog(binaryPath, nullOut, LogFilter().vehicle(7));
+    });
+    filtered.ops = 3;
+    Report("compare", "binary_log.decode_one_vehicle").param("records", decoded.records).emit(filtered, false);
+    std::remove(textPath.c_str());
+    std::remove(binaryPath.c_str());
+}
+
+// overnight depot charging of a 100k-EV fleet: one chargeBattery per EV
+// (log disabled) vs one scheduleCharging window
+void charging() {
+    Logger quiet("", LoggerOptions::disabled());
+    const int fleetSize = 100000;
+    auto build = [&](RentalManager &m) {
+        Lcg rng(37);
+        for (int id = 1; id <= fleetSize; ++id) {
+            m.addVehicle(ElectricCar(id, "Depot EV", 150.0, 75.0, static_cast<double>(rng.next() % 7500) / 100.0));
+        }
+    };
+    const double budgetKwh = 0.4 * 75.0 * fleetSize;
+    ManagerOptions o = ManagerOptions::concurrentMode();
+    o.echoToStdout = false;
+    {
+        RentalManager manager(quiet, o);
+        build(manager);
+        Stats st = measure(1, 1, [&](std::size_t) {
+            double left = budgetKwh;
+            for (int id = 1; id <= fleetSize && left > 0; ++id) {
+                const auto *ev = static_cast<const ElectricCar*>(manager.getVehicle(id));
+                double kwh = std::min(left, ev->getBatteryCapacity() - ev->getCurrentCharge());
+                manager.chargeBattery(id, kwh);
+                left -= kwh;
+            }
+        });
+        Report("compare", "charging.per_vehicle").param("evs", fleetSize).emit(st, false);
+    }
+    {
+        RentalManager manager(quiet, o);
+        build(manager);
+        ChargingBudget budget;
+        budget.depotKwh = budgetKwh;
+        ChargingSummary summary;
+        Stats st = measure(1, 1, [&](std::size_t) { summary = manager.scheduleCharging(budget); });
+        Report("compare", "charging.scheduled").param("evs", fleetSize).param("charged", summary.charged)
+            .param("made_startable", summary.madeStartable).param("still_below_start", summary.stillBelowStart)
+            .emit(st, false);
+    }
+}
+
+// rent+return round trip by where the fleet lives: in-process manager, a
+// router over LocalPartitionLink (wire encoding only), and a router over
+// loopback TCP to PartitionServers
+void partition() {
+    const int partitions = 4;
+    const int perPartition = 2500;
+    const std::size_t ops = 20000;
+    Logger quiet("", LoggerOptions::disabled());
+    std::vector<std::unique_ptr<RentalManager>> managers;
+    std::vector<std::unique_ptr<PartitionServer>> servers;
+    for (int p = 0; p < partitions; ++p) {
+        managers.push_back(std::make_unique<RentalManager>(quiet, [] {
+            ManagerOptions o = ManagerOptions::concurrentMode(16);
+            o.echoToStdout = false;
+            return o;
+        }()));
+        for (int id = p * perPartition + 1; id <= (p + 1) * perPartition; ++id) {
+            managers.back()->addVehicle(Car(id, "Bench Car", 100.0, 4));
+        }
+        servers.push_back(std::make_unique<PartitionServer>(*managers.back()));
+    }
+    auto cycle = [&](auto &target) {
+        Lcg rng(5);
+        return measure(ops, 64, [&](std::size_t) {
+            int id = 1 + static_cast<int>(rng.next() % (partitions * perPartition));
+            target.tryRentVehicle("bench", id, 1);
+            target.tryReturnVehicle("bench", id, 1, false);
+        });
+    };
+    {
+        RentalManager single(quiet, quietManager());
+        for (int id = 1; id <= partitions * perPartition; ++id) single.addVehicle(Car(id, "Bench Car", 100.0, 4));
+        Stats st = cycle(single);
+        Report("compare", "partition.single_manager").param("fleet", partitions * perPartition).emit(st);
+    }
+    {
+        PartitionRouter router;
+        for (int p = 0; p < partitions; ++p) {
+            router.addPartition(p * perPartition + 1, (p + 1) * perPartition,
+                                std::make_unique<LocalPartitionLink>(*servers[p]));
+        }
+        Stats st = cycle(router);
+        Report("compare", "partition.local_link").param("partitions", partitions).emit(st);
+    }
+#ifndef _WIN32
+    {
+        PartitionRouter router;
+        for (int p = 0; p < partitions; ++p) {
+            std::uint16_t port = servers[p]->listen(0);
+            router.addPartition(p * perPartition + 1, (p + 1) * perPartition,
+                                std::make_unique<SocketPartitionLink>("127.0.0.1", port));
+        }
+        Stats st = cycle(router);
+        Report("compare", "partition.tcp_link").param("partitions", partitions).emit(st);
+    }
+#endif
+}
+
+// scenario replay throughput: parse + execute of a generated rent/return trace
+void replay() {
+    const int fleetSize = 10000;
+    const int rounds = 20;
+    std::string script;
+    for (int id = 1; id <= fleetSize; ++id) {
+        script += "AddVehicle: Car, id=" + std::to_string(id) + ", name=\"Replay Car\", rate=100, capacity=4\n";
+    }
+    for (int r = 0; r < rounds; ++r) {
+        for (int id = 1; id <= fleetSize; ++id) {
+            const std::string vid = std::to_string(id);
+            script += "RentVehicle: id=" + vid + ", member=\"m" + std::to_string(id % 97) + "\", days=2, expect=Ok, cost=200\n";
+            script += "RentVehicle: id=" + vid + ", member=\"other\", days=1, expect=VehicleNotAvailable\n";
+            script += "ReturnVehicle: id=" + vid + ", actualDays=2, damaged=false, expect=Ok\n";
+        }
+        script += "AdvanceClock: hours=1\n";
+    }
+    std::uint64_t commands = 0, failures = 0;
+    Stats st = measure(5, 1, [&](std::size_t) {
+        std::istringstream in(script);
+        ScenarioReport report = replayScenario(in, "bench");
+        commands = report.commands;
+        failures += report.failures + report.parseErrors;
+    });
+    st.ops *= commands;
+    Report("macro", "replay.stream").param("commands", commands).param("failures", failures).emit(st, false);
+}
+
+// metrics overhead on a rent/return cycle: timing every call vs the default
+// sampling, plus the cost of one snapshot (build with -DRENTAL_NO_METRICS
+// for the instrumentation-free baseline)
+void metricsOverhead() {
+    Logger quiet("", LoggerOptions::disabled());
+    const int fleetSize = 100000;
+    const std::size_t iters = 500000;
+    for (std::uint32_t every : {1u, ManagerOptions().latencySampleEvery}) {
+        SimulatedClock clock;
+        ManagerOptions o = quietManager(&clock);
+        o.latencySampleEvery = every;
+        RentalManager manager(quiet, o);
+        for (int id = 1; id <= fleetSize; ++id) manager.addVehicle(Car(id, "Metrics Car", 100.0, 4));
+        const std::string member = "member42";
+        Lcg rng(31);
+        auto cycle = [&](std::size_t) {
+            int id = static_cast<int>(rng.next() % fleetSize) + 1;
+            manager.tryRentVehicle(member, id, 2);
+            manager.tryReturnVehicle(member, id, 2, false);
+        };
+        measure(fleetSize, 256, cycle);
+        Stats st = measure(iters, 256, cycle);
+        Report("compare", every == 1 ? "metrics.time_every_call" : "metrics.sampled")
+            .param("sample_every", every).emit(st);
+        if (every != 1) {
+            Stats snap = measure(200, 1, [&](std::size_t) { sink = sink + manager.metricsSnapshot().count(RentalOp::Rent, RentalStatus::Ok); });
+            Report("compare", "metrics.snapshot").param("fleet", fleetSize).emit(snap);
+        }
+    }
+}
+
+// tracing overhead on a rent/return cycle: no tracer vs a paused one vs
+// the default sampling vs tracing every call, plus one Chrome trace export.
+// The traced modes share one manager (setSampleEvery between runs), all
+// modes take turns over several rounds and each keeps its best round, since
+// the differences of interest are below run-to-run noise.
+void tracing() {
+    Logger quiet("", LoggerOptions::disabled());
+    const int fleetSize = 100000;
+    const std::size_t iters = 200000;
+    const int rounds = 5;
+    SimulatedClock clock;
+    Tracer tracer(0);
+    RentalManager plain(quiet, quietManager(&clock));
+    ManagerOptions o = quietManager(&clock);
+    o.tracer = &tracer;
+    RentalManager traced(quiet, o);
+    for (int id = 1; id <= fleetSize; ++id) {
+        plain.addVehicle(Car(id, "Traced Car", 100.0, 4));
+        traced.addVehicle(Car(id, "Traced Car", 100.0, 4));
+    }
+    struct Mode {
+        const char *name;
+        RentalManager *manager;
+        std::uint32_t every;
+        Stats best;
+    };
+    std::vector<Mode> modes;
+    modes.push_back(Mode{"trace.off", &plain, 0, Stats()});
+    modes.push_back(Mode{"trace.paused", &traced, 0, Stats()});
+    modes.push_back(Mode{"trace.sampled", &traced, Tracer::kDefaultSampleEvery, Stats()});
+    modes.push_back(Mode{"trace.every_call", &traced, 1, Stats()});
+    const std::string member = "member42";
+    Lcg rng(31);
+    for (int round = 0; round <= rounds; ++round) {
+        for (Mode &mode : modes) {
+            tracer.setSampleEvery(mode.every);
+            Stats st = measure(iters, 256, [&](std::size_t) {
+                int id = static_cast<int>(rng.next() % fleetSize) + 1;
+                mode.manager->tryRentVehicle(member, id, 2);
+                mode.manager->tryReturnVehicle(member, id, 2, false);
+            });
+            // round 0 warms up
+            if (round > 0 && (mode.best.ops == 0 || st.seconds < mode.best.seconds)) mode.best = std::move(st);
+        }
+    }
+    const double baseline = modes[0].best.seconds;
+    for (Mode &mode : modes) {
+        Report("compare", mode.name).param("sample_every", mode.every)
+            .param("overhead_pct", 100.0 * (mode.best.seconds - baseline) / baseline).emit(mode.best);
+    }
+    CountingBuf counter;
+    std::ostream out(&counter);
+    Stats dump = measure(1, 1, [&](std::size_t) { tracer.writeChromeTrace(out); });
+    Report("compare", "trace.export_chrome_json").param("spans", tracer.collect().size())
+        .param("bytes", counter.bytes).emit(dump, false);
+}
+
+// `./rental bench [all|micro|macro|compare|<name>] [max_fleet=N] [macro_ops=N]`
+int run(const std::vector<std::string> &args) {
+    std::string name = "all";
+    Options opts;
+    for (const std::string &arg : args) {
+        std::size_t eq = arg.find('=');
+        if (eq == std::string::npos) {
+            name = arg;
+            continue;
+        }
+        std::string key = arg.substr(0, eq);
+        auto value = static_cast<std::size_t>(std::atof(arg.c_str() + eq + 1));
+        if (key == "max_fleet") opts.maxFleet = value;
+        else if (key == "macro_ops") opts.macroOps = value;
+        else {
+            std::cerr << "Unknown bench option: " << key << std::endl;
+            return 1;
+        }
+    }
+
+    bool all = name == "all";
+    bool compare = all || name == "compare";
+    bool ran = false;
+    if (all || name == "micro") { micro(); ran = true; }
+    if (all || name == "macro") { macro(opts); ran = true; }
+    if (all || name == "replay") { replay(); ran = true; }
+    if (compare || name == "lookup") { lookup(); ran = true; }
+    if (compare || name == "logger") { logger(); ran = true; }
+    if (compare || name == "concurrency") { concurrency(); ran = true; }
+    if (compare || name == "dispatch") { dispatch(); ran = true; }
+    if (compare || name == "scan") { scan(); ran = true; }
+    if (compare || name == "batch") { batch(); ran = true; }
+    if (compare || name == "rejects") { rejects(); ran = true; }
+    if (compare || name == "snapshot") { snapshot(opts); ran = true; }
+    if (compare || name == "journal") { journal(); ran = true; }
+    if (compare || name == "rent_any") { rentAny(); ran = true; }
+    if (compare || name == "bulk_pricing") { bulkPricing(); ran = true; }
+    if (compare || name == "list_fleet") { listFleet(); ran = true; }
+    if (compare || name == "metrics") { metricsOverhead(); ran = true; }
+    if (compare || name == "charging") { charging(); ran = true; }
+    if (compare || name == "actor") { actor(); ran = true; }
+    if (compare || name == "partition") { partition(); ran = true; }
+    if (compare || name == "tariff") { tariff(); ran = true; }
+    if (compare || name == "totals") { totals(); ran = true; }
+    if (compare || name == "binary_log") { binaryLog(); ran = true; }
+    if (compare || name == "reservations") { reservations(); ran = true; }
+    if (compare || name == "wait_ready") { waitReady(); ran = true; }
+    if (compare || name == "import_fleet") { importFleet(opts); ran = true; }
+    if (compare || name == "trace") { tracing(); ran = true; }
+    if (!ran) {
+        std::cerr << "Unknown benchmark: " << name << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+} // namespace bench
+
+int main(int argc, char **argv) {
+    if (argc > 1 && std::string(argv[1]) == "bench") {
+        return bench::run(std::vector<std::string>(argv + 2, argv + argc));
+    }
+    if (argc > 1 && std::string(argv[1]) == "simulate") {
+        return runSimulation(std::vector<std::string>(argv + 2, argv + argc));
+    }
+    if (argc > 1 && std::string(argv[1]) == "replay") {
+        return runReplay(std::vector<std::string>(argv + 2, argv + argc));
+    }
+    if (argc > 1 && std::string(argv[1]) == "partition") {
+        return runPartition(std::vector<std::string>(argv + 2, argv + argc));
+    }
+    if (argc > 1 && std::string(argv[1]) == "decode-log") {
+        return runDecodeLog(std::vector<std::string>(argv + 2, argv + argc));
+    }
+    if (argc > 1 && std::string(argv[1]) == "import-fleet") {
+        return runImportFleet(std::vector<std::string>(argv + 2, argv + argc));
+    }
+
+    try {
+        // simulated clock (starting now) so the late return below needs no sleep
+        SimulatedClock clock(std::chrono::system_clock::now());
+
+        // async logger: rent/return only enqueue, the writer thread does the file I/O
+        LoggerOptions logOpts = LoggerOptions::asyncMode();
+        logOpts.clock = &clock;
+        Logger logger("rental_log.txt", logOpts);
+        ManagerOptions managerOpts;
+        managerOpts.clock = &clock;
+        RentalManager manager(logger, managerOpts);
 
         // 1. Tambah 3 kendaraan (Car, Truck, ElectricCar).
         Car c1(1, "Toyota Avanza", 200.0, 7);
@@ -427,12 +9088,8 @@ int main() {
         std::cout << "\n--- Test case 4: Sewa Car normal, kembalikan terlambat 2 hari -> penalti dihitung ---\n";
         try {
             manager.rentVehicle("memberC", 1, 1); // rent Car id=1 for 1 day
-            // eSimulate time: we cannot modify system clock; instead we'll directly manipulate dueDate for test.
-            // For the purpose of this demo, we will hack activeRentals by reusing returnVehicle after waiting.
-            // In real unit test you'd inject clock or mock chrono. Here we simply sleep is not practical.
-            // So we'll simulate late by computing actualDays and assume dueDate passed when returning.
-            // Wait 1 second then return with actualDays=3 to simulate 2 days lat
-            std::this_thread::sleep_for(std::chrono::seconds(1));
+            // fast-forward the simulated clock 3 days, past the 1-day due date
+            clock.advanceDays(3);
             manager.returnVehicle("memberC", 1, 3, false); // actualDays=3 -> was 1 -> late 2 days -> penalty
         } catch (const std::exception &ex) {
             std::cout << "Exception: " << ex.what() << std::endl;